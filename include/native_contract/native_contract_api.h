@@ -3,22 +3,90 @@
 #include <set>
 #include <cstdint>
 #include <memory>
+#include <vector>
+#include <algorithm>
 #include <cborcpp/cbor.h>
 
 namespace uvm {
 	namespace contract {
+
+		// whether the whole string is a number(as strtod parses it)
+		bool is_numeric_string(const std::string& number);
+		// whether the whole string is a number without '.'
+		bool is_integral_string(const std::string& number);
+
+		/**
+		 * arguments of a native contract api call, in typed form(cbor array decoded by the chain)
+		 * or in string form("arg1,arg2,...", the old format, still accepted)
+		 */
+		class native_contract_args {
+		public:
+			explicit native_contract_args(const std::string& api_arg);
+			explicit native_contract_args(const cbor::CborArrayValue& values);
+
+			bool is_typed() const { return _typed; }
+			size_t size() const;
+			// trimmed argument in string form, integers in decimal
+			// @throws uvm::core::UvmException
+			std::string string_at(size_t index) const;
+			// @return false if the argument is not an integer
+			// @throws std::exception when a string form integer out of range
+			bool int_at(size_t index, int64_t& value) const;
+			// "arg1,arg2,..." for the apis taking a string arg
+			std::string to_string_arg() const;
+
+		private:
+			bool _typed;
+			std::string _raw;
+			std::vector<std::string> _parsed;
+			cbor::CborArrayValue _values;
+		};
+
+		// item of the static api table of a native contract class.
+		// apis parsing their args as a list set args_method, the others take the raw string arg
+		template <typename ContractType>
+		struct native_contract_api_entry {
+			const char* name;
+			void (ContractType::*method)(const std::string& api_name, const std::string& api_arg);
+			void (ContractType::*args_method)(const std::string& api_name, const native_contract_args& args);
+		};
+
+		template <typename ContractType>
+		void call_native_contract_api(ContractType* contract, const native_contract_api_entry<ContractType>& api, const std::string& api_name, const native_contract_args& args) {
+			if (api.args_method)
+				(contract->*(api.args_method))(api_name, args);
+			else
+				(contract->*(api.method))(api_name, args.to_string_arg());
+		}
+
+		// binary search in an api table sorted by name, no allocation. return nullptr if not found
+		template <typename ContractType, size_t N>
+		const native_contract_api_entry<ContractType>* find_native_contract_api(const native_contract_api_entry<ContractType>(&api_table)[N], const std::string& api_name) {
+			auto it = std::lower_bound(api_table, api_table + N, api_name, [](const native_contract_api_entry<ContractType>& entry, const std::string& name) {
+				return name.compare(entry.name) > 0;
+			});
+			if (it != api_table + N && api_name.compare(it->name) == 0)
+				return it;
+			return nullptr;
+		}
 		class native_contract_interface
 		{
 		public:
 			// unique key to identify native contract
 			virtual std::string contract_key() const = 0;
 
-			virtual std::set<std::string> apis() const = 0;
-			virtual std::set<std::string> offline_apis() const = 0;
-			virtual std::set<std::string> events() const = 0;
+			// static sets of the contract class
+			virtual const std::set<std::string>& apis() const = 0;
+			virtual const std::set<std::string>& offline_apis() const = 0;
+			virtual const std::set<std::string>& events() const = 0;
 
 			// @throw std::exception
 			virtual void invoke(const std::string& api_name, const std::string& api_arg) = 0;
+			// call with typed args, contracts without typed apis get the args in string form
+			// @throw std::exception
+			virtual void invoke_with_args(const std::string& api_name, const native_contract_args& args) {
+				invoke(api_name, args.to_string_arg());
+			}
 
 			virtual uint64_t gas_count_for_api_invoke(const std::string& api_name) const = 0;
 
@@ -51,11 +51,12 @@ namespace uvm {
 			virtual std::shared_ptr<uvm::contract::native_contract_interface> get_proxy() const { return _proxy; }
 
 			virtual std::string contract_key() const;
-			virtual std::set<std::string> apis() const;
-			virtual std::set<std::string> offline_apis() const;
-			virtual std::set<std::string> events() const;
+			virtual const std::set<std::string>& apis() const;
+			virtual const std::set<std::string>& offline_apis() const;
+			virtual const std::set<std::string>& events() const;
 
 			virtual void invoke(const std::string& api_name, const std::string& api_arg);
+			virtual void invoke_with_args(const std::string& api_name, const native_contract_args& args);
 			std::string check_admin();
 			std::string get_storage_state();
 
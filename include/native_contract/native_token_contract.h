@@ -19,11 +19,12 @@ namespace uvm {
 			virtual std::shared_ptr<uvm::contract::native_contract_interface> get_proxy() const { return _proxy; }
 
 			virtual std::string contract_key() const;
-			virtual std::set<std::string> apis() const;
-			virtual std::set<std::string> offline_apis() const;
-			virtual std::set<std::string> events() const;
+			virtual const std::set<std::string>& apis() const;
+			virtual const std::set<std::string>& offline_apis() const;
+			virtual const std::set<std::string>& events() const;
 
 			virtual void invoke(const std::string& api_name, const std::string& api_arg);
+			virtual void invoke_with_args(const std::string& api_name, const native_contract_args& args);
 			std::string check_admin();
 			std::string get_storage_state();
 			std::string get_storage_token_name();
@@ -36,8 +37,13 @@ namespace uvm {
 
 			void init_api(const std::string& api_name, const std::string& api_arg);
 			void init_token_api(const std::string& api_name, const std::string& api_arg);
-			void transfer_api(const std::string& api_name, const std::string& api_arg);
+			void transfer_api(const std::string& api_name, const native_contract_args& args);
+			// transfers to many users, each balance read and written once
+			// arg format : toAddress1,amount1,toAddress2,amount2,...
+			void transfer_batch_api(const std::string& api_name, const native_contract_args& args);
 			void balance_of_api(const std::string& api_name, const std::string& api_arg);
+			// arg format : ownerAddress1,ownerAddress2,...  result is a json object of owner => balance
+			void balances_of_api(const std::string& api_name, const native_contract_args& args);
 			void state_api(const std::string& api_name, const std::string& api_arg);
 			void token_name_api(const std::string& api_name, const std::string& api_arg);
 			void token_symbol_api(const std::string& api_name, const std::string& api_arg);
@@ -46,13 +52,13 @@ namespace uvm {
 			void precision_api(const std::string& api_name, const std::string& api_arg);
 			// ȨһûԴԼ
 			// arg format : spenderAddress, amount(with precision)
-			void approve_api(const std::string& api_name, const std::string& api_arg);
+			void approve_api(const std::string& api_name, const native_contract_args& args);
 			// spenderûȨȨĽзת
 			// arg format : fromAddress, toAddress, amount(with precision)
-			void transfer_from_api(const std::string& api_name, const std::string& api_arg);
+			void transfer_from_api(const std::string& api_name, const native_contract_args& args);
 			// ѯһûĳûȨĽ
 			// arg format : spenderAddress, authorizerAddress
-			void approved_balance_from_api(const std::string& api_name, const std::string& api_arg);
+			void approved_balance_from_api(const std::string& api_name, const native_contract_args& args);
 			// ѯûȨ˵н
 			// arg format : fromAddress
 			void all_approved_from_user_api(const std::string& api_name, const std::string& api_arg);
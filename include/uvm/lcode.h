@@ -82,6 +82,7 @@ LUAI_FUNC void luaK_infix(FuncState *fs, BinOpr op, expdesc *v);
 LUAI_FUNC void luaK_posfix(FuncState *fs, BinOpr op, expdesc *v1,
     expdesc *v2, int line);
 LUAI_FUNC void luaK_setlist(FuncState *fs, int base, int nelems, int tostore);
+LUAI_FUNC void luaK_fuseops(uvm_types::GcProto *p);
 
 
 #endif
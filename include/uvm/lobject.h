@@ -342,6 +342,25 @@ typedef struct LocVar {
 } LocVar;
 
 
+/*
+** Straight-line run of instructions charged at once by gas metering
+** (indexed by the pc of its first instruction)
+*/
+typedef struct GasBlock {
+    int length;  /* instruction slots in the block, 0 if pc is not a block leader */
+    int cost;    /* instructions actually executed (EXTRAARG operands are not) */
+} GasBlock;
+
+
+/*
+** Inline cache of a table access with a constant string key (one per instruction)
+*/
+typedef struct InlineCache {
+    uint64_t shape;  /* shape of the table the slot belongs to (0: empty) */
+    const TValue *slot;  /* value of the key in that table */
+} InlineCache;
+
+
 
 /*
 ** Lua Upvalues
@@ -480,6 +499,7 @@ namespace uvm_types {
 		GcTable* metatable;
 		lu_byte flags; // flag to mask meta methods
 		bool isOnlyRead = false; 
+		uint64_t shape = 0; // unique id of the keys layout, changed when keys are added (see InlineCache)
 		inline GcTable() : metatable(nullptr), flags(0) { }
 		virtual ~GcTable() {}
 	};
@@ -492,6 +512,7 @@ namespace uvm_types {
 		lu_byte numparams;  /* number of fixed parameters */
 		lu_byte is_vararg;  /* 2: declared vararg; 1: uses vararg */
 		lu_byte maxstacksize;  /* number of registers needed by this function */
+		lu_byte verified;  /* 1 if the code passed the load time verifier (see lundump) */
 		int linedefined;  /* debug information  */
 		int lastlinedefined;  /* debug information  */
 		std::vector<TValue> ks;  /* constants used by the function */
@@ -500,11 +521,17 @@ namespace uvm_types {
 		std::vector<int> lineinfos;  /* map from opcodes to source lines (debug information) */
 		std::vector<LocVar> locvars;  /* information about local variables (debug information) */
 		std::vector<Upvaldesc> upvalues;  /* upvalue information */
+		std::vector<GasBlock> gasblocks;  /* basic blocks for gas metering (empty: meter per instruction) */
+		std::vector<lu_byte> fusedops;  /* FusedOp of each pc with the next instruction (empty: none) */
+		std::vector<InlineCache> icaches;  /* inline cache of each pc (empty: not cached) */
+		std::vector<bool> breakpointpcs;  /* whether each pc is on a breakpoint line (empty: no breakpoint) */
+		uint64_t breakpointsversion;  /* lua_State breakpoints_version breakpointpcs was built for (0: not built) */
+		std::string breakpointscontract;  /* contract address breakpointpcs was built for */
 		struct GcLClosure *cache;  /* last-created closure with this prototype */
 		GcString  *source;  /* used for debug information */
 
-		inline GcProto() : numparams(0), is_vararg(0), maxstacksize(0), linedefined(0)
-			, cache(nullptr), source(nullptr)
+		inline GcProto() : numparams(0), is_vararg(0), maxstacksize(0), verified(0), linedefined(0)
+			, breakpointsversion(0), cache(nullptr), source(nullptr)
 		{ }
 		virtual ~GcProto() {}
 	};
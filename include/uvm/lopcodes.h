@@ -307,4 +307,13 @@ LUAI_DDEC const char *const luaP_opnames[UNUM_OPCODES + 1];  /* opcode names */
 #define LFIELDS_PER_FLUSH	50
 
 
+/*
+** instruction pairs the interpreter may run in a single step (see luaK_fuseops)
+*/
+typedef enum {
+    UFUSE_NONE = 0,
+    UFUSE_GETTABLE  /* next instruction is a GETTABLE indexing the result of this one */
+} FusedOp;
+
+
 #endif
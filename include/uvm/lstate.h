@@ -26,6 +26,15 @@
 #include "uvm/lopcodes.h"
 #include <uvm/uvm_libprefix.h>
 
+namespace uvm {
+	namespace lua {
+		namespace lib {
+			class UvmProfiler;
+			class GasLedger;
+		}
+	}
+}
+
 #define LUA_MALLOC_TOTAL_SIZE	(500*1024*1024)
 
 #define LUA_COMPILE_ERROR_MAX_LENGTH 4096
@@ -57,6 +66,9 @@ struct lua_longjmp;  /* defined in ldo.c */
 
 #define BASIC_STACK_SIZE        (2*LUA_MINSTACK)
 
+/* number of CallInfo structures allocated together by 'luaE_extendCI' */
+#define CI_SLAB_SIZE	32
+
 
 /* kinds of Garbage Collection */
 #define KGC_NORMAL	0
@@ -93,6 +105,15 @@ typedef struct CallInfo {
 } CallInfo;
 
 
+/*
+** CallInfo structures allocated together by 'luaE_extendCI'
+*/
+typedef struct CallInfoSlab {
+    struct CallInfoSlab *next;  /* other slabs of the same thread */
+    CallInfo cis[CI_SLAB_SIZE];
+} CallInfoSlab;
+
+
 /*
 ** Bits in CallInfo status
 */
@@ -150,6 +171,16 @@ typedef enum lua_VMState {
 	LVM_STATE_SUSPEND = 1 << 3
 } lua_VMState;
 
+/*
+** basic block whose gas was charged in advance by the interpreter
+*/
+typedef struct GasBlockCharge {
+	CallInfo *ci;  /* frame running the block (nullptr if no block is pending) */
+	const Instruction *begin;  /* block leader */
+	const Instruction *end;  /* one past the last instruction of the block */
+	int64_t *counter;  /* instructions counter the block was charged to */
+} GasBlockCharge;
+
 struct contract_info_stack_entry {
 	std::string contract_id;
 	std::string storage_contract_id; // storageʹõĺԼַ(ܴõĲͬһԼģΪdelegate_callĴ)
@@ -175,6 +206,8 @@ struct lua_State : vmgc::GcObject {
     struct lua_State *twups;  /* list of threads with open upvalues */
     struct lua_longjmp *errorJmp;  /* current error recover point */
     CallInfo base_ci;  /* CallInfo for first level (C calling Lua) */
+    CallInfo *freeci;  /* unused CallInfo structures of the slabs, linked by 'next' */
+    CallInfoSlab *cislabs;  /* slabs allocated for this thread */
     lua_Hook hook;
     ptrdiff_t errfunc;  /* current error handling function (stack index) */
     int stacksize;
@@ -216,10 +249,18 @@ struct lua_State : vmgc::GcObject {
 	lua_VMState state;
 	bool allow_debug;
 	std::map<std::string, std::list<uint32_t> >* breakpoints; // contract_address => list of line_number
+	uint64_t breakpoints_version; // increase it after changing breakpoints, so protos rebuild their breakpoint pcs
+	uvm::lua::lib::UvmProfiler* profiler; // nullptr when not profiling
+	uvm::lua::lib::GasLedger* gas_ledger; // nullptr when gas is not attributed
+	void *buffbox; // storage of a finished luaL_Buffer, reused by the next one until the running C function returns
+	size_t buffbox_size;
 	std::stack<contract_info_stack_entry>* using_contract_id_stack;
 	bool next_delegate_call_flag = false;
 	OpCode call_op_msg;
 	uint32_t ci_depth;
+	GasBlockCharge gas_block;
+	int64_t api_instructions_limit; // cached limit for contract api CALL checks, 0: no limit, < 0: ask chain api
+	bool gas_per_instruction; // meter every instruction instead of charging basic blocks, to check both give the same gas
     
 	int cbor_diff_state; // 0: not_set, 1: true, 2: false
 
@@ -269,6 +310,7 @@ LUAI_FUNC void luaE_setdebt(l_mem debt);
 LUAI_FUNC CallInfo *luaE_extendCI(lua_State *L);
 LUAI_FUNC void luaE_freeCI(lua_State *L);
 LUAI_FUNC void luaE_shrinkCI(lua_State *L);
+LUAI_FUNC void luaE_freebuffbox(lua_State *L);
 
 
 #endif
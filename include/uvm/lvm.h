@@ -100,11 +100,18 @@ namespace uvm {
 			int64_t insts_limit;
 			bool has_insts_limit;
 			bool use_last_return;
+			bool use_step_log;
 			CallInfo *ci;
 			uvm_types::GcLClosure *cl;
 			TValue *k;
 			StkId base;
 			std::stack<contract_info_stack_entry> using_contract_id_stack;
+			// breakpoint pcs of the current frame(nullptr: no breakpoint in it), resolved for the proto, contract depth
+			// and breakpoints version below, so the check per instruction doesn't compare contract addresses
+			const std::vector<bool> *breakpointpcs;
+			const uvm_types::GcProto *breakpoints_proto;
+			size_t breakpoints_contract_depth;
+			uint64_t breakpoints_version;
 
 			void step_out(lua_State *L);
 			void step_into(lua_State* L);
@@ -113,7 +120,14 @@ namespace uvm {
 			bool executeToNextCi(lua_State* L);
 			bool executeToNextOp(lua_State* L);
 			void enter_newframe(lua_State* L);
+			// look up the lua_State values used by all frames, once per luaV_execute invocation
+			void prepare_execute(lua_State* L);
 			void prepare_newframe(lua_State* L);
+			// find the breakpoint pcs of the current frame's contract, building them if stale
+			void resolve_breakpoints(lua_State* L);
+			// charge the basic block led by pc at once, return whether pc is already paid for
+			bool charge_gas_block(lua_State* L, const Instruction *pc);
+			bool check_contract_api_instructions_over_limit(lua_State* L);
 
 			void go_resume(lua_State* L);
 
@@ -145,6 +159,9 @@ LUAI_FUNC lua_Integer luaV_div(lua_State *L, lua_Integer x, lua_Integer y);
 LUAI_FUNC lua_Integer luaV_mod(lua_State *L, lua_Integer x, lua_Integer y);
 LUAI_FUNC lua_Integer luaV_shiftl(lua_Integer x, lua_Integer y);
 LUAI_FUNC void luaV_objlen(lua_State *L, StkId ra, const TValue *rb);
+LUAI_FUNC void luaV_buildgasblocks(uvm_types::GcProto *p);
+LUAI_FUNC void luaV_buildbreakpoints(lua_State *L, uvm_types::GcProto *p, const std::string &contract_address);
+LUAI_FUNC void luaV_refundgasblock(lua_State *L);
 
 LUAI_FUNC int luaV_strcmp(const uvm_types::GcString *ls, const uvm_types::GcString *rs);
 
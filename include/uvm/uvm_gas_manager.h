@@ -1,5 +1,7 @@
 #pragma once
 #include <stdint.h>
+#include <map>
+#include <string>
 
 struct lua_State;
 
@@ -22,6 +24,27 @@ namespace uvm
 				int64_t* gas_ref_or_new();
 			};
 
+			/**
+			 * gas charged by chain apis and libs besides the executed instructions, by category and subcategory,
+			 * eg. storage => fast_map_get, json => json.loads, crypto => signature_recover.
+			 * attached to a lua_State by UvmStateScope::set_gas_ledger, it only records, the gas is still charged as before
+			 */
+			class GasLedger
+			{
+			public:
+				typedef std::map<std::string, std::map<std::string, int64_t> > entries_type;
+			private:
+				entries_type _entries;
+				int64_t _total;
+			public:
+				GasLedger();
+				void add(const std::string& category, const std::string& subcategory, int64_t gas);
+				const entries_type& entries() const;
+				// gas of all entries
+				int64_t total() const;
+				void clear();
+			};
+
         }
     }
 }
@@ -95,6 +95,19 @@ namespace uvm
                 void enter_sandbox();
                 void exit_sandbox();
 
+                /************************************************************************/
+                /* attach a profiler to the lua stack(nullptr to detach),
+                   it must be alive while attached                                      */
+                /************************************************************************/
+                void set_profiler(UvmProfiler *profiler);
+                UvmProfiler *profiler() const;
+                /************************************************************************/
+                /* attach a gas ledger to the lua stack(nullptr to detach),
+                   it must be alive while attached                                      */
+                /************************************************************************/
+                void set_gas_ledger(GasLedger *gas_ledger);
+                GasLedger *gas_ledger() const;
+
                 /************************************************************************/
                 /* commit all storage changes happened in the lua stack                 */
                 /************************************************************************/
@@ -129,6 +142,10 @@ namespace uvm
                 /* check whether the uvm apis over limit(maybe uvm limit api called count) */
                 /************************************************************************/
                 int check_uvm_contract_api_instructions_over_limit();
+                /************************************************************************/
+                /* let the vm check the contract apis limit itself(0: no limit, <0: ask chain api) */
+                /************************************************************************/
+                void set_contract_api_instructions_limit(int64_t limit);
 
                 /************************************************************************/
                 /* notify the lua stack to stop                                         */
@@ -214,6 +231,10 @@ namespace uvm
 
             int get_lua_state_instructions_limit(lua_State *L);
 
+            void set_lua_state_api_instructions_limit(lua_State *L, int64_t limit);
+
+            void set_lua_state_gas_per_instruction(lua_State *L, bool gas_per_instruction);
+
             int get_lua_state_instructions_executed_count(lua_State *L);
 
             void enter_lua_sandbox(lua_State *L);
@@ -266,6 +287,10 @@ namespace uvm
 
             // lvmadd_count
             void increment_lvm_instructions_executed_count(lua_State *L, int add_count);
+            // charges the gas of an api called by a CALL instruction, which already counted 1 of api_gas,
+            // and records the whole api_gas to the gas ledger of L(if attached) under category and subcategory + subcategory_suffix.
+            // the names are only turned into strings when a ledger is attached
+            void charge_lvm_api_gas(lua_State *L, int api_gas, const char *category, const char *subcategory, const char *subcategory_suffix = nullptr);
 
             int execute_contract_api(lua_State *L, const char *contract_name, const char *api_name, cbor::CborArrayValue& args, std::string *result_json_string);
 
@@ -49,6 +49,21 @@ namespace uvm
 		*/
 		std::string unescape_string(std::string &str);
 
+		/**
+		* encode size bytes of data to 2*size hex chars at out, lower case(as fc::to_hex) or upper case(as boost::algorithm::hex)
+		*/
+		void hex_encode(const char* data, size_t size, char* out, bool upper_case = false);
+		std::string hex_encode(const char* data, size_t size, bool upper_case = false);
+		std::string hex_encode(const std::string& data, bool upper_case = false);
+
+		/**
+		* decode size hex chars(upper or lower case) to size/2 bytes at out
+		* @return false if size is odd or there are non-hex chars, the content of out is undefined then
+		*/
+		bool hex_decode(const char* hex, size_t size, char* out);
+		bool hex_decode(const std::string& hex, std::string& out);
+		bool hex_decode(const std::string& hex, std::vector<char>& out);
+
 		std::vector<std::string> &string_split(const std::string &s, char delim, std::vector<std::string> &elems);
 
 		std::vector<std::string> string_split(const std::string &s, char delim);
@@ -0,0 +1,116 @@
+#pragma once
+#include <stdint.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct lua_State;
+struct CallInfo;
+namespace uvm_types {
+	struct GcProto;
+}
+
+namespace uvm
+{
+    namespace lua
+    {
+        namespace lib
+        {
+
+			/**
+			 * profiler of the contract execution in a lua_State, attached by UvmStateScope::set_profiler.
+			 * counts executed instructions by opcode, function, source line and call stack, and charges the wall time
+			 * between two instructions to the former one. C function calls are counted and timed inclusively.
+			 * when no profiler is attached, the vm only checks that L->profiler is nullptr
+			 */
+			class UvmProfiler
+			{
+			public:
+				struct Counter
+				{
+					uint64_t count = 0;
+					int64_t time_ns = 0;
+				};
+				struct FunctionStats
+				{
+					Counter total;
+					std::map<int, Counter> lines; // source line => stats
+				};
+				struct CFunctionStats
+				{
+					std::string name;
+					Counter total;
+				};
+
+				UvmProfiler();
+
+				// called by the vm
+				void on_instruction(lua_State* L, CallInfo* ci, uvm_types::GcProto* p, int pc, int opcode);
+				void on_cfunction_enter(lua_State* L, int (*f)(lua_State*));
+				void on_cfunction_leave(lua_State* L);
+				void on_execute_leave(lua_State* L);
+
+				void reset();
+
+				const std::vector<uint64_t>& opcode_counts() const { return _opcode_counts; }
+				const std::map<std::string, FunctionStats>& functions() const { return _functions; }
+				const std::map<int (*)(lua_State*), CFunctionStats>& cfunctions() const { return _cfunctions; }
+
+				/************************************************************************/
+				/* collapsed stacks for flamegraph.pl, one "frame1;frame2 weight" line per stack,
+				   weight is instructions count, or microseconds if by_time */
+				/************************************************************************/
+				std::string to_collapsed_stacks(bool by_time = false) const;
+				/************************************************************************/
+				/* json summary of opcodes, functions, lines, c functions and totals   */
+				/************************************************************************/
+				std::string to_json() const;
+
+			private:
+				typedef std::chrono::steady_clock clock_type;
+				struct CFrame
+				{
+					int (*f)(lua_State*);
+					CallInfo* ci;
+					clock_type::time_point start;
+					int64_t charged_ns_at_start;
+					const std::string* stack_key; // stack of the calling instruction
+					bool has_last;
+					Counter* last_function;
+					Counter* last_line;
+					Counter* last_stack;
+				};
+
+				void charge_elapsed(clock_type::time_point now);
+				void enter_frame(lua_State* L, CallInfo* ci, uvm_types::GcProto* p);
+				std::string frame_name(CallInfo* ci) const;
+				static std::string proto_name(const uvm_types::GcProto* p);
+
+				std::vector<uint64_t> _opcode_counts;
+				uint64_t _instructions_count;
+				int64_t _charged_ns; // total time charged to instructions
+				std::map<std::string, FunctionStats> _functions; // proto name => stats
+				std::map<int (*)(lua_State*), CFunctionStats> _cfunctions;
+				std::unordered_map<std::string, Counter> _stacks; // collapsed stack => stats, C function time is exclusive
+				std::vector<CFrame> _cframes;
+
+				// the frame of the last instruction, rebuilt when the running frame changes
+				CallInfo* _ci;
+				uvm_types::GcProto* _proto;
+				FunctionStats* _function;
+				const std::string* _stack_key;
+				Counter* _stack;
+
+				// the last instruction, the time until the next instruction is charged to it
+				bool _has_last;
+				clock_type::time_point _last_time;
+				Counter* _last_function;
+				Counter* _last_line;
+				Counter* _last_stack;
+			};
+
+        }
+    }
+}
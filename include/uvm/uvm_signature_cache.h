@@ -0,0 +1,76 @@
+#pragma once
+#include <stdint.h>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <fc/crypto/elliptic.hpp>
+#include <fc/crypto/sha256.hpp>
+
+namespace uvm
+{
+    namespace lua
+    {
+        namespace lib
+        {
+
+			/**
+			 * process-wide LRU cache of public keys recovered from compact signatures(without canonical check),
+			 * matching engines submit the same signed orders many times.
+			 * invalid recoveries are cached too, recoveries which throw are not.
+			 * callers charge gas before recovering, so gas does not depend on cache hits.
+			 * methods are thread safe
+			 */
+			class SignatureRecoverCache
+			{
+			public:
+				typedef std::pair<fc::ecc::compact_signature, fc::sha256> signature_item;
+
+				explicit SignatureRecoverCache(size_t capacity = 10000);
+
+				static SignatureRecoverCache& instance();
+
+				// same as fc::ecc::public_key(sig, digest, false), check valid() of the result
+				// @throws fc::exception
+				fc::ecc::public_key recover(const fc::ecc::compact_signature& sig, const fc::sha256& digest);
+
+				/************************************************************************/
+				/* recover many signatures in one call, the uncached ones in up to
+				   max_threads threads. results are in the order of items, and invalid
+				   if recovering threw. contract execution keeps the default serial
+				   recovering, so it never depends on the threads of the node         */
+				/************************************************************************/
+				std::vector<fc::ecc::public_key> recover_batch(const std::vector<signature_item>& items, size_t max_threads = 1);
+
+				size_t size() const;
+				uint64_t hits() const;
+				uint64_t misses() const;
+				void clear();
+
+			private:
+				struct entry
+				{
+					bool valid;
+					fc::ecc::public_key_data key;
+				};
+				typedef std::list<std::pair<std::string, entry> > items_type;
+
+				static std::string cache_key(const fc::ecc::compact_signature& sig, const fc::sha256& digest);
+				static entry to_entry(const fc::ecc::public_key& key);
+				static fc::ecc::public_key from_entry(const entry& e);
+				bool find(const std::string& key, entry& e);
+				void put(const std::string& key, const entry& e);
+
+				mutable std::mutex _mutex;
+				size_t _capacity;
+				items_type _items; // most recently used first
+				std::unordered_map<std::string, items_type::iterator> _index;
+				uint64_t _hits;
+				uint64_t _misses;
+			};
+
+        }
+    }
+}
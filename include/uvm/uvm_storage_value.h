@@ -1,5 +1,10 @@
 #pragma once
 
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 
 enum UvmOutsideObjectTypes
 {
@@ -204,9 +209,46 @@ typedef struct UvmStorageChangeItem
 
 
 
-typedef std::list<UvmStorageChangeItem> UvmStorageChangeList;
+/**
+ * storage change items in the order they were logged, indexed by (contract_id, key, fast_map_key, is_fast_map)
+ * so the last change of a storage is found without scanning the whole log
+ */
+class UvmStorageChangeLog
+{
+public:
+    typedef std::list<UvmStorageChangeItem> items_type;
+    typedef items_type::iterator iterator;
+    typedef items_type::const_iterator const_iterator;
+
+    void push_back(const UvmStorageChangeItem& item);
+    void pop_back();
+    void pop_front();
+    void clear();
+    size_t size() const;
+
+    iterator begin() { return _items.begin(); }
+    iterator end() { return _items.end(); }
+    const_iterator begin() const { return _items.begin(); }
+    const_iterator end() const { return _items.end(); }
+
+    // last logged change item of the storage, nullptr if not found
+    const UvmStorageChangeItem* find_last(const std::string& contract_id, const std::string& key,
+        const std::string& fast_map_key, bool is_fast_map) const;
+    // logged change items of the storage in log order, nullptr if not found
+    const std::vector<iterator>* find_all(const std::string& contract_id, const std::string& key,
+        const std::string& fast_map_key, bool is_fast_map) const;
+
+private:
+    static std::string index_key(const std::string& contract_id, const std::string& key,
+        const std::string& fast_map_key, bool is_fast_map);
+
+    items_type _items;
+    std::unordered_map<std::string, std::vector<iterator> > _index; // index_key => items of the storage in log order
+};
+
+typedef UvmStorageChangeLog UvmStorageChangeList;
 
-typedef std::list<UvmStorageChangeItem> UvmStorageTableReadList;
+typedef UvmStorageChangeLog UvmStorageTableReadList;
 
 struct UvmStorageValue lua_type_to_storage_value_type(lua_State* L, int index);
 
@@ -10,6 +10,11 @@
 #include <simplechain/storage.h>
 #include <simplechain/asset.h>
 #include <simplechain/debugger.h>
+#include <simplechain/db.h>
+#include <simplechain/state_layer.h>
+#include <simplechain/persistent_map.h>
+#include <functional>
+#include <deque>
 #include <memory>
 #include <vector>
 #include <map>
@@ -18,28 +23,45 @@
 #include <uvm/lobject.h>
 
 namespace simplechain {
-	typedef int64_t balance_t; //int64
-
 	class blockchain {
-		// TODO: local db and rollback
 	private:
 		std::vector<asset> assets;
-		std::vector<block> blocks;
-		std::map<std::string, transaction_receipt> tx_receipts; // txid => tx_receipt
-		std::map<std::string, std::string> address_pubkeys; // address => pub_key_hex
-		std::map<std::string, std::map<asset_id_t, balance_t> > account_balances;
-		std::map<std::string, contract_object> contracts;
-		std::map<std::string, std::map<std::string, StorageDataType> > contract_storages;
+		// block number => block. only the head block when a state db is opened, the others are read from it
+		persistent_map<uint64_t, block> blocks;
+		uint64_t head_block_num;
+		// committed state when no state db opened, persistent maps so a snapshot shares it
+		persistent_map<std::string, transaction_receipt> tx_receipts; // txid => tx_receipt
+		persistent_map<std::string, std::string> address_pubkeys; // address => pub_key_hex
+		persistent_map<std::pair<std::string, asset_id_t>, balance_t> account_balances;
+		persistent_map<std::string, contract_object> contracts;
+		persistent_map<std::pair<std::string, std::string>, StorageDataType> contract_storages; // (contract address, key) => value
+		std::shared_ptr<state_db> chain_db; // persisted chain state when opened, all of it but the assets is read from it on demand
 		std::vector<transaction> tx_mempool;
+		std::shared_ptr<state_layer> top_state_layer; // writes go to it instead of committed state when not nullptr
+		std::deque<state_undo> block_undos; // undo of each of the last SIMPLECHAIN_MAX_UNDO_BLOCKS blocks
+		std::string record_blocks_path; // generated blocks are appended to it when not empty
 
 		std::map<std::string, std::list<uint32_t> > breakpoints;
 
 		std::shared_ptr<generic_evaluator> last_evaluator_when_debugger;
 		std::shared_ptr<transaction> last_tx_when_debugger;
+
+		struct snapshot_tag {};
+		explicit blockchain(snapshot_tag);
 	public:
 		blockchain();
+		// read-only copy of the committed state(without the mempool and pending state layers), sharing it with
+		// this chain so making it is cheap. it can be read from other threads while this chain goes on
+		std::shared_ptr<blockchain> snapshot() const;
+		// persist the chain state to a state db in dir, changes are committed per block.
+		// the chain goes on from the state committed in dir, which stays on disk and is read on demand
+		// @throws exception when the chain already has blocks or the db isn't consistent with its blocks
+		void open_state_db(const std::string& dir);
 		// @throws exception
 		std::shared_ptr<evaluate_result> evaluate_transaction(std::shared_ptr<transaction> tx);
+		// evaluate without saving debugger state, so it changes nothing in chain and can run concurrently with other reads
+		// @throws exception
+		std::shared_ptr<evaluate_result> evaluate_transaction_offline(std::shared_ptr<transaction> tx);
 		void clear_debugger_info();
 		void apply_transaction(std::shared_ptr<transaction> tx);
 		block latest_block() const;
@@ -99,9 +121,30 @@ namespace simplechain {
 		void accept_transaction_to_mempool(const transaction& tx);
 		std::vector<transaction> get_tx_mempool() const;
 		void generate_block();
+		// generate block with the given block time(eg. replaying recorded blocks)
+		void generate_block(const fc::time_point_sec& block_time);
+		// append each generated block to a recorded blocks file, for replaying later
+		void record_blocks_to(const std::string& path);
+		// revert the state changes of the head block and put its txs back to mempool
+		// @throws exception
+		void undo_head_block();
+
+		// push a child layer of the current state layer, later writes go to it until it's merged or discarded
+		std::shared_ptr<state_layer> push_state_layer();
+		// drop the top state layer and its writes
+		// @throws exception
+		void discard_state_layer();
+		// merge the top state layer to its parent. the bottom layer(a pending block) is committed by generate_block
+		// @throws exception when the top layer is the bottom one
+		void merge_state_layer();
+		// use another layer(eg. a fork of pending block built by push_state_layer) as the top state layer
+		void switch_state_layer(std::shared_ptr<state_layer> layer);
+		std::shared_ptr<state_layer> current_state_layer() const;
 
 		fc::variant get_state() const;
 		std::string get_state_json() const;
+		// hash of balances, contracts, contract storages and tx receipts, to compare chain states of replays
+		std::string get_state_hash() const;
 
 		bool is_break_when_last_evaluate() const;
 		void debugger_go_resume();
@@ -128,5 +171,24 @@ namespace simplechain {
 	private:
 		// @throws exception
 		std::shared_ptr<generic_evaluator> get_operation_evaluator(transaction* tx, const operation& op);
+		// layers from the bottom one to the top one
+		std::vector<const state_layer*> state_layers_from_bottom() const;
+		bool find_committed_storage(const std::string& contract_address, const std::string& key, StorageDataType& value) const;
+		void set_committed_storage(const std::string& contract_address, const std::string& key, const StorageDataType& value);
+		void remove_committed_storage(const std::string& contract_address, const std::string& key);
+		bool find_committed_balance(const std::string& account_address, asset_id_t asset_id, balance_t& balance) const;
+		void set_committed_balance(const std::string& account_address, asset_id_t asset_id, balance_t balance);
+		void remove_committed_balance(const std::string& account_address, asset_id_t asset_id);
+		std::map<std::string, std::map<asset_id_t, balance_t> > get_committed_balances() const;
+		bool find_committed_contract(const std::string& contract_address, contract_object& contract_obj) const;
+		void set_committed_contract(const std::string& contract_address, const contract_object& contract_obj);
+		void remove_committed_contract(const std::string& contract_address);
+		// in address order
+		void for_each_committed_contract(const std::function<void(const std::string&, const contract_object&)>& fn) const;
+		bool find_committed_tx_receipt(const std::string& tx_id, transaction_receipt& tx_receipt) const;
+		void set_committed_tx_receipt(const std::string& tx_id, const transaction_receipt& tx_receipt);
+		void remove_committed_tx_receipt(const std::string& tx_id);
+		// write the layer to committed state, return the undo of it
+		state_undo commit_state_layer(const state_layer& layer);
 	};
 }
@@ -21,6 +21,8 @@ namespace simplechain {
 		struct RpcRequest {
 			std::string method;
 			RpcRequestParams params;
+			bool has_id = false;
+			fc::variant id; // json-rpc request id, returned in response
 		};
 
 		typedef fc::variant RpcResultType;
@@ -52,12 +54,21 @@ namespace simplechain {
 		// invoke_contract(caller_address: string, contract_address: string, api_name: string, api_args: [string], deposit_asset_id: int, deposit_amount: int, gas_limit: int, gas_price: int)
 		RpcResultType invoke_contract(blockchain* chain, HttpServer* server, const RpcRequestParams& params);
 		RpcResultType invoke_contract_offline(blockchain* chain, HttpServer* server, const RpcRequestParams& params);
+		// profile_invoke_contract(caller_address: string, contract_address: string, api_name: string, api_args: [string], deposit_asset_id: int, deposit_amount: int)
+		// invoke contract offline with profiling, returns the result with the profile summary and collapsed stacks for flamegraph
+		RpcResultType profile_invoke_contract(blockchain* chain, HttpServer* server, const RpcRequestParams& params);
 		RpcResultType generate_block(blockchain* chain, HttpServer* server, const RpcRequestParams& params);
+		// undo_block()
+		// revert the head block and put its txs back to mempool, returns the new head block hash
+		RpcResultType undo_block(blockchain* chain, HttpServer* server, const RpcRequestParams& params);
 		RpcResultType get_block_by_height(blockchain* chain, HttpServer* server, const RpcRequestParams& params);
 		RpcResultType get_tx(blockchain* chain, HttpServer* server, const RpcRequestParams& params);
 		RpcResultType get_tx_receipt(blockchain* chain, HttpServer* server, const RpcRequestParams& params);
 		RpcResultType exit_chain(blockchain* chain, HttpServer* server, const RpcRequestParams& params);
 		RpcResultType get_chain_state(blockchain* chain, HttpServer* server, const RpcRequestParams& params);
+		// get_signature_cache_stats()
+		// entries count, hits and misses of the process-wide signature recover cache
+		RpcResultType get_signature_cache_stats(blockchain* chain, HttpServer* server, const RpcRequestParams& params);
 		RpcResultType list_accounts(blockchain* chain, HttpServer* server, const RpcRequestParams& params);
 		RpcResultType list_assets(blockchain* chain, HttpServer* server, const RpcRequestParams& params);
 		RpcResultType list_contracts(blockchain* chain, HttpServer* server, const RpcRequestParams& params);
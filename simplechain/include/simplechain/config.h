@@ -17,5 +17,8 @@
 #define SIMPLECHAIN_CORE_ASSET_SYMBOL "COIN"
 #define SIMPLECHAIN_CORE_ASSET_PRECISION 5
 
+// how many of the last blocks can be undone, older undos are dropped
+#define SIMPLECHAIN_MAX_UNDO_BLOCKS 100
+
 #define SIMPLECHAIN_CONTRACT_ADDRESS_PREFIX "CON"
 #define SIMPLECHAIN_ADDRESS_PREFIX "SPL"
@@ -7,12 +7,15 @@
 #include <simplechain/asset.h>
 #include <fc/variant.hpp>
 #include <fc/variant_object.hpp>
+#include <unordered_map>
 
 namespace simplechain {
 
 	typedef std::string contract_address_type;
 	typedef std::string address;
 	typedef int64_t amount_change_type;
+	// gas by category => subcategory => gas, eg. storage => "write <contract>"
+	typedef std::map<std::string, std::map<std::string, int64_t> > gas_ledger_type;
 
 	struct contract_event_notify_info
 	{
@@ -55,13 +58,21 @@ namespace simplechain {
 		}
 	};
 
+	struct hash_for_contract_invoke_result_balance_change {
+		size_t operator() (const std::pair<address, asset_id_t>& x) const
+		{
+			return std::hash<std::string>()(x.first) * 31 + std::hash<asset_id_t>()(x.second);
+		}
+	};
+
 	class blockchain;
 
 	struct contract_invoke_result : public evaluate_result
 	{
 		std::string api_result;
-		std::map<std::string, contract_storage_changes_type, std::less<std::string>> storage_changes;
-		std::map<std::pair<address, asset_id_t>, amount_change_type, comparator_for_contract_invoke_result_balance_change> account_balances_changes;
+		// accumulated by hash during execution, ordered only when applied
+		std::unordered_map<std::string, contract_storage_changes_type> storage_changes;
+		std::unordered_map<std::pair<address, asset_id_t>, amount_change_type, hash_for_contract_invoke_result_balance_change> account_balances_changes;
 
 
 		std::map<asset_id_t, share_type, std::less<asset_id_t>> transfer_fees;
@@ -70,6 +81,7 @@ namespace simplechain {
 		bool exec_succeed = true;
 		std::string error;
 		gas_count_type gas_used = 0;
+		gas_ledger_type gas_ledger; // attribution of gas_used, not part of the consensus
 		address invoker;
 		void reset();
 		void set_failed();
@@ -79,6 +91,9 @@ namespace simplechain {
 
 		void apply_pendings(blockchain* chain, const std::string& tx_id);
 
+		// balance changes in (address, asset) order
+		std::map<std::pair<address, asset_id_t>, amount_change_type, comparator_for_contract_invoke_result_balance_change> ordered_account_balances_changes() const;
+
 		// count storage gas and events gas
 		int64_t count_storage_gas() const;
 		int64_t count_event_gas() const;
@@ -86,10 +101,15 @@ namespace simplechain {
 
 
 
+	fc::mutable_variant_object gas_ledger_to_json(const gas_ledger_type& gas_ledger);
+
 	struct transaction_receipt {
 		std::string tx_id;
 		std::vector<contract_event_notify_info> events;
 		bool exec_succeed = false;
+		// gas of the contract operations in the tx and its attribution
+		gas_count_type gas_used = 0;
+		gas_ledger_type gas_ledger;
 
 		fc::mutable_variant_object to_json() const;
 	};
@@ -3,10 +3,33 @@
 #include <simplechain/contract.h>
 #include <simplechain/evaluate_state.h>
 #include <simplechain/contract_engine.h>
+#include <uvm/uvm_profiler.h>
 
 namespace simplechain {
 	std::shared_ptr<ContractEngine> get_last_contract_engine_for_debugger();
 
+	// contracts executed by the evaluators in this thread are profiled by the profiler while the scope is alive
+	class contract_profiler_scope {
+	public:
+		explicit contract_profiler_scope(uvm::lua::lib::UvmProfiler* profiler);
+		~contract_profiler_scope();
+		// the profiler of this thread, or nullptr
+		static uvm::lua::lib::UvmProfiler* current();
+	private:
+		uvm::lua::lib::UvmProfiler* _previous;
+	};
+
+	// contracts executed by the evaluators in this thread while the scope is alive are evaluated offline,
+	// they don't stop at breakpoints nor replace the debugger session
+	class offline_evaluate_scope {
+	public:
+		offline_evaluate_scope();
+		~offline_evaluate_scope();
+		static bool current();
+	private:
+		bool _previous;
+	};
+
 	class contract_create_evaluator : public evaluator<contract_create_evaluator>, public evaluate_state {
 	public:
 		typedef contract_create_operation operation_type;
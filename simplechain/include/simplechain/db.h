@@ -1 +1,103 @@
 #pragma once
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <simplechain/persistent_map.h>
+
+namespace simplechain {
+
+	class db_file;
+	class index_segment;
+	class value_cache;
+
+	// location of a committed value in the log, removed marks a key removed since the older index segments
+	struct index_entry {
+		uint64_t offset;
+		uint32_t size;
+		bool removed;
+	};
+
+	/**
+	 * key => value store of the chain state on disk
+	 * values are appended to a log file. changes are staged until commit, each commit(one per block) is written
+	 * as a batch synced to disk before its commit record, so a batch interrupted by a crash is dropped when reopening.
+	 * the index of the keys is kept like a small LSM tree: the changes since the last checkpoint are in memory,
+	 * every few commits they are written as a new sorted index segment file, and the segments are merged into one
+	 * when there are too many. only every 32th key of a segment is kept in memory.
+	 * the segments in use are listed in the index file, so reopening only scans the log tail.
+	 * methods are thread safe, and a snapshot can be read without blocking the db or other snapshots
+	 */
+	class state_db {
+	public:
+		// @throws uvm::core::UvmException
+		state_db(const std::string& dir, size_t cache_capacity = 10000);
+		~state_db();
+
+		// committed or staged value of key
+		bool get(const std::string& key, std::string& value);
+		void put(const std::string& key, const std::string& value);
+		void remove(const std::string& key);
+		// all keys starting with prefix(committed and staged), prefix included
+		std::map<std::string, std::string> get_with_prefix(const std::string& prefix);
+		// calls fn in key order for the keys starting with prefix(committed and staged) until it returns false
+		void for_each_with_prefix(const std::string& prefix, const std::function<bool(const std::string&, const std::string&)>& fn);
+		size_t count_with_prefix(const std::string& prefix);
+
+		// write the staged changes atomically
+		// @throws uvm::core::UvmException
+		void commit(uint64_t block_num);
+		// drop the staged changes
+		void rollback();
+		uint64_t last_committed_block() const;
+		// write the index changes since the last checkpoint as a new index segment
+		// @throws uvm::core::UvmException
+		void save_index();
+
+		// read-only copy of the committed and staged state, sharing the files and the cache with this db.
+		// later changes of this db aren't seen by it
+		std::shared_ptr<state_db> snapshot() const;
+		bool is_snapshot() const;
+
+	private:
+		state_db();
+
+		struct pending_change {
+			bool removed;
+			std::string value;
+		};
+		typedef std::function<bool(const std::string& key, const pending_change* staged, const index_entry* committed)> scan_callback;
+
+		void check_writable() const;
+		bool load_index();
+		void replay_log(uint64_t from);
+		void write_index_file();
+		void compact_segments();
+		void remove_unused_segment_files();
+		std::string segment_path(uint64_t id) const;
+		bool find_entry(const std::string& key, index_entry& entry);
+		void scan(const std::string& prefix, const scan_callback& fn);
+		std::string read_value(const index_entry& entry);
+
+	private:
+		mutable std::recursive_mutex _mutex;
+		std::string _dir;
+		std::string _log_path;
+		std::string _index_path;
+		bool _is_snapshot;
+		std::shared_ptr<db_file> _log;
+		uint64_t _log_size;
+		uint64_t _last_block;
+		uint64_t _index_log_size; // log size when the index file was written
+		uint32_t _commits_since_index_saved;
+		uint64_t _next_segment_id;
+		std::vector<std::shared_ptr<index_segment> > _segments; // oldest first
+		persistent_map<std::string, index_entry> _memtable; // index changes since the last checkpoint
+		std::map<std::string, pending_change> _pending;
+		std::shared_ptr<value_cache> _cache; // committed values by log offset
+	};
+
+}
@@ -13,7 +13,6 @@ namespace simplechain {
 	struct transaction;
 
 	struct evaluate_state {
-		// TODO: parent evaluate_state
 		gas_count_type gas_limit = 0;
 		gas_count_type gas_used = 0;
 		std::string caller_address;
@@ -38,14 +38,17 @@ namespace simplechain {
 			return "abstract";
 		}
 
-		virtual std::set<std::string> apis() const {
-			return std::set<std::string>{};
+		virtual const std::set<std::string>& apis() const {
+			static const std::set<std::string> empty_names;
+			return empty_names;
 		}
-		virtual std::set<std::string> offline_apis() const {
-			return std::set<std::string>{};
+		virtual const std::set<std::string>& offline_apis() const {
+			static const std::set<std::string> empty_names;
+			return empty_names;
 		}
-		virtual std::set<std::string> events() const {
-			return std::set<std::string>{};
+		virtual const std::set<std::string>& events() const {
+			static const std::set<std::string> empty_names;
+			return empty_names;
 		}
 
 		virtual void invoke(const std::string& api_name, const std::string& api_arg) {
@@ -0,0 +1,187 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace simplechain {
+
+	/**
+	 * ordered map whose copies share their nodes(an AVL tree copying only the path to a changed node),
+	 * so copying it is O(1) and a copy is an immutable snapshot that can be read while the original is changed.
+	 * items are shared too, a change copies no other item
+	 */
+	template <typename K, typename V, typename Compare = std::less<K> >
+	class persistent_map {
+	public:
+		typedef std::pair<const K, V> value_type;
+
+	private:
+		struct node;
+		typedef std::shared_ptr<const node> node_ptr;
+		struct node {
+			std::shared_ptr<const value_type> item;
+			node_ptr left;
+			node_ptr right;
+			int height;
+			node(std::shared_ptr<const value_type> item_, node_ptr left_, node_ptr right_)
+				: item(std::move(item_)), left(std::move(left_)), right(std::move(right_)),
+				height(1 + std::max(height_of(left), height_of(right))) {}
+		};
+
+		static int height_of(const node_ptr& n) {
+			return n ? n->height : 0;
+		}
+
+		static node_ptr make_node(const std::shared_ptr<const value_type>& item, const node_ptr& left, const node_ptr& right) {
+			return std::make_shared<const node>(item, left, right);
+		}
+
+		// node with subtrees whose heights differ by at most 2, rotated back to an AVL node
+		static node_ptr balance(const std::shared_ptr<const value_type>& item, const node_ptr& left, const node_ptr& right) {
+			int left_height = height_of(left);
+			int right_height = height_of(right);
+			if (left_height > right_height + 1) {
+				if (height_of(left->left) >= height_of(left->right))
+					return make_node(left->item, left->left, make_node(item, left->right, right));
+				return make_node(left->right->item, make_node(left->item, left->left, left->right->left),
+					make_node(item, left->right->right, right));
+			}
+			if (right_height > left_height + 1) {
+				if (height_of(right->right) >= height_of(right->left))
+					return make_node(right->item, make_node(item, left, right->left), right->right);
+				return make_node(right->left->item, make_node(item, left, right->left->left),
+					make_node(right->item, right->left->right, right->right));
+			}
+			return make_node(item, left, right);
+		}
+
+		node_ptr insert(const node_ptr& n, const std::shared_ptr<const value_type>& item, bool& added) const {
+			if (!n) {
+				added = true;
+				return make_node(item, nullptr, nullptr);
+			}
+			if (_less(item->first, n->item->first))
+				return balance(n->item, insert(n->left, item, added), n->right);
+			if (_less(n->item->first, item->first))
+				return balance(n->item, n->left, insert(n->right, item, added));
+			return make_node(item, n->left, n->right);
+		}
+
+		static node_ptr erase_min(const node_ptr& n) {
+			if (!n->left)
+				return n->right;
+			return balance(n->item, erase_min(n->left), n->right);
+		}
+
+		node_ptr erase(const node_ptr& n, const K& key, bool& removed) const {
+			if (!n)
+				return n;
+			if (_less(key, n->item->first))
+				return balance(n->item, erase(n->left, key, removed), n->right);
+			if (_less(n->item->first, key))
+				return balance(n->item, n->left, erase(n->right, key, removed));
+			removed = true;
+			if (!n->left)
+				return n->right;
+			if (!n->right)
+				return n->left;
+			const node* min_node = n->right.get();
+			while (min_node->left)
+				min_node = min_node->left.get();
+			return balance(min_node->item, n->left, erase_min(n->right));
+		}
+
+	public:
+		// in key order, valid while the map it comes from isn't changed or destroyed
+		class const_iterator {
+		public:
+			const value_type& operator*() const { return *_stack.back()->item; }
+			const value_type* operator->() const { return _stack.back()->item.get(); }
+			const_iterator& operator++() {
+				const node* n = _stack.back();
+				_stack.pop_back();
+				push_left(n->right.get());
+				return *this;
+			}
+			bool operator==(const const_iterator& other) const {
+				return _stack.empty() ? other._stack.empty() : (!other._stack.empty() && _stack.back() == other._stack.back());
+			}
+			bool operator!=(const const_iterator& other) const { return !(*this == other); }
+		private:
+			friend class persistent_map;
+			void push_left(const node* n) {
+				for (; n; n = n->left.get())
+					_stack.push_back(n);
+			}
+			// nodes whose left subtree is visited, the current one last
+			std::vector<const node*> _stack;
+		};
+
+		persistent_map() : _size(0) {}
+
+		size_t size() const { return _size; }
+		bool empty() const { return _size == 0; }
+
+		const_iterator begin() const {
+			const_iterator it;
+			it.push_left(_root.get());
+			return it;
+		}
+		const_iterator end() const { return const_iterator(); }
+
+		// first item whose key isn't less than key
+		const_iterator lower_bound(const K& key) const {
+			const_iterator it;
+			for (const node* n = _root.get(); n;) {
+				if (_less(n->item->first, key))
+					n = n->right.get();
+				else {
+					it._stack.push_back(n);
+					n = n->left.get();
+				}
+			}
+			return it;
+		}
+
+		// value of key, nullptr when not found
+		const V* find(const K& key) const {
+			for (const node* n = _root.get(); n;) {
+				if (_less(key, n->item->first))
+					n = n->left.get();
+				else if (_less(n->item->first, key))
+					n = n->right.get();
+				else
+					return &n->item->second;
+			}
+			return nullptr;
+		}
+
+		void set(const K& key, const V& value) {
+			bool added = false;
+			_root = insert(_root, std::make_shared<const value_type>(key, value), added);
+			if (added)
+				_size++;
+		}
+
+		void erase(const K& key) {
+			bool removed = false;
+			_root = erase(_root, key, removed);
+			if (removed)
+				_size--;
+		}
+
+		void clear() {
+			_root.reset();
+			_size = 0;
+		}
+
+	private:
+		node_ptr _root;
+		size_t _size;
+		Compare _less;
+	};
+
+}
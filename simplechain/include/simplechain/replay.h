@@ -0,0 +1,43 @@
+#pragma once
+#include <simplechain/block.h>
+#include <simplechain/tx_phase_timer.h>
+#include <fc/variant_object.hpp>
+#include <string>
+#include <vector>
+
+namespace simplechain {
+	class blockchain;
+
+	/**
+	 * recorded blocks file: each entry is a 4 bytes little endian size followed by the fc::raw packed recorded_block.
+	 * replaying the blocks with their recorded block times on a fresh chain gives the same blocks and chain state
+	 */
+	struct recorded_block {
+		block blk;
+		std::string state_hash; // chain state hash after the block
+	};
+
+	// @throws uvm::core::UvmException
+	void append_recorded_block(const std::string& path, const recorded_block& recorded);
+	// @throws uvm::core::UvmException
+	std::vector<recorded_block> read_recorded_blocks(const std::string& path);
+
+	struct replay_result {
+		size_t blocks_count = 0;
+		size_t failed_txs_count = 0;
+		std::vector<tx_phase_timings> txs;
+		int64_t total_ns = 0;
+		int64_t phase_ns[tx_phases_count] = { 0 };
+		std::string state_hash;
+		// why the replay stopped at a block differing from the recorded one, empty when every block matched
+		std::string mismatch;
+
+		fc::mutable_variant_object to_json() const;
+	};
+
+	// apply the txs of each block in order, with phase timings of each tx,
+	// until a produced block or the state after it differs from the recorded one
+	replay_result replay_blocks(blockchain& chain, const std::vector<recorded_block>& blocks);
+}
+
+FC_REFLECT(simplechain::recorded_block, (blk)(state_hash))
@@ -8,16 +8,62 @@
 #include <simplechain/operations_helper.h>
 #include <simplechain/chain_rpc.h>
 #include <server_http.hpp>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace simplechain {
 
+	// latency histogram of a rpc method
+	class RpcLatencyHistogram {
+	public:
+		RpcLatencyHistogram();
+		// upper bounds of buckets in microseconds, the last bucket has no upper bound
+		static const std::vector<uint64_t>& bucket_bounds();
+		void record(uint64_t micros);
+		fc::mutable_variant_object to_json() const;
+	private:
+		std::vector<uint64_t> _counts;
+		uint64_t _count;
+		uint64_t _total_micros;
+		uint64_t _max_micros;
+	};
+
+	/**
+	 * read-only methods run in a worker pool on the last snapshot of the chain, other methods run one by one
+	 * in a writer thread, which publishes a new snapshot after each of them before answering.
+	 * so reads don't wait for writes or block generation, and always see the chain state between two writes
+	 */
 	class RpcServer final {
 	private:
 		blockchain* _chain;
 		int _port;
 		std::shared_ptr<HttpServer> _server;
+		std::shared_ptr<blockchain> _chain_snapshot; // read and replaced atomically
+		boost::asio::io_service _write_service;
+		std::shared_ptr<boost::asio::io_service::work> _write_service_work;
+		std::thread _write_thread;
+		size_t _read_threads_count;
+		boost::asio::io_service _read_service;
+		std::shared_ptr<boost::asio::io_service::work> _read_service_work;
+		std::vector<std::thread> _read_threads;
+		std::map<std::string, RpcLatencyHistogram> _latencies; // method => latency histogram
+		std::mutex _latencies_mutex;
+
+		std::shared_ptr<blockchain> chain_snapshot();
+		// called in the writer thread after a write
+		void publish_chain_snapshot();
+		void record_latency(const std::string& method, std::chrono::steady_clock::time_point start_time);
+		// process a json-rpc batch, in parallel when all methods in it are read-only.
+		// latencies of its items are measured from start_time, when the http request was received(like single requests)
+		void handle_rpc_batch(std::shared_ptr<HttpServer::Response> response, const fc::variants& items, std::chrono::steady_clock::time_point start_time);
+		fc::mutable_variant_object latencies_to_json();
 	public:
-		RpcServer(blockchain* chain, int port = 8080);
+		// read_threads_count = 0 means use hardware concurrency
+		RpcServer(blockchain* chain, int port = 8080, size_t read_threads_count = 0);
 		~RpcServer();
 
 		void start();
@@ -8,3 +8,4 @@
 #include <simplechain/contract_helper.h>
 #include <simplechain/operations_helper.h>
 #include <simplechain/rpcserver.h>
+#include <simplechain/replay.h>
@@ -0,0 +1,69 @@
+#pragma once
+#include <simplechain/config.h>
+#include <simplechain/storage.h>
+#include <simplechain/contract.h>
+#include <simplechain/contract_object.h>
+#include <simplechain/asset.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace simplechain {
+	typedef int64_t balance_t; //int64
+
+	/**
+	 * copy-on-write overlay of the chain state(storages, balances, contracts, tx receipts).
+	 * a layer only holds what was written into it, reads fall through to the parent layers and then to the committed state.
+	 * layers are stacked as tx layer -> block layer -> committed state, so a tx or a pending block is dropped
+	 * by discarding its layer, and merged into its parent in time proportional to its writes
+	 */
+	class state_layer {
+	public:
+		typedef std::map<std::string, std::map<std::string, StorageDataType> > storages_type;
+		typedef std::map<std::string, std::map<asset_id_t, balance_t> > balances_type;
+		typedef std::map<std::string, contract_object> contracts_type;
+		typedef std::map<std::string, transaction_receipt> tx_receipts_type;
+
+		explicit state_layer(std::shared_ptr<state_layer> parent = nullptr);
+
+		std::shared_ptr<state_layer> parent() const;
+
+		// find the value written in this layer or its parents
+		bool find_storage(const std::string& contract_address, const std::string& key, StorageDataType& value) const;
+		bool find_balance(const std::string& account_address, asset_id_t asset_id, balance_t& balance) const;
+		bool find_contract(const std::string& contract_address, contract_object& contract_obj) const;
+		bool find_contract_by_name(const std::string& name, std::string& contract_address, contract_object& contract_obj) const;
+		bool find_tx_receipt(const std::string& tx_id, transaction_receipt& tx_receipt) const;
+
+		void set_storage(const std::string& contract_address, const std::string& key, const StorageDataType& value);
+		void set_balance(const std::string& account_address, asset_id_t asset_id, balance_t balance);
+		void store_contract(const std::string& contract_address, const contract_object& contract_obj);
+		void set_tx_receipt(const std::string& tx_id, const transaction_receipt& tx_receipt);
+
+		// writes of this layer only
+		const storages_type& storages() const;
+		const balances_type& balances() const;
+		const contracts_type& contracts() const;
+		const tx_receipts_type& tx_receipts() const;
+
+		// write the changes of this layer to the parent layer
+		// @throws uvm::core::UvmException
+		void merge_into_parent();
+
+	private:
+		std::shared_ptr<state_layer> _parent;
+		storages_type _storages;
+		balances_type _balances;
+		contracts_type _contracts;
+		tx_receipts_type _tx_receipts;
+	};
+
+	// committed values a block overwrote, to undo the block. nullptr means the item not existed before the block
+	struct state_undo {
+		std::map<std::pair<std::string, std::string>, std::shared_ptr<StorageDataType> > storages;
+		std::map<std::pair<std::string, asset_id_t>, std::shared_ptr<balance_t> > balances;
+		std::map<std::string, std::shared_ptr<contract_object> > contracts;
+		std::map<std::string, std::shared_ptr<transaction_receipt> > tx_receipts;
+	};
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace simplechain {
+
+	// phases of applying a transaction, timed exclusively(time of a nested phase is not counted in the outer one)
+	enum tx_phase {
+		tx_phase_other = 0,
+		tx_phase_state_creation, // lua state and contract engine creation
+		tx_phase_bytecode_load, // contract code lookup and byte stream building
+		tx_phase_arg_marshalling, // api args to cbor/json
+		tx_phase_execution, // contract api or native contract execution
+		tx_phase_storage_commit, // storage changes commit, diff and storage gas counting
+		tx_phase_receipt, // applying pending changes and building the tx receipt
+		tx_phases_count
+	};
+
+	const char* tx_phase_name(tx_phase phase);
+
+	struct tx_phase_timings {
+		std::string tx_id;
+		bool succeed = false;
+		int64_t total_ns = 0;
+		int64_t phase_ns[tx_phases_count] = { 0 };
+	};
+
+	/**
+	 * collects phase timings of the txs applied in this thread while installed.
+	 * when no recorder is installed, tx_phase_scope does nothing
+	 */
+	class tx_phase_recorder {
+	public:
+		tx_phase_recorder();
+		~tx_phase_recorder();
+
+		// the recorder installed in this thread, or nullptr
+		static tx_phase_recorder* current();
+		void install();
+		void uninstall();
+
+		void begin_tx(const std::string& tx_id);
+		void end_tx(bool succeed);
+		void enter_phase(tx_phase phase);
+		void leave_phase();
+
+		const std::vector<tx_phase_timings>& txs() const;
+		void clear();
+
+	private:
+		typedef std::chrono::steady_clock clock_type;
+		void switch_phase(tx_phase next);
+
+		std::vector<tx_phase_timings> _txs;
+		bool _in_tx;
+		clock_type::time_point _tx_start;
+		clock_type::time_point _phase_start;
+		std::vector<tx_phase> _phases; // phase stack, top is the running phase
+	};
+
+	class tx_phase_scope {
+	public:
+		explicit tx_phase_scope(tx_phase phase);
+		~tx_phase_scope();
+	private:
+		tx_phase_recorder* _recorder;
+	};
+
+}
@@ -3,11 +3,13 @@
 #include <simplechain/contract_entry.h>
 #include <simplechain/contract_engine.h>
 #include <uvm/uvm_lib.h>
+#include <uvm/uvm_gas_manager.h>
 
 namespace simplechain {
 	class UvmContractEngine : public ContractEngine
 	{
 	private:
+		uvm::lua::lib::GasLedger _gas_ledger; // attached to the lua_State of _scope
 		std::shared_ptr<uvm::lua::lib::UvmStateScope> _scope;
 	public:
 		UvmContractEngine(bool use_contract = true);
@@ -18,6 +20,7 @@ namespace simplechain {
 		virtual int64_t gas_used() const;
 		virtual int vm_state() const;
 		std::shared_ptr<uvm::lua::lib::UvmStateScope> scope() const;
+		const uvm::lua::lib::GasLedger& gas_ledger() const;
 		virtual void set_gas_limit(int64_t gas_limit);
 		virtual void set_no_gas_limit();
 		virtual void set_gas_used(int64_t gas_used);
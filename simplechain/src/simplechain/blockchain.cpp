@@ -3,18 +3,31 @@
 #include <simplechain/transfer_evaluate.h>
 #include <simplechain/simplechain_uvm_api.h>
 #include <simplechain/uvm_contract_engine.h>
+#include <simplechain/replay.h>
+#include <simplechain/tx_phase_timer.h>
+#include <iomanip>
 #include <iostream>
 #include <list>
+#include <sstream>
 #include <fc/io/json.hpp>
 #include <uvm/lvm.h>
 #include <fc/log/logger.hpp>
 #include <fc/variant.hpp>
 #include <fc/variant_object.hpp>
 #include <fc/crypto/hex.hpp>
+#include <fc/io/raw.hpp>
 #include <cbor_diff/cbor_diff.h>
 
 namespace simplechain {
-	blockchain::blockchain() {
+	static block make_genesis_block() {
+		block genesis_block;
+		genesis_block.prev_block_hash = "";
+		genesis_block.block_number = 0;
+		genesis_block.block_time = fc::time_point(fc::microseconds(1536033055382L));
+		return genesis_block;
+	}
+
+	blockchain::blockchain() : head_block_num(0) {
 		uvm::lua::api::global_uvm_chain_api = new simplechain::SimpleChainUvmChainApi();
 
 		asset core_asset;
@@ -23,37 +36,310 @@ namespace simplechain {
 		core_asset.symbol = SIMPLECHAIN_CORE_ASSET_SYMBOL;
 		assets.push_back(core_asset);
 
-		block genesis_block;
-		genesis_block.prev_block_hash = "";
-		genesis_block.block_number = 0;
-		genesis_block.block_time = fc::time_point(fc::microseconds(1536033055382L));
-		blocks.push_back(genesis_block);
+		blocks.set(0, make_genesis_block());
+	}
+
+	blockchain::blockchain(snapshot_tag) : head_block_num(0) {
+	}
+
+	std::shared_ptr<blockchain> blockchain::snapshot() const {
+		std::shared_ptr<blockchain> chain(new blockchain(snapshot_tag()));
+		chain->assets = assets;
+		chain->blocks = blocks;
+		chain->head_block_num = head_block_num;
+		chain->tx_receipts = tx_receipts;
+		chain->address_pubkeys = address_pubkeys;
+		chain->account_balances = account_balances;
+		chain->contracts = contracts;
+		chain->contract_storages = contract_storages;
+		if (chain_db)
+			chain->chain_db = chain_db->snapshot();
+		return chain;
+	}
+
+	static StorageDataType null_storage() {
+		auto cbor_null = cbor::CborObject::create_null();
+		const auto& cbor_null_bytes = cbor_diff::cbor_encode(cbor_null);
+		StorageDataType storage;
+		storage.storage_data = cbor_null_bytes;
+		return storage;
+	}
+
+	// key of a contract storage in the state db
+	static std::string storage_db_key_prefix(const std::string& contract_address) {
+		return std::string("storage:") + contract_address + ":";
+	}
+
+	// keys of the other chain state in the state db, numbers are zero padded so prefix scans are in order
+	static std::string padded_db_key(const std::string& prefix, uint64_t num) {
+		std::ostringstream out;
+		out << prefix << std::setw(20) << std::setfill('0') << num;
+		return out.str();
+	}
+	static std::string block_db_key(uint64_t block_num) {
+		return padded_db_key("block:", block_num);
+	}
+	// block hash => block number
+	static std::string block_hash_db_key(const std::string& block_hash) {
+		return std::string("blockhash:") + block_hash;
+	}
+	// tx hash => number of the block including it
+	static std::string tx_block_db_key(const std::string& tx_hash) {
+		return std::string("txblock:") + tx_hash;
+	}
+	static std::string asset_db_key(asset_id_t asset_id) {
+		return padded_db_key("asset:", asset_id);
+	}
+	static std::string balance_db_key(const std::string& account_address, asset_id_t asset_id) {
+		return std::string("balance:") + account_address + ":" + std::to_string(asset_id);
+	}
+	static std::string contract_db_key(const std::string& contract_address) {
+		return std::string("contract:") + contract_address;
+	}
+	// contract name => contract address
+	static std::string contract_name_db_key(const std::string& contract_name) {
+		return std::string("contractname:") + contract_name;
+	}
+	static std::string tx_receipt_db_key(const std::string& tx_id) {
+		return std::string("receipt:") + tx_id;
+	}
+	static std::string pubkey_db_key(const std::string& addr) {
+		return std::string("pubkey:") + addr;
+	}
+
+	static std::string packed_to_db_value(const std::vector<char>& data) {
+		return std::string(data.begin(), data.end());
+	}
+	static std::vector<char> packed_from_db_value(const std::string& value) {
+		return std::vector<char>(value.begin(), value.end());
+	}
+
+	// contract_object's variant has no code and create_time isn't read back, so they are added here
+	static std::string contract_to_db_value(const contract_object& contract_obj) {
+		fc::variant contract_json;
+		fc::to_variant(contract_obj, contract_json);
+		fc::mutable_variant_object obj(contract_json.get_object());
+		obj["code"] = contract_obj.code;
+		return fc::json::to_string(obj);
+	}
+	static contract_object contract_from_db_value(const std::string& value) {
+		const auto& contract_json = fc::json::from_string(value);
+		contract_object contract_obj;
+		fc::from_variant(contract_json, contract_obj);
+		contract_obj.create_time = contract_json.get_object()["create_time"].as<fc::time_point_sec>();
+		return contract_obj;
+	}
+
+	// the reflected receipt(used by the state hash) has only tx_id and events, the other fields follow it
+	static std::string tx_receipt_to_db_value(const transaction_receipt& tx_receipt) {
+		std::vector<char> data(fc::raw::pack_size(tx_receipt) + fc::raw::pack_size(tx_receipt.exec_succeed)
+			+ fc::raw::pack_size(tx_receipt.gas_used) + fc::raw::pack_size(tx_receipt.gas_ledger));
+		fc::datastream<char*> ds(data.data(), data.size());
+		fc::raw::pack(ds, tx_receipt);
+		fc::raw::pack(ds, tx_receipt.exec_succeed);
+		fc::raw::pack(ds, tx_receipt.gas_used);
+		fc::raw::pack(ds, tx_receipt.gas_ledger);
+		return packed_to_db_value(data);
+	}
+	static transaction_receipt tx_receipt_from_db_value(const std::string& value) {
+		transaction_receipt tx_receipt;
+		fc::datastream<const char*> ds(value.data(), value.size());
+		fc::raw::unpack(ds, tx_receipt);
+		fc::raw::unpack(ds, tx_receipt.exec_succeed);
+		fc::raw::unpack(ds, tx_receipt.gas_used);
+		fc::raw::unpack(ds, tx_receipt.gas_ledger);
+		return tx_receipt;
+	}
+
+	void blockchain::open_state_db(const std::string& dir) {
+		FC_ASSERT(head_block_num == 0 && !top_state_layer && contracts.empty() && account_balances.empty(),
+			"state db must be opened before the chain has state");
+		auto db = std::make_shared<state_db>(dir);
+		// a db committed by another chain history(or keeping only contract storages) can't be used with these blocks
+		uint64_t db_head_block_num = db->last_committed_block();
+		std::string head_block_value;
+		if ((db_head_block_num > 0 && !db->get(block_db_key(db_head_block_num), head_block_value))
+			|| db->get(block_db_key(db_head_block_num + 1), head_block_value))
+			throw uvm::core::UvmException(std::string("state db in ") + dir + " is committed at block #"
+				+ std::to_string(db_head_block_num) + " but doesn't have the blocks to it"
+				+ ", remove it to start from the genesis block");
+		if (db_head_block_num > 0) {
+			blocks.clear();
+			blocks.set(db_head_block_num, fc::raw::unpack<block>(packed_from_db_value(head_block_value)));
+			head_block_num = db_head_block_num;
+		}
+		for (const auto& p : db->get_with_prefix("asset:")) {
+			asset item;
+			fc::from_variant(fc::json::from_string(p.second), item);
+			assets.push_back(item);
+		}
+		chain_db = db;
+	}
+
+	bool blockchain::find_committed_balance(const std::string& account_address, asset_id_t asset_id, balance_t& balance) const {
+		if (chain_db) {
+			std::string value;
+			if (!chain_db->get(balance_db_key(account_address, asset_id), value))
+				return false;
+			balance = (balance_t)std::stoull(value);
+			return true;
+		}
+		auto committed_balance = account_balances.find(std::make_pair(account_address, asset_id));
+		if (!committed_balance)
+			return false;
+		balance = *committed_balance;
+		return true;
+	}
+
+	void blockchain::set_committed_balance(const std::string& account_address, asset_id_t asset_id, balance_t balance) {
+		if (chain_db) {
+			chain_db->put(balance_db_key(account_address, asset_id), std::to_string(balance));
+			return;
+		}
+		account_balances.set(std::make_pair(account_address, asset_id), balance);
+	}
+
+	void blockchain::remove_committed_balance(const std::string& account_address, asset_id_t asset_id) {
+		if (chain_db) {
+			chain_db->remove(balance_db_key(account_address, asset_id));
+			return;
+		}
+		account_balances.erase(std::make_pair(account_address, asset_id));
+	}
+
+	std::map<std::string, std::map<asset_id_t, balance_t> > blockchain::get_committed_balances() const {
+		std::map<std::string, std::map<asset_id_t, balance_t> > result;
+		if (!chain_db) {
+			for (const auto& p : account_balances)
+				result[p.first.first][p.first.second] = p.second;
+			return result;
+		}
+		const std::string prefix("balance:");
+		chain_db->for_each_with_prefix(prefix, [&](const std::string& key, const std::string& value) -> bool {
+			auto pos = key.rfind(':');
+			const auto& account_address = key.substr(prefix.size(), pos - prefix.size());
+			auto asset_id = (asset_id_t)std::stoul(key.substr(pos + 1));
+			result[account_address][asset_id] = (balance_t)std::stoull(value);
+			return true;
+		});
+		return result;
+	}
+
+	bool blockchain::find_committed_contract(const std::string& contract_address, contract_object& contract_obj) const {
+		if (chain_db) {
+			std::string value;
+			if (!chain_db->get(contract_db_key(contract_address), value))
+				return false;
+			contract_obj = contract_from_db_value(value);
+			return true;
+		}
+		auto committed_contract = contracts.find(contract_address);
+		if (!committed_contract)
+			return false;
+		contract_obj = *committed_contract;
+		return true;
+	}
+
+	void blockchain::set_committed_contract(const std::string& contract_address, const contract_object& contract_obj) {
+		if (chain_db) {
+			contract_object old_contract;
+			if (find_committed_contract(contract_address, old_contract) && old_contract.contract_name != contract_obj.contract_name
+				&& !old_contract.contract_name.empty())
+				chain_db->remove(contract_name_db_key(old_contract.contract_name));
+			chain_db->put(contract_db_key(contract_address), contract_to_db_value(contract_obj));
+			if (!contract_obj.contract_name.empty())
+				chain_db->put(contract_name_db_key(contract_obj.contract_name), contract_address);
+			return;
+		}
+		contracts.set(contract_address, contract_obj);
+	}
+
+	void blockchain::remove_committed_contract(const std::string& contract_address) {
+		if (chain_db) {
+			contract_object old_contract;
+			if (find_committed_contract(contract_address, old_contract) && !old_contract.contract_name.empty())
+				chain_db->remove(contract_name_db_key(old_contract.contract_name));
+			chain_db->remove(contract_db_key(contract_address));
+			return;
+		}
+		contracts.erase(contract_address);
+	}
+
+	void blockchain::for_each_committed_contract(const std::function<void(const std::string&, const contract_object&)>& fn) const {
+		if (chain_db) {
+			const std::string prefix("contract:");
+			chain_db->for_each_with_prefix(prefix, [&](const std::string& key, const std::string& value) -> bool {
+				fn(key.substr(prefix.size()), contract_from_db_value(value));
+				return true;
+			});
+			return;
+		}
+		for (const auto& p : contracts)
+			fn(p.first, p.second);
+	}
+
+	bool blockchain::find_committed_tx_receipt(const std::string& tx_id, transaction_receipt& tx_receipt) const {
+		if (chain_db) {
+			std::string value;
+			if (!chain_db->get(tx_receipt_db_key(tx_id), value))
+				return false;
+			tx_receipt = tx_receipt_from_db_value(value);
+			return true;
+		}
+		auto committed_receipt = tx_receipts.find(tx_id);
+		if (!committed_receipt)
+			return false;
+		tx_receipt = *committed_receipt;
+		return true;
+	}
+
+	void blockchain::set_committed_tx_receipt(const std::string& tx_id, const transaction_receipt& tx_receipt) {
+		if (chain_db) {
+			chain_db->put(tx_receipt_db_key(tx_id), tx_receipt_to_db_value(tx_receipt));
+			return;
+		}
+		tx_receipts.set(tx_id, tx_receipt);
+	}
+
+	void blockchain::remove_committed_tx_receipt(const std::string& tx_id) {
+		if (chain_db) {
+			chain_db->remove(tx_receipt_db_key(tx_id));
+			return;
+		}
+		tx_receipts.erase(tx_id);
 	}
 
 	std::shared_ptr<evaluate_result> blockchain::evaluate_transaction(std::shared_ptr<transaction> tx) {
-		try {
-			// TODO: evaluate_state of block or tx(need nested evaluate state)
-			std::shared_ptr<evaluate_result> last_op_result;
-			this->last_evaluator_when_debugger = nullptr;
-			for (const auto& op : tx->operations) {
-				auto evaluator_instance = get_operation_evaluator(tx.get(), op);
-				auto op_result = evaluator_instance->evaluate(op);
-				last_op_result = op_result;
-				this->last_evaluator_when_debugger = evaluator_instance; // TODO: only save it when break into debugger
-				this->last_tx_when_debugger = tx;
-			}
-			return last_op_result;
+		std::shared_ptr<evaluate_result> last_op_result;
+		this->last_evaluator_when_debugger = nullptr;
+		for (const auto& op : tx->operations) {
+			auto evaluator_instance = get_operation_evaluator(tx.get(), op);
+			auto op_result = evaluator_instance->evaluate(op);
+			last_op_result = op_result;
+			this->last_evaluator_when_debugger = evaluator_instance; // TODO: only save it when break into debugger
+			this->last_tx_when_debugger = tx;
 		}
-		catch (const std::exception& e) {
-			throw e;
+		return last_op_result;
+	}
+	std::shared_ptr<evaluate_result> blockchain::evaluate_transaction_offline(std::shared_ptr<transaction> tx) {
+		offline_evaluate_scope offline_scope;
+		std::shared_ptr<evaluate_result> last_op_result;
+		for (const auto& op : tx->operations) {
+			auto evaluator_instance = get_operation_evaluator(tx.get(), op);
+			last_op_result = evaluator_instance->evaluate(op);
 		}
+		return last_op_result;
 	}
 	void blockchain::clear_debugger_info() {
 		this->last_evaluator_when_debugger = nullptr;
 	}
 	void blockchain::apply_transaction(std::shared_ptr<transaction> tx) {
+		// changes of the tx go to a tx layer, so a failed tx leaves no partial changes
+		auto recorder = tx_phase_recorder::current();
+		if (recorder)
+			recorder->begin_tx(tx->tx_hash());
+		push_state_layer();
 		try {
-			// TODO: evaluate_state of block or tx(need nested evaluate state)
 			for (const auto& op : tx->operations) {
 				auto evaluator_instance = get_operation_evaluator(tx.get(), op);
 				auto op_result = evaluator_instance->evaluate(op);
@@ -63,18 +349,26 @@ namespace simplechain {
 				auto op_result = evaluator_instance->apply(op);
 			}
 		}
-		catch (const std::exception& e) {
-			throw e;
+		catch (...) {
+			// fc::exception isn't a std::exception, any error must drop the tx layer
+			discard_state_layer();
+			if (recorder)
+				recorder->end_tx(false);
+			throw;
 		}
+		merge_state_layer();
+		if (recorder)
+			recorder->end_tx(true);
 	}
 
 	block blockchain::latest_block() const {
-		assert( ! blocks.empty() );
-		return blocks[blocks.size() - 1];
+		auto head_block = blocks.find(head_block_num);
+		assert( head_block );
+		return *head_block;
 	}
 
 	uint64_t blockchain::head_block_number() const {
-		return blocks.size();
+		return head_block_num + 1;
 	}
 
 	std::string blockchain::head_block_hash() const {
@@ -82,8 +376,21 @@ namespace simplechain {
 	}
 
 	std::shared_ptr<transaction> blockchain::get_trx_by_hash(const std::string& tx_hash) const {
-		for (const auto& block : blocks) {
-			for (const auto& tx : block.txs) {
+		if (chain_db) {
+			std::string block_num;
+			if (!chain_db->get(tx_block_db_key(tx_hash), block_num))
+				return nullptr;
+			const auto& blk = get_block_by_number(std::stoull(block_num));
+			if (!blk)
+				return nullptr;
+			for (const auto& tx : blk->txs) {
+				if (tx.tx_hash() == tx_hash)
+					return std::make_shared<transaction>(tx);
+			}
+			return nullptr;
+		}
+		for (const auto& p : blocks) {
+			for (const auto& tx : p.second.txs) {
 				if (tx.tx_hash() == tx_hash)
 					return std::make_shared<transaction>(tx);
 			}
@@ -92,69 +399,122 @@ namespace simplechain {
 	}
 
 	std::shared_ptr<block> blockchain::get_block_by_number(uint64_t num) const {
-		if (num >= blocks.size()) {
+		if (num > head_block_num) {
 			return nullptr;
 		}
-		return std::make_shared<block>(blocks[num]);
+		auto blk = blocks.find(num);
+		if (blk) {
+			return std::make_shared<block>(*blk);
+		}
+		if (!chain_db) {
+			return nullptr;
+		}
+		if (num == 0) {
+			return std::make_shared<block>(make_genesis_block());
+		}
+		std::string value;
+		if (!chain_db->get(block_db_key(num), value)) {
+			return nullptr;
+		}
+		return std::make_shared<block>(fc::raw::unpack<block>(packed_from_db_value(value)));
 	}
 	std::shared_ptr<block> blockchain::get_block_by_hash(const std::string& to_find_block_hash) const {
-		for (const auto& blk : blocks) {
-			const auto& block_hash = blk.block_hash();
+		if (chain_db) {
+			std::string block_num;
+			if (chain_db->get(block_hash_db_key(to_find_block_hash), block_num))
+				return get_block_by_number(std::stoull(block_num));
+			const auto& genesis_block = make_genesis_block();
+			if (genesis_block.block_hash() == to_find_block_hash)
+				return std::make_shared<block>(genesis_block);
+			return nullptr;
+		}
+		for (const auto& p : blocks) {
+			const auto& block_hash = p.second.block_hash();
 			if (block_hash == to_find_block_hash) {
-				return std::make_shared<block>(blk);
+				return std::make_shared<block>(p.second);
 			}
 		}
 		return nullptr;
 	}
 	balance_t blockchain::get_account_asset_balance(const std::string& account_address, asset_id_t asset_id) const {
-		auto balances_iter = account_balances.find(account_address);
-		if (balances_iter == account_balances.end()) {
-			return 0;
+		balance_t balance = 0;
+		if (top_state_layer && top_state_layer->find_balance(account_address, asset_id, balance)) {
+			return balance;
 		}
-		const auto& balances = balances_iter->second;
-		auto balance_iter = balances.find(asset_id);
-		if (balance_iter == balances.end()) {
-			return 0;
+		if (find_committed_balance(account_address, asset_id, balance)) {
+			return balance;
 		}
-		return balance_iter->second;
+		return 0;
 	}
 
 	std::map<asset_id_t, balance_t> blockchain::get_account_balances(const std::string& account_address) const {
-		auto balances_iter = account_balances.find(account_address);
 		std::map<asset_id_t, balance_t> balances;
-		if (balances_iter != account_balances.end()) {
-			balances = balances_iter->second;
+		if (chain_db) {
+			const auto& prefix = std::string("balance:") + account_address + ":";
+			chain_db->for_each_with_prefix(prefix, [&](const std::string& key, const std::string& value) -> bool {
+				balances[(asset_id_t)std::stoul(key.substr(prefix.size()))] = (balance_t)std::stoull(value);
+				return true;
+			});
+		}
+		else {
+			for (auto it = account_balances.lower_bound(std::make_pair(account_address, asset_id_t(0)));
+				it != account_balances.end() && it->first.first == account_address; ++it) {
+				balances[it->first.second] = it->second;
+			}
+		}
+		for (const auto layer : state_layers_from_bottom()) {
+			auto it = layer->balances().find(account_address);
+			if (it == layer->balances().end())
+				continue;
+			for (const auto& p : it->second) {
+				balances[p.first] = p.second;
+			}
 		}
 		return balances;
 	}
 
 	void blockchain::update_account_asset_balance(const std::string& account_address, asset_id_t asset_id, int64_t balance_change) {
-		auto balances_iter = account_balances.find(account_address);
-		std::map<asset_id_t, balance_t> balances;
-		if (balances_iter != account_balances.end()) {
-			balances = balances_iter->second;
+		balance_t old_balance = 0;
+		bool found = top_state_layer && top_state_layer->find_balance(account_address, asset_id, old_balance);
+		if (!found) {
+			found = find_committed_balance(account_address, asset_id, old_balance);
 		}
-		
-		auto balance_iter = balances.find(asset_id);
-		if (balance_iter == balances.end()) {
+		balance_t new_balance = 0;
+		if (!found) {
 			FC_ASSERT(balance_change >= 0, "balance change must >= 0");
-			balances[asset_id] = (balance_t)(balance_change);
+			new_balance = (balance_t)(balance_change);
 		}
 		else {
-			FC_ASSERT(balance_change > 0 || (-balance_change <= balance_iter->second), "balance change invalid");
-			balances[asset_id] = balance_t(int64_t(balance_iter->second) + balance_change);
+			FC_ASSERT(balance_change > 0 || (-balance_change <= old_balance), "balance change invalid");
+			new_balance = balance_t(int64_t(old_balance) + balance_change);
 		}
-		account_balances[account_address] = balances;
+		if (top_state_layer)
+			top_state_layer->set_balance(account_address, asset_id, new_balance);
+		else
+			set_committed_balance(account_address, asset_id, new_balance);
 	}
 	std::shared_ptr<contract_object> blockchain::get_contract_by_address(const std::string& addr) const {
-		for (const auto& it : contracts) {
-			if (it.first == addr) {
-				return std::make_shared<contract_object>(it.second);
-			}
+		contract_object contract_obj;
+		if (top_state_layer && top_state_layer->find_contract(addr, contract_obj)) {
+			return std::make_shared<contract_object>(contract_obj);
+		}
+		if (find_committed_contract(addr, contract_obj)) {
+			return std::make_shared<contract_object>(contract_obj);
 		}
 		return nullptr;
 	}
 	std::shared_ptr<contract_object> blockchain::get_contract_by_name(const std::string& name) const {
+		std::string contract_address;
+		contract_object contract_obj;
+		if (top_state_layer && top_state_layer->find_contract_by_name(name, contract_address, contract_obj)) {
+			return std::make_shared<contract_object>(contract_obj);
+		}
+		if (chain_db) {
+			if (chain_db->get(contract_name_db_key(name), contract_address) && find_committed_contract(contract_address, contract_obj)) {
+				return std::make_shared<contract_object>(contract_obj);
+			}
+			return nullptr;
+		}
 		for (const auto& it : contracts) {
 			if (it.second.contract_name == name) {
 				return std::make_shared<contract_object>(it.second);
@@ -164,14 +524,25 @@ namespace simplechain {
 	}
 
 	bool blockchain::contains_contract_by_address(const std::string& contract_address) const {
-		for (const auto& it : contracts) {
-			if (it.first == contract_address) {
-				return true;
-			}
+		contract_object contract_obj;
+		if (top_state_layer && top_state_layer->find_contract(contract_address, contract_obj)) {
+			return true;
 		}
-		return false;
+		if (chain_db) {
+			std::string value;
+			return chain_db->get(contract_db_key(contract_address), value);
+		}
+		return contracts.find(contract_address) != nullptr;
 	}
 	bool blockchain::contains_contract_by_name(const std::string& name) const {
+		std::string contract_address;
+		contract_object contract_obj;
+		if (top_state_layer && top_state_layer->find_contract_by_name(name, contract_address, contract_obj)) {
+			return true;
+		}
+		if (chain_db) {
+			return chain_db->get(contract_name_db_key(name), contract_address);
+		}
 		for (const auto& it : contracts) {
 			if (it.second.contract_name == name) {
 				return true;
@@ -182,67 +553,120 @@ namespace simplechain {
 
 
 	void blockchain::register_account(const std::string& addr, const std::string& pub_key_hex) {
-		address_pubkeys[addr] = pub_key_hex;
+		if (chain_db)
+			chain_db->put(pubkey_db_key(addr), pub_key_hex);
+		else
+			address_pubkeys.set(addr, pub_key_hex);
 	}
 
 	std::string blockchain::get_address_pubkey_hex(const std::string& addr) const {
-		auto it = address_pubkeys.find(addr);
-		if (it == address_pubkeys.end())
+		if (chain_db) {
+			std::string pub_key_hex;
+			if (!chain_db->get(pubkey_db_key(addr), pub_key_hex))
+				return "";
+			return pub_key_hex;
+		}
+		auto pub_key_hex = address_pubkeys.find(addr);
+		if (!pub_key_hex)
 			return "";
-		return it->second;
+		return *pub_key_hex;
 	}
 
 	void blockchain::store_contract(const std::string& addr, const contract_object& contract_obj) {
-		contracts[addr] = contract_obj;
+		if (top_state_layer) {
+			top_state_layer->store_contract(addr, contract_obj);
+			return;
+		}
+		set_committed_contract(addr, contract_obj);
+	}
+
+	bool blockchain::find_committed_storage(const std::string& contract_address, const std::string& key, StorageDataType& value) const {
+		if (chain_db) {
+			std::string data;
+			if (!chain_db->get(storage_db_key_prefix(contract_address) + key, data))
+				return false;
+			value.storage_data.assign(data.begin(), data.end());
+			return true;
+		}
+		auto committed_value = contract_storages.find(std::make_pair(contract_address, key));
+		if (!committed_value) {
+			return false;
+		}
+		value = *committed_value;
+		return true;
+	}
+
+	void blockchain::set_committed_storage(const std::string& contract_address, const std::string& key, const StorageDataType& value) {
+		if (chain_db) {
+			chain_db->put(storage_db_key_prefix(contract_address) + key,
+				std::string(value.storage_data.begin(), value.storage_data.end()));
+			return;
+		}
+		contract_storages.set(std::make_pair(contract_address, key), value);
+	}
+
+	void blockchain::remove_committed_storage(const std::string& contract_address, const std::string& key) {
+		if (chain_db) {
+			chain_db->remove(storage_db_key_prefix(contract_address) + key);
+			return;
+		}
+		contract_storages.erase(std::make_pair(contract_address, key));
 	}
 
 	StorageDataType blockchain::get_storage(const std::string& contract_address, const std::string& key) const {
-		auto it1 = contract_storages.find(contract_address);
-		if (it1 == contract_storages.end()) {
-			auto cbor_null = cbor::CborObject::create_null();
-			const auto& cbor_null_bytes = cbor_diff::cbor_encode(cbor_null);
-			StorageDataType storage;
-			storage.storage_data = cbor_null_bytes;
+		StorageDataType storage;
+		if (top_state_layer && top_state_layer->find_storage(contract_address, key, storage)) {
 			return storage;
-			// std::string null_jsonstr("null");
-			// return StorageDataType(null_jsonstr);
-		}
-		auto it2 = it1->second.find(key);
-		if (it2 == it1->second.end()) {
-			auto cbor_null = cbor::CborObject::create_null();
-			const auto& cbor_null_bytes = cbor_diff::cbor_encode(cbor_null);
-			StorageDataType storage;
-			storage.storage_data = cbor_null_bytes;
+		}
+		if (find_committed_storage(contract_address, key, storage)) {
 			return storage;
-			// std::string null_jsonstr("null");
-			// return StorageDataType(null_jsonstr);
 		}
-		return it2->second;
+		return null_storage();
 	}
 
 	std::map<std::string, StorageDataType> blockchain::get_contract_storages(const std::string& contract_address) const {
-		auto it1 = contract_storages.find(contract_address);
 		std::map<std::string, StorageDataType> storages;
-		if (it1 != contract_storages.end()) {
-			storages = it1->second;
+		if (chain_db) {
+			const auto& prefix = storage_db_key_prefix(contract_address);
+			for (const auto& p : chain_db->get_with_prefix(prefix)) {
+				auto& storage = storages[p.first.substr(prefix.size())];
+				storage.storage_data.assign(p.second.begin(), p.second.end());
+			}
+		}
+		else {
+			for (auto it = contract_storages.lower_bound(std::make_pair(contract_address, std::string()));
+				it != contract_storages.end() && it->first.first == contract_address; ++it) {
+				storages[it->first.second] = it->second;
+			}
+		}
+		for (const auto layer : state_layers_from_bottom()) {
+			auto it = layer->storages().find(contract_address);
+			if (it == layer->storages().end())
+				continue;
+			for (const auto& p : it->second) {
+				storages[p.first] = p.second;
+			}
 		}
 		return storages;
 	}
 
 	void blockchain::set_storage(const std::string& contract_address, const std::string& key, const StorageDataType& value) {
-		auto it1 = contract_storages.find(contract_address);
-		std::map<std::string, StorageDataType> storages;
-		if (it1 != contract_storages.end()) {
-			storages = it1->second;
+		if (top_state_layer) {
+			top_state_layer->set_storage(contract_address, key, value);
+			return;
 		}
-		storages[key] = value;
-		contract_storages[contract_address] = storages;
+		set_committed_storage(contract_address, key, value);
 	}
 
 	void blockchain::add_asset(const asset& new_asset) {
 		asset item(new_asset);
 		item.asset_id = (asset_id_t)(assets.size());
 		assets.push_back(item);
+		if (chain_db) {
+			fc::variant item_json;
+			fc::to_variant(item, item_json);
+			chain_db->put(asset_db_key(item.asset_id), fc::json::to_string(item_json));
+		}
 	}
 	std::shared_ptr<asset> blockchain::get_asset(asset_id_t asset_id) {
 		for (const auto& item : assets) {
@@ -266,17 +690,22 @@ namespace simplechain {
 	}
 
 	void blockchain::set_tx_receipt(const std::string& tx_id, const transaction_receipt& tx_receipt) {
-		tx_receipts[tx_id] = tx_receipt;
+		if (top_state_layer) {
+			top_state_layer->set_tx_receipt(tx_id, tx_receipt);
+			return;
+		}
+		set_committed_tx_receipt(tx_id, tx_receipt);
 	}
 
 	std::shared_ptr<transaction_receipt> blockchain::get_tx_receipt(const std::string& tx_id) {
-		auto it = tx_receipts.find(tx_id);
-		if (it == tx_receipts.end()) {
-			return nullptr;
+		transaction_receipt tx_receipt;
+		if (top_state_layer && top_state_layer->find_tx_receipt(tx_id, tx_receipt)) {
+			return std::make_shared<transaction_receipt>(tx_receipt);
 		}
-		else {
-			return std::make_shared<transaction_receipt>(it->second);
+		if (find_committed_tx_receipt(tx_id, tx_receipt)) {
+			return std::make_shared<transaction_receipt>(tx_receipt);
 		}
+		return nullptr;
 	}
 
 	void blockchain::load_contract_state(const std::string& contract_addr, const std::string& contract_state_json_str) {
@@ -363,6 +792,12 @@ namespace simplechain {
 	}
 
 	void blockchain::generate_block() {
+		generate_block(fc::time_point_sec(fc::time_point::now()));
+	}
+
+	void blockchain::generate_block(const fc::time_point_sec& block_time) {
+		FC_ASSERT(!top_state_layer, "can't generate block when there are pending state layers");
+		auto block_layer = push_state_layer();
 		std::vector<transaction> valid_txs;
 		auto it = tx_mempool.begin();
 		while (it != tx_mempool.end()) {
@@ -371,30 +806,167 @@ namespace simplechain {
 				valid_txs.push_back(*it);
 				it = tx_mempool.erase(it);
 			}
+			catch (const fc::exception& e) {
+				std::cout << "error of applying tx when generating block: " << e.to_detail_string() << std::endl;
+				it++;
+			}
 			catch (const std::exception& e) {
 				std::cout << "error of applying tx when generating block: " << e.what() << std::endl;
 				it++;
 			}
 		}
+		top_state_layer = nullptr;
+		block_undos.push_back(commit_state_layer(*block_layer));
+		if (block_undos.size() > SIMPLECHAIN_MAX_UNDO_BLOCKS)
+			block_undos.pop_front();
 		block blk;
 		blk.txs = valid_txs;
-		blk.block_time = fc::time_point_sec(fc::time_point::now());
-		blk.block_number = blocks.size();
+		blk.block_time = block_time;
+		blk.block_number = head_block_number();
 		blk.prev_block_hash = latest_block().block_hash();
-		blocks.push_back(blk);
+		if (chain_db) {
+			chain_db->put(block_db_key(blk.block_number), packed_to_db_value(fc::raw::pack(blk)));
+			chain_db->put(block_hash_db_key(blk.block_hash()), std::to_string(blk.block_number));
+			for (const auto& tx : blk.txs)
+				chain_db->put(tx_block_db_key(tx.tx_hash()), std::to_string(blk.block_number));
+			chain_db->commit(blk.block_number);
+			blocks.erase(head_block_num);
+		}
+		blocks.set(blk.block_number, blk);
+		head_block_num = blk.block_number;
+		if (!record_blocks_path.empty()) {
+			recorded_block recorded;
+			recorded.blk = blk;
+			recorded.state_hash = get_state_hash();
+			append_recorded_block(record_blocks_path, recorded);
+		}
 		ilog("block #${block_num} generated", ("block_num", blk.block_number));
 	}
 
+	void blockchain::undo_head_block() {
+		FC_ASSERT(!top_state_layer, "can't undo block when there are pending state layers");
+		FC_ASSERT(!block_undos.empty() && head_block_num > 0, "no block to undo");
+		const auto& undo = block_undos.back();
+		for (const auto& p : undo.storages) {
+			if (p.second)
+				set_committed_storage(p.first.first, p.first.second, *p.second);
+			else
+				remove_committed_storage(p.first.first, p.first.second);
+		}
+		for (const auto& p : undo.balances) {
+			if (p.second)
+				set_committed_balance(p.first.first, p.first.second, *p.second);
+			else
+				remove_committed_balance(p.first.first, p.first.second);
+		}
+		for (const auto& p : undo.contracts) {
+			if (p.second)
+				set_committed_contract(p.first, *p.second);
+			else
+				remove_committed_contract(p.first);
+		}
+		for (const auto& p : undo.tx_receipts) {
+			if (p.second)
+				set_committed_tx_receipt(p.first, *p.second);
+			else
+				remove_committed_tx_receipt(p.first);
+		}
+		block_undos.pop_back();
+		const auto head_block = latest_block();
+		tx_mempool.insert(tx_mempool.begin(), head_block.txs.begin(), head_block.txs.end());
+		if (chain_db) {
+			const auto& prev_block = get_block_by_number(head_block.block_number - 1);
+			chain_db->remove(block_db_key(head_block.block_number));
+			chain_db->remove(block_hash_db_key(head_block.block_hash()));
+			for (const auto& tx : head_block.txs)
+				chain_db->remove(tx_block_db_key(tx.tx_hash()));
+			chain_db->commit(prev_block->block_number);
+			blocks.set(prev_block->block_number, *prev_block);
+		}
+		blocks.erase(head_block.block_number);
+		head_block_num = head_block.block_number - 1;
+		ilog("block #${block_num} undone", ("block_num", head_block.block_number));
+	}
+
+	std::shared_ptr<state_layer> blockchain::push_state_layer() {
+		top_state_layer = std::make_shared<state_layer>(top_state_layer);
+		return top_state_layer;
+	}
+
+	void blockchain::discard_state_layer() {
+		FC_ASSERT(top_state_layer, "no state layer to discard");
+		top_state_layer = top_state_layer->parent();
+	}
+
+	void blockchain::merge_state_layer() {
+		FC_ASSERT(top_state_layer, "no state layer to merge");
+		// committing the bottom layer outside a block would lose its undo, generate_block commits it
+		FC_ASSERT(top_state_layer->parent(), "the bottom state layer is only committed by generate_block");
+		auto layer = top_state_layer;
+		top_state_layer = layer->parent();
+		layer->merge_into_parent();
+	}
+
+	void blockchain::switch_state_layer(std::shared_ptr<state_layer> layer) {
+		top_state_layer = layer;
+	}
+
+	std::shared_ptr<state_layer> blockchain::current_state_layer() const {
+		return top_state_layer;
+	}
+
+	std::vector<const state_layer*> blockchain::state_layers_from_bottom() const {
+		std::vector<const state_layer*> layers;
+		for (auto layer = top_state_layer.get(); layer; layer = layer->parent().get()) {
+			layers.push_back(layer);
+		}
+		std::reverse(layers.begin(), layers.end());
+		return layers;
+	}
+
+	state_undo blockchain::commit_state_layer(const state_layer& layer) {
+		state_undo undo;
+		for (const auto& p : layer.storages()) {
+			for (const auto& it : p.second) {
+				StorageDataType old_value;
+				if (find_committed_storage(p.first, it.first, old_value))
+					undo.storages[std::make_pair(p.first, it.first)] = std::make_shared<StorageDataType>(old_value);
+				else
+					undo.storages[std::make_pair(p.first, it.first)] = nullptr;
+				set_committed_storage(p.first, it.first, it.second);
+			}
+		}
+		for (const auto& p : layer.balances()) {
+			for (const auto& it : p.second) {
+				balance_t old_balance = 0;
+				undo.balances[std::make_pair(p.first, it.first)] = find_committed_balance(p.first, it.first, old_balance)
+					? std::make_shared<balance_t>(old_balance) : nullptr;
+				set_committed_balance(p.first, it.first, it.second);
+			}
+		}
+		for (const auto& p : layer.contracts()) {
+			contract_object old_contract;
+			undo.contracts[p.first] = find_committed_contract(p.first, old_contract) ? std::make_shared<contract_object>(old_contract) : nullptr;
+			set_committed_contract(p.first, p.second);
+		}
+		for (const auto& p : layer.tx_receipts()) {
+			transaction_receipt old_receipt;
+			undo.tx_receipts[p.first] = find_committed_tx_receipt(p.first, old_receipt) ? std::make_shared<transaction_receipt>(old_receipt) : nullptr;
+			set_committed_tx_receipt(p.first, p.second);
+		}
+		return undo;
+	}
+
 	fc::variant blockchain::get_state() const {
 		fc::mutable_variant_object chainstate_json;
 		fc::variant assets_obj;
 		fc::to_variant(assets, assets_obj);
 		chainstate_json["assets"] = assets_obj;
-		chainstate_json["contracts_count"] = contracts.size();
+		chainstate_json["contracts_count"] = chain_db ? chain_db->count_with_prefix("contract:") : contracts.size();
 		chainstate_json["head_block_num"] = head_block_number();
 		chainstate_json["head_block_hash"] = head_block_hash();
 		fc::variant accounts_obj;
-		fc::to_variant(account_balances, accounts_obj);
+		fc::to_variant(get_committed_balances(), accounts_obj);
 		chainstate_json["accounts"] = accounts_obj;
 		return chainstate_json;
 	}
@@ -403,18 +975,67 @@ namespace simplechain {
 		return fc::json::to_string(get_state());
 	}
 
+	std::string blockchain::get_state_hash() const {
+		fc::sha256::encoder enc;
+		fc::raw::pack(enc, head_block_number());
+		fc::raw::pack(enc, get_committed_balances());
+		for_each_committed_contract([&](const std::string& contract_address, const contract_object& contract_obj) {
+			fc::raw::pack(enc, contract_address);
+			fc::raw::pack(enc, contract_obj.owner_address);
+			fc::raw::pack(enc, contract_obj.registered_block);
+			fc::raw::pack(enc, contract_obj.code.code_hash);
+			fc::raw::pack(enc, contract_obj.native_contract_key);
+			fc::raw::pack(enc, get_contract_storages(contract_address));
+		});
+		if (chain_db) {
+			// packed like a map of receipts, without loading all of them
+			const std::string prefix("receipt:");
+			fc::raw::pack(enc, fc::unsigned_int(uint32_t(chain_db->count_with_prefix(prefix))));
+			chain_db->for_each_with_prefix(prefix, [&](const std::string& key, const std::string& value) -> bool {
+				fc::raw::pack(enc, key.substr(prefix.size()));
+				fc::raw::pack(enc, tx_receipt_from_db_value(value));
+				return true;
+			});
+		}
+		else {
+			fc::raw::pack(enc, fc::unsigned_int(uint32_t(tx_receipts.size())));
+			for (const auto& p : tx_receipts) {
+				fc::raw::pack(enc, p.first);
+				fc::raw::pack(enc, p.second);
+			}
+		}
+		return enc.result().str();
+	}
+
+	void blockchain::record_blocks_to(const std::string& path) {
+		record_blocks_path = path;
+	}
+
 	std::vector<contract_object> blockchain::get_contracts() const {
 		std::vector<contract_object> result;
-		for (const auto& p : contracts) {
-			result.push_back(p.second);
-		}
+		for_each_committed_contract([&](const std::string&, const contract_object& contract_obj) {
+			result.push_back(contract_obj);
+		});
 		return result;
 	}
 
 	std::vector<std::string> blockchain::get_account_addresses() const {
 		std::vector<std::string> result;
+		if (chain_db) {
+			// the balances of an account are next to each other in key order
+			const std::string prefix("balance:");
+			chain_db->for_each_with_prefix(prefix, [&](const std::string& key, const std::string&) -> bool {
+				const auto& account_address = key.substr(prefix.size(), key.rfind(':') - prefix.size());
+				if (result.empty() || result.back() != account_address)
+					result.push_back(account_address);
+				return true;
+			});
+			std::sort(result.begin(), result.end()); // ':' sorts after the characters of addresses
+			return result;
+		}
 		for (const auto& p : account_balances) {
-			result.push_back(p.first);
+			if (result.empty() || result.back() != p.first.first)
+				result.push_back(p.first.first);
 		}
 		return result;
 	}
@@ -492,6 +1113,8 @@ namespace simplechain {
 		if (std::find(lines.begin(), lines.end(), line) == lines.end())
 			lines.push_back(line);
 		(*breakpoints_pointer)[contract_address] = lines;
+		if (engine)
+			++((UvmContractEngine*)engine.get())->scope()->L()->breakpoints_version;
 	}
 	void blockchain::remove_breakpoint_in_last_debugger_state(const std::string& contract_address, uint32_t line) {
 		auto engine = get_last_contract_engine_for_debugger();
@@ -515,6 +1138,8 @@ namespace simplechain {
 		if (std::find(lines.begin(), lines.end(), line) != lines.end())
 			lines.erase(std::find(lines.begin(), lines.end(), line));
 		(*breakpoints_pointer)[contract_address] = lines;
+		if (engine)
+			++((UvmContractEngine*)engine.get())->scope()->L()->breakpoints_version;
 	}
 	void blockchain::clear_breakpoints_in_last_debugger_state() {
 		breakpoints.clear();
@@ -527,6 +1152,7 @@ namespace simplechain {
 			auto scope = uvm_engine->scope();
 			if (scope->L()->breakpoints) {
 				scope->L()->breakpoints->clear();
+				++scope->L()->breakpoints_version;
 			}
 		}
 	}
@@ -6,6 +6,7 @@
 #include <simplechain/blockchain.h>
 #include <simplechain/contract.h>
 #include <uvm/uvm_lib.h>
+#include <uvm/uvm_signature_cache.h>
 #include <streambuf>
 #include <istream>
 #include <ostream>
@@ -234,14 +235,29 @@ namespace simplechain {
 			tx->operations.push_back(op);
 			tx->tx_time = fc::time_point_sec(fc::time_point::now());
 
-			auto op_result = chain->evaluate_transaction(tx);
+			auto op_result = chain->evaluate_transaction_offline(tx);
 			fc::mutable_variant_object res;
 			res["txid"] = tx->tx_hash();
 			if (op_result) {
 				contract_invoke_result* contract_result = (contract_invoke_result*)op_result.get();
 				res["api_result"] = contract_result->api_result;
 				res["exec_succeed"] = contract_result->exec_succeed;
+				res["gas_used"] = contract_result->gas_used;
+				res["gas_ledger"] = gas_ledger_to_json(contract_result->gas_ledger);
+			}
+			return res;
+		}
+
+		RpcResultType profile_invoke_contract(blockchain* chain, HttpServer* server, const RpcRequestParams& params) {
+			uvm::lua::lib::UvmProfiler profiler;
+			fc::mutable_variant_object res;
+			{
+				contract_profiler_scope profiler_scope(&profiler);
+				res = fc::mutable_variant_object(invoke_contract_offline(chain, server, params).get_object());
 			}
+			res["profile"] = fc::json::from_string(profiler.to_json());
+			res["collapsed_stacks"] = profiler.to_collapsed_stacks();
+			res["collapsed_stacks_by_time"] = profiler.to_collapsed_stacks(true);
 			return res;
 		}
 
@@ -261,6 +277,11 @@ namespace simplechain {
 			return block_ids;
 		}
 
+		RpcResultType undo_block(blockchain* chain, HttpServer* server, const RpcRequestParams& params) {
+			chain->undo_head_block();
+			return chain->head_block_hash();
+		}
+
 		RpcResultType get_block_by_height(blockchain* chain, HttpServer* server, const RpcRequestParams& params) {
 			const auto& block_height = params.at(0).as_uint64();
 			auto block = chain->get_block_by_number(block_height);
@@ -304,6 +325,15 @@ namespace simplechain {
 			return state;
 		}
 
+		RpcResultType get_signature_cache_stats(blockchain* chain, HttpServer* server, const RpcRequestParams& params) {
+			const auto& cache = uvm::lua::lib::SignatureRecoverCache::instance();
+			fc::mutable_variant_object res;
+			res["size"] = cache.size();
+			res["hits"] = cache.hits();
+			res["misses"] = cache.misses();
+			return res;
+		}
+
 		RpcResultType list_accounts(blockchain* chain, HttpServer* server, const RpcRequestParams& params) {
 			const auto& accounts = chain->get_account_addresses();
 			fc::variant account_addresses;
@@ -1,6 +1,7 @@
 #include <simplechain/contract.h>
 #include <simplechain/contract_entry.h>
 #include <simplechain/blockchain.h>
+#include <simplechain/tx_phase_timer.h>
 #include <fc/crypto/sha512.hpp>
 #include <fc/crypto/sha256.hpp>
 #include <fc/crypto/ripemd160.hpp>
@@ -64,14 +65,20 @@ namespace simplechain {
 	}
 
 
+	// buckets kept across clear(), so the accumulators are allocated once per result
+	static const size_t contract_invoke_result_reserved_changes = 16;
+
 	void contract_invoke_result::reset()
 	{
 		api_result.clear();
 		storage_changes.clear();
+		storage_changes.reserve(contract_invoke_result_reserved_changes);
 		account_balances_changes.clear();
+		account_balances_changes.reserve(contract_invoke_result_reserved_changes);
 		transfer_fees.clear();
 		events.clear();
 		new_contracts.clear();
+		gas_ledger.clear();
 		exec_succeed = true;
 	}
 
@@ -133,6 +140,7 @@ namespace simplechain {
 	}
 
 	void contract_invoke_result::apply_pendings(blockchain* chain, const std::string& tx_id) {
+		tx_phase_scope phase_scope(tx_phase_receipt);
 		auto tx_receipt = chain->get_tx_receipt(tx_id);
 		if (!tx_receipt) {
 			tx_receipt = std::make_shared<transaction_receipt>();
@@ -145,15 +153,27 @@ namespace simplechain {
 			tx_receipt->events.push_back(p);
 		}
 		tx_receipt->exec_succeed = this->exec_succeed;
-		for (const auto& p : account_balances_changes) {
+		tx_receipt->gas_used += this->gas_used;
+		for (const auto& p : gas_ledger) {
+			auto& receipt_category = tx_receipt->gas_ledger[p.first];
+			for (const auto& it : p.second) {
+				receipt_category[it.first] += it.second;
+			}
+		}
+		// applied in the same order as before the changes were hashed, so a failed balance check reports the same change
+		for (const auto& p : ordered_account_balances_changes()) {
 			auto& addr = p.first.first;
 			auto asset_id = p.first.second;
 			auto amount_change = p.second;
 			chain->update_account_asset_balance(addr, asset_id, amount_change);
 		}
+		std::map<std::string, const contract_storage_changes_type*> ordered_storage_changes;
 		for (const auto& p : storage_changes) {
+			ordered_storage_changes[p.first] = &p.second;
+		}
+		for (const auto& p : ordered_storage_changes) {
 			const auto& contract_address = p.first;
-			const auto& changes = p.second;
+			const auto& changes = *p.second;
 			for (const auto& it : changes) {
 				chain->set_storage(contract_address, it.first, it.second.after);
 			}
@@ -161,6 +181,10 @@ namespace simplechain {
 		chain->set_tx_receipt(tx_id, *tx_receipt);
 	}
 
+	std::map<std::pair<address, asset_id_t>, amount_change_type, comparator_for_contract_invoke_result_balance_change> contract_invoke_result::ordered_account_balances_changes() const {
+		return std::map<std::pair<address, asset_id_t>, amount_change_type, comparator_for_contract_invoke_result_balance_change>(account_balances_changes.begin(), account_balances_changes.end());
+	}
+
 	int64_t contract_invoke_result::count_storage_gas() const {
 		cbor_diff::CborDiff differ;
 		int64_t storage_gas = 0;
@@ -232,6 +256,18 @@ namespace simplechain {
 		return info;
 	}
 
+	fc::mutable_variant_object gas_ledger_to_json(const gas_ledger_type& gas_ledger) {
+		fc::mutable_variant_object info;
+		for (const auto& p : gas_ledger) {
+			fc::mutable_variant_object category_info;
+			for (const auto& it : p.second) {
+				category_info[it.first] = it.second;
+			}
+			info[p.first] = category_info;
+		}
+		return info;
+	}
+
 	fc::mutable_variant_object transaction_receipt::to_json() const {
 		fc::mutable_variant_object info;
 		info["tx_id"] = tx_id;
@@ -241,6 +277,8 @@ namespace simplechain {
 		}
 		info["events"] = events_json;
 		info["exec_succeed"] = exec_succeed;
+		info["gas_used"] = gas_used;
+		info["gas_ledger"] = gas_ledger_to_json(gas_ledger);
 		return info;
 	}
 
@@ -4,7 +4,9 @@
 #include <simplechain/blockchain.h>
 #include <simplechain/address_helper.h>
 #include <simplechain/native_contract.h>
+#include <simplechain/tx_phase_timer.h>
 #include <iostream>
+#include <mutex>
 #include <uvm/uvm_lib.h>
 #include <fc/io/json.hpp>
 
@@ -14,11 +16,51 @@ namespace simplechain {
 	using namespace std;
 
 	static std::shared_ptr<ContractEngine> last_contract_engine_for_debugger;
+	static std::mutex last_contract_engine_for_debugger_mutex;
+
+	static thread_local bool in_offline_evaluate_scope = false;
 
 	std::shared_ptr<ContractEngine> get_last_contract_engine_for_debugger() {
+		std::lock_guard<std::mutex> lock(last_contract_engine_for_debugger_mutex);
 		return last_contract_engine_for_debugger;
 	}
 
+	// offline evaluations keep the debugger session of the last online one
+	static void set_last_contract_engine_for_debugger(std::shared_ptr<ContractEngine> engine) {
+		if (in_offline_evaluate_scope)
+			return;
+		std::lock_guard<std::mutex> lock(last_contract_engine_for_debugger_mutex);
+		last_contract_engine_for_debugger = engine;
+	}
+
+	offline_evaluate_scope::offline_evaluate_scope()
+		: _previous(in_offline_evaluate_scope) {
+		in_offline_evaluate_scope = true;
+	}
+
+	offline_evaluate_scope::~offline_evaluate_scope() {
+		in_offline_evaluate_scope = _previous;
+	}
+
+	bool offline_evaluate_scope::current() {
+		return in_offline_evaluate_scope;
+	}
+
+	static thread_local uvm::lua::lib::UvmProfiler* current_contract_profiler = nullptr;
+
+	contract_profiler_scope::contract_profiler_scope(uvm::lua::lib::UvmProfiler* profiler)
+		: _previous(current_contract_profiler) {
+		current_contract_profiler = profiler;
+	}
+
+	contract_profiler_scope::~contract_profiler_scope() {
+		current_contract_profiler = _previous;
+	}
+
+	uvm::lua::lib::UvmProfiler* contract_profiler_scope::current() {
+		return current_contract_profiler;
+	}
+
 	static void convertArgs2Cbor(const fc::variants& args, cbor::CborArrayValue& api_args) {
 		for (const auto& api_arg_json : args) {
 			if (api_arg_json.is_bool()) {
@@ -43,15 +85,30 @@ namespace simplechain {
 	}
 
 
+	// gas charged by the chain apis and libs as recorded, the rest of gas_used by the executed instructions
+	static gas_ledger_type make_gas_ledger(const uvm::lua::lib::GasLedger& ledger, gas_count_type gas_used) {
+		gas_ledger_type result(ledger.entries());
+		auto instructions_gas = int64_t(gas_used) - ledger.total();
+		if (instructions_gas > 0)
+			result["vm"]["instructions"] = instructions_gas;
+		return result;
+	}
+
 	// contract_create_evaluator methods
 	std::shared_ptr<contract_create_evaluator::operation_type::result_type> contract_create_evaluator::do_evaluate(const operation_type& o) {
-		last_contract_engine_for_debugger = nullptr;
+		set_last_contract_engine_for_debugger(nullptr);
 
 		ContractEngineBuilder builder;
-		auto engine = builder.build();
-		if (engine->scope()->L()->breakpoints) {
+		std::shared_ptr<ActiveContractEngine> engine;
+		{
+			tx_phase_scope phase_scope(tx_phase_state_creation);
+			engine = builder.build();
+		}
+		if (engine->scope()->L()->breakpoints && !offline_evaluate_scope::current()) {
 			*engine->scope()->L()->breakpoints = chain->get_breakpoints_in_last_debugger_state();
+			++engine->scope()->L()->breakpoints_version;
 		}
+		engine->scope()->set_profiler(contract_profiler_scope::current());
 		int exception_code = 0;
 		string exception_msg;
 		bool has_error = false;
@@ -76,19 +133,23 @@ namespace simplechain {
 			contract.registered_block = get_chain()->latest_block().block_number + 1;
 			contract.type_of_contract = contract_type::normal_contract;
 			// verify contract bytecode stream format
-			auto L = engine->scope()->L();
-			auto code_stream = uvm::lua::api::global_uvm_chain_api->get_bytestream_from_code(L, contract.code);
-			if (!code_stream)
-				throw uvm::core::UvmException("invalid contract bytecode format");
-			char contract_format_err[LUA_COMPILE_ERROR_MAX_LENGTH] = { 0 };
-			if(!uvm::lua::lib::check_contract_bytecode_stream(L, code_stream.get(), contract_format_err))
-				throw uvm::core::UvmException("invalid contract bytecode format");
-			lua_pop(L, 1); // pop stream
+			{
+				tx_phase_scope phase_scope(tx_phase_bytecode_load);
+				auto L = engine->scope()->L();
+				auto code_stream = uvm::lua::api::global_uvm_chain_api->get_bytestream_from_code(L, contract.code);
+				if (!code_stream)
+					throw uvm::core::UvmException("invalid contract bytecode format");
+				char contract_format_err[LUA_COMPILE_ERROR_MAX_LENGTH] = { 0 };
+				if(!uvm::lua::lib::check_contract_bytecode_stream(L, code_stream.get(), contract_format_err))
+					throw uvm::core::UvmException("invalid contract bytecode format");
+				lua_pop(L, 1); // pop stream
+			}
 			store_contract(contract_address, contract);
 			try
 			{
 				std::string result_json_str;
 				cbor::CborArrayValue args;
+				tx_phase_scope phase_scope(tx_phase_execution);
 				engine->execute_contract_init_by_address(contract_address, args, &result_json_str);
 				invoke_contract_result.api_result = result_json_str;
 			}
@@ -107,9 +168,10 @@ namespace simplechain {
 			auto gas_count = gas_used;
 			invoke_contract_result.exec_succeed = true;
 			invoke_contract_result.gas_used = gas_count;
+			invoke_contract_result.gas_ledger = make_gas_ledger(engine->gas_ledger(), gas_count);
 
 			if (engine->vm_state() & lua_VMState::LVM_STATE_BREAK) {
-				last_contract_engine_for_debugger = engine;
+				set_last_contract_engine_for_debugger(engine);
 			}
 			invoke_contract_result.validate();
 		}
@@ -164,6 +226,7 @@ namespace simplechain {
 			store_contract(contract_address, contract);
 			try
 			{
+				tx_phase_scope phase_scope(tx_phase_execution);
 				native_contract->invoke("init", "");
 				auto native_result = *static_cast<contract_invoke_result*>(native_contract->get_result());
 				native_result.new_contracts = invoke_contract_result.new_contracts;
@@ -184,6 +247,7 @@ namespace simplechain {
 			auto gas_count = gas_used;
 			invoke_contract_result.exec_succeed = true;
 			invoke_contract_result.gas_used = gas_count;
+			invoke_contract_result.gas_ledger["native"]["init"] = gas_count;
 			invoke_contract_result.validate();
 		}
 		catch (const std::exception& e)
@@ -210,13 +274,19 @@ namespace simplechain {
 
 	// contract_invoke_evaluator methods
 	std::shared_ptr<contract_invoke_evaluator::operation_type::result_type> contract_invoke_evaluator::do_evaluate(const operation_type& o) {
-		last_contract_engine_for_debugger = nullptr;
+		set_last_contract_engine_for_debugger(nullptr);
 
 		ContractEngineBuilder builder;
-		auto engine = builder.build();
-		if (engine->scope()->L()->breakpoints) {
+		std::shared_ptr<ActiveContractEngine> engine;
+		{
+			tx_phase_scope phase_scope(tx_phase_state_creation);
+			engine = builder.build();
+		}
+		if (engine->scope()->L()->breakpoints && !offline_evaluate_scope::current()) {
 			*engine->scope()->L()->breakpoints = chain->get_breakpoints_in_last_debugger_state();
+			++engine->scope()->L()->breakpoints_version;
 		}
+		engine->scope()->set_profiler(contract_profiler_scope::current());
 		int exception_code = 0;
 		string exception_msg;
 		bool has_error = false;
@@ -241,28 +311,31 @@ namespace simplechain {
 				std::string raw_first_contract_arg = first_contract_arg;
 				
 				// only can call on_deposit_asset when deposit_amount > 0
-				if (o.deposit_amount > 0) {
-					if (o.contract_api != "on_deposit_asset") {
-						throw uvm::core::UvmException("only can deposit to contract by call api on_deposit_asset");
-					}
-					auto asset = chain->get_asset(o.deposit_asset_id);
-					if(!asset) {
-						throw uvm::core::UvmException(std::string("can't find asset #") + std::to_string(o.deposit_asset_id));
+				{
+					tx_phase_scope phase_scope(tx_phase_arg_marshalling);
+					if (o.deposit_amount > 0) {
+						if (o.contract_api != "on_deposit_asset") {
+							throw uvm::core::UvmException("only can deposit to contract by call api on_deposit_asset");
+						}
+						auto asset = chain->get_asset(o.deposit_asset_id);
+						if(!asset) {
+							throw uvm::core::UvmException(std::string("can't find asset #") + std::to_string(o.deposit_asset_id));
+						}
+						fc::mutable_variant_object depositArgs;
+						depositArgs["num"] = o.deposit_amount;
+						depositArgs["symbol"] = asset->symbol;
+						depositArgs["param"] = first_contract_arg;
+
+						auto argStr = fc::json::to_string(depositArgs);	
+						raw_first_contract_arg = argStr;
+						arr.push_back(cbor::CborObject::from_string(argStr));
 					}
-					fc::mutable_variant_object depositArgs;
-					depositArgs["num"] = o.deposit_amount;
-					depositArgs["symbol"] = asset->symbol;
-					depositArgs["param"] = first_contract_arg;
-
-					auto argStr = fc::json::to_string(depositArgs);	
-					raw_first_contract_arg = argStr;
-					arr.push_back(cbor::CborObject::from_string(argStr));
-				}
-				else {
-					if (std::find(uvm::lua::lib::contract_special_api_names.begin(), uvm::lua::lib::contract_special_api_names.end(), o.contract_api) != uvm::lua::lib::contract_special_api_names.end()) {
-						throw uvm::core::UvmException(std::string("can't call ") + o.contract_api + " directly");
+					else {
+						if (std::find(uvm::lua::lib::contract_special_api_names.begin(), uvm::lua::lib::contract_special_api_names.end(), o.contract_api) != uvm::lua::lib::contract_special_api_names.end()) {
+							throw uvm::core::UvmException(std::string("can't call ") + o.contract_api + " directly");
+						}
+						convertArgs2Cbor(o.contract_args, arr);
 					}
-					convertArgs2Cbor(o.contract_args, arr);
 				}
 				std::string result_json_str;
 				auto contract = get_contract_by_address(o.contract_address);
@@ -275,35 +348,54 @@ namespace simplechain {
 						update_account_asset_balance(o.contract_address, o.deposit_asset_id, o.deposit_amount);
 					}
 					engine->set_gas_limit(limit);
+					tx_phase_scope phase_scope(tx_phase_execution);
 					engine->execute_contract_api_by_address(o.contract_address, o.contract_api, arr, &result_json_str);
 					invoke_contract_result.api_result = result_json_str;
 					gas_used = engine->gas_used();
+					invoke_contract_result.gas_ledger = make_gas_ledger(engine->gas_ledger(), gas_used);
 				}
 				else {
 					// native contract
 					this->caller_address = o.caller_address;
 					auto native_contract = native_contract_finder::create_native_contract_by_key(this, contract->native_contract_key, o.contract_address);
 					FC_ASSERT(native_contract, "native contract with the key not found");
-					// TODO: arr
-					native_contract->invoke(o.contract_api, raw_first_contract_arg);
+					// a single string arg is the old "arg1,arg2,..." form, otherwise the decoded args are passed typed
+					// from the NATIVE_TYPED_ARGS fork on(before it only the first arg was passed)
+					auto L = engine->scope()->L();
+					auto typed_args_fork_height = uvm::lua::api::global_uvm_chain_api->get_fork_height(L, "NATIVE_TYPED_ARGS");
+					bool typed_args = typed_args_fork_height >= 0 && uvm::lua::api::global_uvm_chain_api->get_header_block_num_without_gas(L) >= typed_args_fork_height
+						&& o.deposit_amount == 0 && (o.contract_args.size() > 1 || (o.contract_args.size() == 1 && !o.contract_args[0].is_string()));
+					{
+						tx_phase_scope phase_scope(tx_phase_execution);
+						if (typed_args)
+							native_contract->invoke_with_args(o.contract_api, uvm::contract::native_contract_args(arr));
+						else
+							native_contract->invoke(o.contract_api, raw_first_contract_arg);
+					}
 					if (o.deposit_amount > 0) {
 						auto deposit_asset = get_chain()->get_asset(o.deposit_asset_id);
 						FC_ASSERT(deposit_asset);
 						native_contract->current_set_on_deposit_asset(deposit_asset->symbol, o.deposit_amount);
 					}
 					invoke_contract_result = *static_cast<contract_invoke_result*>(native_contract->get_result());
+					invoke_contract_result.gas_ledger["native"][o.contract_api] = invoke_contract_result.gas_used;
 					
 					// count and add storage gas to gas_used
+					tx_phase_scope phase_scope(tx_phase_storage_commit);
 					auto storage_gas = invoke_contract_result.count_storage_gas();
 					if (storage_gas < 0) {
 						throw uvm::core::UvmException("invalid storage gas");
 					}
 					invoke_contract_result.gas_used += storage_gas;
+					if (storage_gas > 0)
+						invoke_contract_result.gas_ledger["storage"]["write " + o.contract_address] = storage_gas;
 					auto event_gas = invoke_contract_result.count_event_gas();
 					if (event_gas < 0) {
 						throw uvm::core::UvmException("invalid event gas");
 					}
 					invoke_contract_result.gas_used += event_gas;
+					if (event_gas > 0)
+						invoke_contract_result.gas_ledger["events"]["emit"] = event_gas;
 
 					gas_used = invoke_contract_result.gas_used;
 				}
@@ -333,7 +425,7 @@ namespace simplechain {
 			invoke_contract_result.gas_used = gas_count;
 
 			if (engine->vm_state() & (lua_VMState::LVM_STATE_BREAK | lua_VMState::LVM_STATE_SUSPEND)) {
-				last_contract_engine_for_debugger = engine;
+				set_last_contract_engine_for_debugger(engine);
 
 			}
 		}
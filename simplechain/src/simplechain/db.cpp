@@ -0,0 +1,978 @@
+#include <simplechain/db.h>
+#include <uvm/exceptions.h>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace simplechain {
+
+	namespace fs = boost::filesystem;
+
+	// log records(integers in host byte order):
+	//   put:    'P' key_size(u32) value_size(u32) key value
+	//   remove: 'D' key_size(u32) key
+	//   commit: 'C' block_num(u64) checksum(u64) of the batch records before it
+	static const char LOG_RECORD_PUT = 'P';
+	static const char LOG_RECORD_REMOVE = 'D';
+	static const char LOG_RECORD_COMMIT = 'C';
+	// index file: magic log_size(u64) last_block(u64) next_segment_id(u64) count(u32) segment_ids(u64 each) checksum(u64)
+	static const uint64_t INDEX_FILE_MAGIC = 0x3258444943534453ULL; // "SDSCIDX2"
+	// index segment: magic entries count(u64) checksum(u64) of the bytes before it
+	//   entry: key_size(u32) key removed(u8) offset(u64) size(u32), ordered by key
+	static const uint64_t SEGMENT_FILE_MAGIC = 0x3147455343534453ULL; // "SDSCSEG1"
+	static const uint32_t SAVE_INDEX_EVERY_COMMITS = 100;
+	static const size_t SEGMENT_FENCE_INTERVAL = 32;
+	static const size_t MAX_INDEX_SEGMENTS = 8;
+	static const size_t FILE_BUFFER_SIZE = 64 * 1024;
+
+	static uint64_t fnv1a(uint64_t hash, const char* data, size_t size) {
+		for (size_t i = 0; i < size; i++) {
+			hash ^= uint8_t(data[i]);
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+	static const uint64_t FNV1A_INIT = 14695981039346656037ULL;
+
+	template <typename T>
+	static void append_pod(std::string& out, T value) {
+		out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	static bool has_prefix(const std::string& key, const std::string& prefix) {
+		return key.compare(0, prefix.size(), prefix) == 0;
+	}
+
+	// file read and written at offsets, without a shared position so reads don't need a lock
+	class db_file {
+	public:
+		db_file(const std::string& path, bool create) : _path(path) {
+#ifdef _WIN32
+			_fd = _open(path.c_str(), _O_RDWR | _O_BINARY | (create ? _O_CREAT : 0), _S_IREAD | _S_IWRITE);
+#else
+			_fd = ::open(path.c_str(), O_RDWR | (create ? O_CREAT : 0), 0644);
+#endif
+			if (_fd < 0)
+				throw uvm::core::UvmException(std::string("can't open state db file ") + path);
+		}
+		~db_file() {
+#ifdef _WIN32
+			_close(_fd);
+#else
+			::close(_fd);
+#endif
+		}
+
+		uint64_t size() const {
+#ifdef _WIN32
+			struct _stat64 st;
+			if (_fstat64(_fd, &st) != 0)
+#else
+			struct stat st;
+			if (::fstat(_fd, &st) != 0)
+#endif
+				throw uvm::core::UvmException(std::string("stat state db file failed ") + _path);
+			return uint64_t(st.st_size);
+		}
+
+		// reads up to size bytes at offset, less only at the end of the file
+		size_t read_some(uint64_t offset, char* buf, size_t size) const {
+			size_t done = 0;
+			while (done < size) {
+#ifdef _WIN32
+				std::lock_guard<std::mutex> lock(_mutex); // no pread on windows
+				int n = -1;
+				if (_lseeki64(_fd, int64_t(offset + done), SEEK_SET) >= 0)
+					n = _read(_fd, buf + done, unsigned(std::min<size_t>(size - done, 1 << 30)));
+#else
+				ssize_t n = ::pread(_fd, buf + done, size - done, off_t(offset + done));
+				if (n < 0 && errno == EINTR)
+					continue;
+#endif
+				if (n < 0)
+					throw uvm::core::UvmException(std::string("read state db file failed ") + _path);
+				if (n == 0)
+					break;
+				done += size_t(n);
+			}
+			return done;
+		}
+
+		void read(uint64_t offset, char* buf, size_t size) const {
+			if (read_some(offset, buf, size) != size)
+				throw uvm::core::UvmException(std::string("read state db file failed ") + _path);
+		}
+
+		void write(uint64_t offset, const char* data, size_t size) {
+			size_t done = 0;
+			while (done < size) {
+#ifdef _WIN32
+				std::lock_guard<std::mutex> lock(_mutex);
+				int n = -1;
+				if (_lseeki64(_fd, int64_t(offset + done), SEEK_SET) >= 0)
+					n = _write(_fd, data + done, unsigned(std::min<size_t>(size - done, 1 << 30)));
+#else
+				ssize_t n = ::pwrite(_fd, data + done, size - done, off_t(offset + done));
+				if (n < 0 && errno == EINTR)
+					continue;
+#endif
+				if (n <= 0)
+					throw uvm::core::UvmException(std::string("write state db file failed ") + _path);
+				done += size_t(n);
+			}
+		}
+
+		// flush the written data to the disk
+		void sync() {
+#ifdef _WIN32
+			int res = _commit(_fd);
+#else
+			int res = ::fsync(_fd);
+#endif
+			if (res != 0)
+				throw uvm::core::UvmException(std::string("sync state db file failed ") + _path);
+		}
+
+		void truncate(uint64_t size) {
+#ifdef _WIN32
+			int res = _chsize_s(_fd, int64_t(size));
+#else
+			int res = ::ftruncate(_fd, off_t(size));
+#endif
+			if (res != 0)
+				throw uvm::core::UvmException(std::string("truncate state db file failed ") + _path);
+		}
+
+		const std::string& path() const { return _path; }
+
+	private:
+		std::string _path;
+		int _fd;
+#ifdef _WIN32
+		mutable std::mutex _mutex;
+#endif
+	};
+
+	// make a rename or a new file in dir survive a crash
+	static void sync_dir(const std::string& dir) {
+#ifndef _WIN32
+		int fd = ::open(dir.c_str(), O_RDONLY);
+		if (fd < 0)
+			return;
+		::fsync(fd);
+		::close(fd);
+#endif
+	}
+
+	// write the whole file as path.tmp, then rename it to path
+	static void write_file_atomically(const std::string& dir, const std::string& path, const std::string& data) {
+		const auto& tmp_path = path + ".tmp";
+		{
+			db_file out(tmp_path, true);
+			out.truncate(0);
+			out.write(0, data.data(), data.size());
+			out.sync();
+		}
+		fs::rename(fs::path(tmp_path), fs::path(path));
+		sync_dir(dir);
+	}
+
+	// LRU cache of committed values by their log offset, which never changes, so the db and its snapshots share it
+	class value_cache {
+	public:
+		value_cache(size_t capacity) : _capacity(capacity) {}
+
+		bool get(uint64_t offset, std::string& value) {
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto it = _items_by_offset.find(offset);
+			if (it == _items_by_offset.end())
+				return false;
+			_items.splice(_items.begin(), _items, it->second); // most recently used first
+			value = it->second->second;
+			return true;
+		}
+
+		void put(uint64_t offset, const std::string& value) {
+			if (_capacity == 0)
+				return;
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (_items_by_offset.find(offset) != _items_by_offset.end())
+				return;
+			_items.emplace_front(offset, value);
+			_items_by_offset[offset] = _items.begin();
+			if (_items.size() > _capacity) {
+				_items_by_offset.erase(_items.back().first);
+				_items.pop_back();
+			}
+		}
+
+	private:
+		std::mutex _mutex;
+		size_t _capacity;
+		std::list<std::pair<uint64_t, std::string> > _items;
+		std::unordered_map<uint64_t, std::list<std::pair<uint64_t, std::string> >::iterator> _items_by_offset;
+	};
+
+	// sequential reader of a file that checksums what it reads
+	class checksum_reader {
+	public:
+		checksum_reader(std::istream& in) : _in(in), _hash(FNV1A_INIT) {}
+		bool read(char* buf, size_t size) {
+			if (!_in.read(buf, size))
+				return false;
+			_hash = fnv1a(_hash, buf, size);
+			return true;
+		}
+		template <typename T>
+		bool read_pod(T& value) {
+			return read(reinterpret_cast<char*>(&value), sizeof(T));
+		}
+		bool read_string(std::string& value, size_t size) {
+			value.resize(size);
+			return size == 0 || read(&value[0], size);
+		}
+		uint64_t hash() const { return _hash; }
+		void reset_hash() { _hash = FNV1A_INIT; }
+	private:
+		std::istream& _in;
+		uint64_t _hash;
+	};
+
+	// buffered sequential reader of the entries of an index segment in [begin, end)
+	class segment_reader {
+	public:
+		segment_reader(const db_file& file, uint64_t begin, uint64_t end)
+			: _file(file), _pos(begin), _end(end), _buf_pos(0), _hash(FNV1A_INIT) {}
+
+		bool at_end() const { return _pos >= _end && _buf_pos >= _buf.size(); }
+
+		bool read(char* out, size_t size) {
+			while (size > 0) {
+				if (_buf_pos >= _buf.size() && !fill())
+					return false;
+				size_t n = std::min(size, _buf.size() - _buf_pos);
+				memcpy(out, _buf.data() + _buf_pos, n);
+				_hash = fnv1a(_hash, out, n);
+				_buf_pos += n;
+				out += n;
+				size -= n;
+			}
+			return true;
+		}
+		template <typename T>
+		bool read_pod(T& value) {
+			return read(reinterpret_cast<char*>(&value), sizeof(T));
+		}
+
+		bool read_entry(std::string& key, index_entry& entry) {
+			uint32_t key_size = 0;
+			uint8_t removed = 0;
+			if (!read_pod(key_size))
+				return false;
+			key.resize(key_size);
+			if ((key_size > 0 && !read(&key[0], key_size)) || !read_pod(removed)
+				|| !read_pod(entry.offset) || !read_pod(entry.size))
+				return false;
+			entry.removed = removed != 0;
+			return true;
+		}
+
+		// offset in the file of the next byte to read
+		uint64_t position() const { return _pos - (_buf.size() - _buf_pos); }
+		uint64_t hash() const { return _hash; }
+
+	private:
+		bool fill() {
+			if (_pos >= _end)
+				return false;
+			_buf.resize(size_t(std::min<uint64_t>(FILE_BUFFER_SIZE, _end - _pos)));
+			_file.read(_pos, &_buf[0], _buf.size());
+			_pos += _buf.size();
+			_buf_pos = 0;
+			return true;
+		}
+
+	private:
+		const db_file& _file;
+		uint64_t _pos;
+		uint64_t _end;
+		std::string _buf;
+		size_t _buf_pos;
+		uint64_t _hash;
+	};
+
+	// immutable sorted file of index entries, only every SEGMENT_FENCE_INTERVAL th key and its offset is kept in memory
+	class index_segment {
+	public:
+		index_segment(uint64_t id, const std::string& path)
+			: _id(id), _file(new db_file(path, false)), _data_end(0), _count(0), _remove_on_close(false) {}
+		~index_segment() {
+			if (!_remove_on_close)
+				return;
+			const auto path = _file->path();
+			_file.reset(); // windows can't remove an open file
+			boost::system::error_code ec;
+			fs::remove(fs::path(path), ec);
+		}
+
+		uint64_t id() const { return _id; }
+		const db_file& file() const { return *_file; }
+		uint64_t data_end() const { return _data_end; }
+		// remove the file once no snapshot reads the segment
+		void remove_on_close() { _remove_on_close = true; }
+
+		// read the whole segment to check it and find its fences
+		bool load() {
+			uint64_t file_size = _file->size();
+			uint64_t magic = 0;
+			if (file_size < sizeof(uint64_t) * 3)
+				return false;
+			uint64_t data_end = file_size - sizeof(uint64_t) * 2;
+			segment_reader reader(*_file, 0, file_size);
+			if (!reader.read_pod(magic) || magic != SEGMENT_FILE_MAGIC)
+				return false;
+			std::string key;
+			index_entry entry;
+			uint64_t count = 0;
+			while (reader.position() < data_end) {
+				uint64_t entry_offset = reader.position();
+				if (!reader.read_entry(key, entry) || reader.position() > data_end)
+					return false;
+				if (count % SEGMENT_FENCE_INTERVAL == 0)
+					add_fence(key, entry_offset);
+				count++;
+			}
+			uint64_t stored_count = 0, checksum = 0;
+			if (!reader.read_pod(stored_count) || stored_count != count)
+				return false;
+			uint64_t expected = reader.hash();
+			if (!reader.read_pod(checksum) || checksum != expected)
+				return false;
+			_data_end = data_end;
+			_count = count;
+			return true;
+		}
+
+		// used by the writer, which knows the fences already
+		void add_fence(const std::string& key, uint64_t offset) {
+			_fence_keys.push_back(key);
+			_fence_offsets.push_back(offset);
+		}
+		void set_written(uint64_t data_end, uint64_t count) {
+			_data_end = data_end;
+			_count = count;
+		}
+
+		bool find(const std::string& key, index_entry& entry) const {
+			auto it = std::upper_bound(_fence_keys.begin(), _fence_keys.end(), key);
+			if (it == _fence_keys.begin())
+				return false;
+			size_t fence = size_t(it - _fence_keys.begin()) - 1;
+			uint64_t end = fence + 1 < _fence_offsets.size() ? _fence_offsets[fence + 1] : _data_end;
+			segment_reader reader(*_file, _fence_offsets[fence], end);
+			std::string entry_key;
+			while (!reader.at_end()) {
+				if (!reader.read_entry(entry_key, entry))
+					throw uvm::core::UvmException(std::string("read state db index segment failed ") + _file->path());
+				if (entry_key == key)
+					return true;
+				if (entry_key > key)
+					return false;
+			}
+			return false;
+		}
+
+		// offset of the first entry that can start with prefix
+		uint64_t seek(const std::string& prefix) const {
+			auto it = std::upper_bound(_fence_keys.begin(), _fence_keys.end(), prefix);
+			if (it == _fence_keys.begin())
+				return _fence_offsets.empty() ? _data_end : _fence_offsets.front();
+			return _fence_offsets[size_t(it - _fence_keys.begin()) - 1];
+		}
+
+	private:
+		uint64_t _id;
+		std::unique_ptr<db_file> _file;
+		uint64_t _data_end;
+		uint64_t _count;
+		bool _remove_on_close;
+		std::vector<std::string> _fence_keys;
+		std::vector<uint64_t> _fence_offsets;
+	};
+
+	// writes the entries of a new index segment in key order
+	class segment_writer {
+	public:
+		segment_writer(uint64_t id, const std::string& path)
+			: _path(path), _file(new db_file(path, true)), _offset(0), _count(0), _hash(FNV1A_INIT) {
+			_file->truncate(0);
+			_segment = std::make_shared<index_segment>(id, path);
+			append_pod(_buf, SEGMENT_FILE_MAGIC);
+		}
+
+		void add(const std::string& key, const index_entry& entry) {
+			if (_count % SEGMENT_FENCE_INTERVAL == 0)
+				_segment->add_fence(key, _offset + _buf.size());
+			append_pod(_buf, uint32_t(key.size()));
+			_buf.append(key);
+			append_pod(_buf, uint8_t(entry.removed ? 1 : 0));
+			append_pod(_buf, entry.offset);
+			append_pod(_buf, entry.size);
+			_count++;
+			if (_buf.size() >= FILE_BUFFER_SIZE)
+				flush();
+		}
+
+		// sync the segment to disk and return it
+		std::shared_ptr<index_segment> finish() {
+			uint64_t data_end = _offset + _buf.size();
+			append_pod(_buf, _count);
+			flush();
+			append_pod(_buf, _hash);
+			_file->write(_offset, _buf.data(), _buf.size());
+			_file->sync();
+			_file.reset();
+			_segment->set_written(data_end, _count);
+			return _segment;
+		}
+
+	private:
+		void flush() {
+			_hash = fnv1a(_hash, _buf.data(), _buf.size());
+			_file->write(_offset, _buf.data(), _buf.size());
+			_offset += _buf.size();
+			_buf.clear();
+		}
+
+	private:
+		std::string _path;
+		std::unique_ptr<db_file> _file;
+		std::shared_ptr<index_segment> _segment;
+		std::string _buf;
+		uint64_t _offset;
+		uint64_t _count;
+		uint64_t _hash;
+	};
+
+	// entries of one index source in key order, from the first key that can start with a prefix
+	class index_cursor {
+	public:
+		virtual ~index_cursor() {}
+		virtual bool valid() const = 0;
+		virtual const std::string& key() const = 0;
+		virtual const index_entry& entry() const = 0;
+		virtual void next() = 0;
+	};
+
+	class memtable_cursor : public index_cursor {
+	public:
+		memtable_cursor(const persistent_map<std::string, index_entry>& memtable, const std::string& prefix)
+			: _it(memtable.lower_bound(prefix)), _end(memtable.end()) {}
+		virtual bool valid() const { return _it != _end; }
+		virtual const std::string& key() const { return _it->first; }
+		virtual const index_entry& entry() const { return _it->second; }
+		virtual void next() { ++_it; }
+	private:
+		persistent_map<std::string, index_entry>::const_iterator _it;
+		persistent_map<std::string, index_entry>::const_iterator _end;
+	};
+
+	class segment_cursor : public index_cursor {
+	public:
+		segment_cursor(const index_segment& segment, const std::string& prefix)
+			: _reader(segment.file(), segment.seek(prefix), segment.data_end()), _valid(true) {
+			do {
+				next();
+			} while (_valid && _key < prefix);
+		}
+		virtual bool valid() const { return _valid; }
+		virtual const std::string& key() const { return _key; }
+		virtual const index_entry& entry() const { return _entry; }
+		virtual void next() {
+			if (_reader.at_end()) {
+				_valid = false;
+				return;
+			}
+			if (!_reader.read_entry(_key, _entry))
+				throw uvm::core::UvmException("read state db index segment failed");
+		}
+	private:
+		segment_reader _reader;
+		std::string _key;
+		index_entry _entry;
+		bool _valid;
+	};
+
+	// merge of index sources given newest first, a key in a newer source hides it in the older ones.
+	// removed keys are skipped
+	class merged_cursor {
+	public:
+		merged_cursor(std::vector<std::unique_ptr<index_cursor> >&& sources) : _sources(std::move(sources)), _current(nullptr) {
+			advance();
+		}
+		bool valid() const { return _current != nullptr; }
+		const std::string& key() const { return _current->key(); }
+		const index_entry& entry() const { return _current->entry(); }
+		void next() {
+			_current->next();
+			advance();
+		}
+	private:
+		void advance() {
+			for (;;) {
+				_current = nullptr;
+				for (auto& source : _sources) {
+					if (source->valid() && (!_current || source->key() < _current->key()))
+						_current = source.get();
+				}
+				if (!_current)
+					return;
+				for (auto& source : _sources) {
+					if (source.get() != _current && source->valid() && source->key() == _current->key())
+						source->next();
+				}
+				if (!_current->entry().removed)
+					return;
+				_current->next();
+			}
+		}
+	private:
+		std::vector<std::unique_ptr<index_cursor> > _sources;
+		index_cursor* _current;
+	};
+
+	state_db::state_db(const std::string& dir, size_t cache_capacity)
+		: _dir(dir), _is_snapshot(false), _log_size(0), _last_block(0), _index_log_size(0), _commits_since_index_saved(0),
+		_next_segment_id(1), _cache(std::make_shared<value_cache>(cache_capacity)) {
+		fs::create_directories(fs::path(dir));
+		_log_path = (fs::path(dir) / "state.log").string();
+		_index_path = (fs::path(dir) / "state.index").string();
+		uint64_t replay_from = 0;
+		if (load_index())
+			replay_from = _log_size;
+		else {
+			_segments.clear();
+			_log_size = 0;
+			_last_block = 0;
+			_index_log_size = 0;
+		}
+		remove_unused_segment_files();
+		_log.reset(new db_file(_log_path, true));
+		replay_log(replay_from);
+	}
+
+	state_db::state_db()
+		: _is_snapshot(true), _log_size(0), _last_block(0), _index_log_size(0), _commits_since_index_saved(0), _next_segment_id(1) {
+	}
+
+	state_db::~state_db() {
+		if (_is_snapshot)
+			return;
+		try {
+			save_index();
+		}
+		catch (...) {
+			// the log is the source of truth, the index is rebuilt on next open
+		}
+	}
+
+	std::shared_ptr<state_db> state_db::snapshot() const {
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		std::shared_ptr<state_db> db(new state_db());
+		db->_dir = _dir;
+		db->_log_path = _log_path;
+		db->_index_path = _index_path;
+		db->_log = _log;
+		db->_log_size = _log_size;
+		db->_last_block = _last_block;
+		db->_segments = _segments;
+		db->_memtable = _memtable;
+		db->_pending = _pending;
+		db->_cache = _cache;
+		return db;
+	}
+
+	bool state_db::is_snapshot() const {
+		return _is_snapshot;
+	}
+
+	void state_db::check_writable() const {
+		if (_is_snapshot)
+			throw uvm::core::UvmException(std::string("can't change a snapshot of state db ") + _dir);
+	}
+
+	std::string state_db::segment_path(uint64_t id) const {
+		char name[64];
+		snprintf(name, sizeof(name), "index-%020llu.seg", (unsigned long long) id);
+		return (fs::path(_dir) / name).string();
+	}
+
+	bool state_db::load_index() {
+		std::ifstream in(_index_path, std::ios::binary);
+		if (!in.is_open() || !fs::exists(_log_path))
+			return false;
+		checksum_reader reader(in);
+		uint64_t magic = 0, log_size = 0, last_block = 0, next_segment_id = 0;
+		uint32_t count = 0;
+		if (!reader.read_pod(magic) || magic != INDEX_FILE_MAGIC
+			|| !reader.read_pod(log_size) || !reader.read_pod(last_block)
+			|| !reader.read_pod(next_segment_id) || !reader.read_pod(count))
+			return false;
+		if (log_size > fs::file_size(_log_path))
+			return false; // index of a log that was truncated or replaced
+		std::vector<uint64_t> ids(count);
+		for (uint32_t i = 0; i < count; i++) {
+			if (!reader.read_pod(ids[i]))
+				return false;
+		}
+		uint64_t expected = reader.hash();
+		uint64_t checksum = 0;
+		if (!in.read(reinterpret_cast<char*>(&checksum), sizeof(checksum)) || checksum != expected)
+			return false;
+		std::vector<std::shared_ptr<index_segment> > segments;
+		try {
+			for (auto id : ids) {
+				auto segment = std::make_shared<index_segment>(id, segment_path(id));
+				if (!segment->load())
+					return false;
+				segments.push_back(segment);
+			}
+		}
+		catch (const uvm::core::UvmException&) {
+			return false;
+		}
+		_segments.swap(segments);
+		_log_size = log_size;
+		_last_block = last_block;
+		_index_log_size = log_size;
+		_next_segment_id = next_segment_id;
+		return true;
+	}
+
+	// segment files not listed in the index file are left by a crash or by a merge
+	void state_db::remove_unused_segment_files() {
+		for (fs::directory_iterator it(_dir), end; it != end; ++it) {
+			const auto& name = it->path().filename().string();
+			unsigned long long id = 0;
+			if (name.size() != strlen("index-00000000000000000000.seg") || sscanf(name.c_str(), "index-%llu.seg", &id) != 1)
+				continue;
+			bool used = false;
+			for (const auto& segment : _segments)
+				used = used || segment->id() == id;
+			if (!used)
+				fs::remove(it->path());
+			_next_segment_id = std::max<uint64_t>(_next_segment_id, id + 1);
+		}
+	}
+
+	void state_db::replay_log(uint64_t from) {
+		uint64_t file_size = _log->size();
+		uint64_t committed_end = from;
+		{
+			std::ifstream in(_log_path, std::ios::binary);
+			in.seekg(std::streamoff(from));
+			checksum_reader reader(in);
+			struct batch_item {
+				std::string key;
+				index_entry entry;
+			};
+			std::vector<batch_item> batch;
+			uint64_t pos = from;
+			while (pos < file_size) {
+				uint64_t batch_hash = reader.hash(); // the commit record is not part of its checksum
+				char type = 0;
+				if (!reader.read(&type, 1))
+					break;
+				if (type == LOG_RECORD_PUT || type == LOG_RECORD_REMOVE) {
+					uint32_t key_size = 0, value_size = 0;
+					batch_item item;
+					item.entry.removed = type == LOG_RECORD_REMOVE;
+					if (!reader.read_pod(key_size) || (!item.entry.removed && !reader.read_pod(value_size)))
+						break;
+					pos += 1 + sizeof(uint32_t) * (item.entry.removed ? 1 : 2) + key_size;
+					if (pos + value_size > file_size || !reader.read_string(item.key, key_size))
+						break;
+					item.entry.offset = pos;
+					item.entry.size = value_size;
+					if (!item.entry.removed) {
+						std::string value;
+						if (!reader.read_string(value, value_size))
+							break;
+						pos += value_size;
+					}
+					batch.push_back(std::move(item));
+				}
+				else if (type == LOG_RECORD_COMMIT) {
+					uint64_t expected = batch_hash;
+					uint64_t block_num = 0, checksum = 0;
+					if (!in.read(reinterpret_cast<char*>(&block_num), sizeof(block_num))
+						|| !in.read(reinterpret_cast<char*>(&checksum), sizeof(checksum))
+						|| checksum != expected)
+						break;
+					pos += 1 + sizeof(block_num) + sizeof(checksum);
+					for (auto& item : batch)
+						_memtable.set(item.key, item.entry);
+					batch.clear();
+					reader.reset_hash();
+					_last_block = block_num;
+					committed_end = pos;
+					_log_size = committed_end;
+					// keep the memory of a long replay bounded
+					if (++_commits_since_index_saved >= SAVE_INDEX_EVERY_COMMITS)
+						save_index();
+				}
+				else
+					break;
+			}
+		}
+		if (committed_end < file_size) {
+			_log->truncate(committed_end); // drop the batch of an interrupted commit
+			_log->sync();
+		}
+		_log_size = committed_end;
+	}
+
+	std::string state_db::read_value(const index_entry& entry) {
+		std::string value;
+		if (_cache->get(entry.offset, value))
+			return value;
+		value.resize(entry.size);
+		if (entry.size > 0)
+			_log->read(entry.offset, &value[0], entry.size);
+		_cache->put(entry.offset, value);
+		return value;
+	}
+
+	bool state_db::find_entry(const std::string& key, index_entry& entry) {
+		auto memtable_entry = _memtable.find(key);
+		if (memtable_entry) {
+			entry = *memtable_entry;
+			return !entry.removed;
+		}
+		for (auto segment = _segments.rbegin(); segment != _segments.rend(); ++segment) {
+			if ((*segment)->find(key, entry))
+				return !entry.removed;
+		}
+		return false;
+	}
+
+	bool state_db::get(const std::string& key, std::string& value) {
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		auto pending_it = _pending.find(key);
+		if (pending_it != _pending.end()) {
+			if (pending_it->second.removed)
+				return false;
+			value = pending_it->second.value;
+			return true;
+		}
+		index_entry entry;
+		if (!find_entry(key, entry))
+			return false;
+		value = read_value(entry);
+		return true;
+	}
+
+	void state_db::put(const std::string& key, const std::string& value) {
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		check_writable();
+		auto& change = _pending[key];
+		change.removed = false;
+		change.value = value;
+	}
+
+	void state_db::remove(const std::string& key) {
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		check_writable();
+		auto& change = _pending[key];
+		change.removed = true;
+		change.value.clear();
+	}
+
+	void state_db::scan(const std::string& prefix, const scan_callback& fn) {
+		std::vector<std::unique_ptr<index_cursor> > sources;
+		sources.emplace_back(new memtable_cursor(_memtable, prefix));
+		for (auto segment = _segments.rbegin(); segment != _segments.rend(); ++segment)
+			sources.emplace_back(new segment_cursor(**segment, prefix));
+		merged_cursor committed(std::move(sources));
+		auto staged = _pending.lower_bound(prefix);
+		for (;;) {
+			bool has_committed = committed.valid() && has_prefix(committed.key(), prefix);
+			bool has_staged = staged != _pending.end() && has_prefix(staged->first, prefix);
+			if (!has_committed && !has_staged)
+				return;
+			if (has_staged && (!has_committed || staged->first <= committed.key())) {
+				if (has_committed && staged->first == committed.key())
+					committed.next();
+				const auto& change = *staged++;
+				if (!change.second.removed && !fn(change.first, &change.second, nullptr))
+					return;
+			}
+			else {
+				if (!fn(committed.key(), nullptr, &committed.entry()))
+					return;
+				committed.next();
+			}
+		}
+	}
+
+	void state_db::for_each_with_prefix(const std::string& prefix, const std::function<bool(const std::string&, const std::string&)>& fn) {
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		scan(prefix, [&](const std::string& key, const pending_change* staged, const index_entry* committed) -> bool {
+			if (staged)
+				return fn(key, staged->value);
+			return fn(key, read_value(*committed));
+		});
+	}
+
+	std::map<std::string, std::string> state_db::get_with_prefix(const std::string& prefix) {
+		std::map<std::string, std::string> result;
+		for_each_with_prefix(prefix, [&](const std::string& key, const std::string& value) -> bool {
+			result.emplace_hint(result.end(), key, value);
+			return true;
+		});
+		return result;
+	}
+
+	size_t state_db::count_with_prefix(const std::string& prefix) {
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		size_t count = 0;
+		scan(prefix, [&](const std::string&, const pending_change*, const index_entry*) -> bool {
+			count++;
+			return true;
+		});
+		return count;
+	}
+
+	void state_db::commit(uint64_t block_num) {
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		check_writable();
+		std::string batch;
+		std::vector<index_entry> entries;
+		for (const auto& p : _pending) {
+			const auto& key = p.first;
+			index_entry entry;
+			entry.removed = p.second.removed;
+			entry.offset = 0;
+			entry.size = 0;
+			if (p.second.removed) {
+				batch.push_back(LOG_RECORD_REMOVE);
+				append_pod(batch, uint32_t(key.size()));
+				batch.append(key);
+			}
+			else {
+				const auto& value = p.second.value;
+				batch.push_back(LOG_RECORD_PUT);
+				append_pod(batch, uint32_t(key.size()));
+				append_pod(batch, uint32_t(value.size()));
+				batch.append(key);
+				entry.offset = _log_size + batch.size();
+				entry.size = uint32_t(value.size());
+				batch.append(value);
+			}
+			entries.push_back(entry);
+		}
+		std::string commit_record;
+		commit_record.push_back(LOG_RECORD_COMMIT);
+		append_pod(commit_record, block_num);
+		append_pod(commit_record, fnv1a(FNV1A_INIT, batch.data(), batch.size()));
+
+		try {
+			// the batch must be on disk before the record that makes it committed
+			_log->write(_log_size, batch.data(), batch.size());
+			_log->sync();
+			_log->write(_log_size + batch.size(), commit_record.data(), commit_record.size());
+			_log->sync();
+		}
+		catch (const uvm::core::UvmException&) {
+			// leave the log as it was before this commit
+			_log->truncate(_log_size);
+			throw;
+		}
+		_log_size += batch.size() + commit_record.size();
+		_last_block = block_num;
+
+		size_t entry_index = 0;
+		for (const auto& p : _pending)
+			_memtable.set(p.first, entries[entry_index++]);
+		_pending.clear();
+
+		if (++_commits_since_index_saved >= SAVE_INDEX_EVERY_COMMITS)
+			save_index();
+	}
+
+	void state_db::rollback() {
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		check_writable();
+		_pending.clear();
+	}
+
+	uint64_t state_db::last_committed_block() const {
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		return _last_block;
+	}
+
+	void state_db::write_index_file() {
+		std::string data;
+		append_pod(data, INDEX_FILE_MAGIC);
+		append_pod(data, _log_size);
+		append_pod(data, _last_block);
+		append_pod(data, _next_segment_id);
+		append_pod(data, uint32_t(_segments.size()));
+		for (const auto& segment : _segments)
+			append_pod(data, segment->id());
+		append_pod(data, fnv1a(FNV1A_INIT, data.data(), data.size()));
+		write_file_atomically(_dir, _index_path, data);
+		_index_log_size = _log_size;
+	}
+
+	// merge all segments into one, streaming so only the fences are in memory
+	void state_db::compact_segments() {
+		std::vector<std::unique_ptr<index_cursor> > sources;
+		for (auto segment = _segments.rbegin(); segment != _segments.rend(); ++segment)
+			sources.emplace_back(new segment_cursor(**segment, ""));
+		merged_cursor merged(std::move(sources)); // nothing older than the oldest segment, removed keys are dropped
+		uint64_t id = _next_segment_id++;
+		segment_writer writer(id, segment_path(id));
+		for (; merged.valid(); merged.next())
+			writer.add(merged.key(), merged.entry());
+		auto old_segments = _segments;
+		_segments.clear();
+		_segments.push_back(writer.finish());
+		write_index_file();
+		for (const auto& segment : old_segments)
+			segment->remove_on_close();
+	}
+
+	void state_db::save_index() {
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		check_writable();
+		if (_memtable.empty() && _index_log_size == _log_size)
+			return;
+		if (!_memtable.empty()) {
+			uint64_t id = _next_segment_id++;
+			segment_writer writer(id, segment_path(id));
+			for (const auto& p : _memtable)
+				writer.add(p.first, p.second);
+			_segments.push_back(writer.finish());
+		}
+		write_index_file();
+		_memtable.clear();
+		_commits_since_index_saved = 0;
+		if (_segments.size() > MAX_INDEX_SEGMENTS)
+			compact_segments();
+	}
+
+}
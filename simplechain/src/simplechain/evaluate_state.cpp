@@ -17,7 +17,7 @@ namespace simplechain {
 		return current_tx;
 	}
 	StorageDataType evaluate_state::get_storage(const std::string& contract_address, const std::string& key) const {
-		// TODO: read from parent evaluate_state first
+		// changes of this evaluation first, chain reads the pending tx/block state layers before committed state
 		auto it1 = invoke_contract_result.storage_changes.find(contract_address);
 		if (it1 != invoke_contract_result.storage_changes.end()) {
 			auto& changes = it1->second;
@@ -90,25 +90,14 @@ namespace simplechain {
 	}
 
 	void evaluate_state::update_account_asset_balance(const std::string& account_address, asset_id_t asset_id, int64_t balance_change) {
-		for (auto& p : invoke_contract_result.account_balances_changes) {
-			if (p.first.first == account_address && p.first.second == asset_id) {
-				p.second += balance_change;
-				return;
-			}
-		}
-		auto key = std::make_pair(account_address, asset_id);
-		invoke_contract_result.account_balances_changes[key] = balance_change;
+		invoke_contract_result.account_balances_changes[std::make_pair(account_address, asset_id)] += balance_change;
 	}
 
 	share_type evaluate_state::get_account_asset_balance(const std::string& account_address, asset_id_t asset_id) const {
 		auto balance = amount_change_type(chain->get_account_asset_balance(account_address, asset_id));
-		for (const auto& p : invoke_contract_result.account_balances_changes) {
-			if (p.first.first == account_address && p.first.second == asset_id) {
-				balance += p.second;
-				break;
-			}
-		}
-		// TODO: use parent evaluate_state's cache to update balance query result
+		auto it = invoke_contract_result.account_balances_changes.find(std::make_pair(account_address, asset_id));
+		if (it != invoke_contract_result.account_balances_changes.end())
+			balance += it->second;
 		return share_type(balance);
 	}
 
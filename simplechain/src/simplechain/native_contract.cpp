@@ -20,12 +20,9 @@ namespace simplechain {
 
 	void native_contract_store::set_contract_storage(const address& contract_address, const std::string& storage_name, const StorageDataType& value)
 	{
-		if (_contract_invoke_result.storage_changes.find(contract_address) == _contract_invoke_result.storage_changes.end())
-		{
-			_contract_invoke_result.storage_changes[contract_address] = contract_storage_changes_type();
-		}
 		auto& storage_changes = _contract_invoke_result.storage_changes[contract_address];
-		if (storage_changes.find(storage_name) == storage_changes.end())
+		auto change_it = storage_changes.find(storage_name);
+		if (change_it == storage_changes.end())
 		{
 			StorageDataChangeType change;
 			change.after = value;
@@ -36,11 +33,11 @@ namespace simplechain {
 			auto diff = differ.diff(before_cbor, after_cbor);
 			change.storage_diff.storage_data = cbor_encode(diff->value());
 			change.before = before;
-			storage_changes[storage_name] = change;
+			storage_changes.emplace(storage_name, change);
 		}
 		else
 		{
-			auto& change = storage_changes[storage_name];
+			auto& change = change_it->second;
 			auto before = change.before;
 			auto after = value;
 			change.after = after;
@@ -64,28 +61,14 @@ namespace simplechain {
 			throw_error(std::string("invalid asset_symbol ") + asset_symbol);
 		}
 		auto asset_id = a->asset_id;
-		bool contract_balance_pair_found = false;
-		bool to_pair_found = false;
-		for (auto& p : _contract_invoke_result.account_balances_changes) {
-			if (p.first.first == from_contract_address && p.first.second == asset_id) {
-				p.second -= int64_t(amount);
-				contract_balance_pair_found = true;
-				continue;
-			}
-			if (p.first.first == to_address && p.first.second == asset_id) {
-				p.second += amount;
-				to_pair_found = true;
-				continue;
-			}
-		}
-		if (!contract_balance_pair_found) {
-			auto p = std::make_pair(from_contract_address, asset_id);
-			_contract_invoke_result.account_balances_changes[p] = - int64_t(amount);
-		}
-		if (!to_pair_found) {
-			auto p = std::make_pair(to_address, asset_id);
-			_contract_invoke_result.account_balances_changes[p] = int64_t(amount);
+		auto& changes = _contract_invoke_result.account_balances_changes;
+		if (from_contract_address == to_address) {
+			// kept as before: a transfer to itself leaves only the incoming amount, which validate() rejects
+			changes[std::make_pair(to_address, asset_id)] = int64_t(amount);
+			return;
 		}
+		changes[std::make_pair(from_contract_address, asset_id)] -= int64_t(amount);
+		changes[std::make_pair(to_address, asset_id)] += int64_t(amount);
 	}
 
 	void native_contract_store::fast_map_set(const address& contract_address, const std::string& storage_name, const std::string& key, cbor::CborObjectP cbor_value) {
@@ -95,16 +78,17 @@ namespace simplechain {
 
 	StorageDataType native_contract_store::get_contract_storage(const address& contract_address, const std::string& storage_name) const
 	{
-		if (_contract_invoke_result.storage_changes.find(contract_address) == _contract_invoke_result.storage_changes.end())
+		auto contract_it = _contract_invoke_result.storage_changes.find(contract_address);
+		if (contract_it == _contract_invoke_result.storage_changes.end())
 		{
 			return _evaluate->get_storage(contract_address, storage_name);
 		}
-		auto& storage_changes = _contract_invoke_result.storage_changes.at(contract_address);
-		if (storage_changes.find(storage_name) == storage_changes.end())
+		auto change_it = contract_it->second.find(storage_name);
+		if (change_it == contract_it->second.end())
 		{
 			return _evaluate->get_storage(contract_address, storage_name);
 		}
-		return storage_changes.at(storage_name).after;
+		return change_it->second.after;
 	}
 
 	cbor::CborObjectP native_contract_store::get_contract_storage_cbor(const address& contract_address, const std::string& storage_name) const {
@@ -191,12 +175,12 @@ namespace simplechain {
 
 	bool native_contract_finder::has_native_contract_with_key(const std::string& key)
 	{
-		std::vector<std::string> native_contract_keys = {
+		static const std::set<std::string> native_contract_keys = {
 			// demo_native_contract::native_contract_key(),
 			token_native_contract::native_contract_key(),
 			exchange_native_contract::native_contract_key()
 		};
-		return std::find(native_contract_keys.begin(), native_contract_keys.end(), key) != native_contract_keys.end();
+		return native_contract_keys.find(key) != native_contract_keys.end();
 	}
 	shared_ptr<native_contract_interface> native_contract_finder::create_native_contract_by_key(evaluate_state* evaluate, const std::string& key, const address& contract_address)
 	{
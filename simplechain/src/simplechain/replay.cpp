@@ -0,0 +1,128 @@
+#include <simplechain/replay.h>
+#include <simplechain/blockchain.h>
+#include <uvm/exceptions.h>
+#include <fc/io/raw.hpp>
+#include <fstream>
+#include <set>
+
+namespace simplechain {
+
+	void append_recorded_block(const std::string& path, const recorded_block& recorded) {
+		std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::app);
+		if (!out.is_open())
+			throw uvm::core::UvmException(std::string("can't open recorded blocks file ") + path);
+		const auto& data = fc::raw::pack(recorded);
+		char size_bytes[4];
+		for (size_t i = 0; i < 4; ++i)
+			size_bytes[i] = (char)((data.size() >> (8 * i)) & 0xff);
+		out.write(size_bytes, 4);
+		out.write(data.data(), data.size());
+		if (!out)
+			throw uvm::core::UvmException(std::string("write recorded blocks file ") + path + " error");
+	}
+
+	std::vector<recorded_block> read_recorded_blocks(const std::string& path) {
+		std::ifstream in(path, std::ios::in | std::ios::binary);
+		if (!in.is_open())
+			throw uvm::core::UvmException(std::string("can't open recorded blocks file ") + path);
+		std::vector<recorded_block> blocks;
+		unsigned char size_bytes[4];
+		while (in.read((char*)size_bytes, 4)) {
+			uint32_t size = 0;
+			for (size_t i = 0; i < 4; ++i)
+				size |= ((uint32_t)size_bytes[i]) << (8 * i);
+			std::vector<char> data(size);
+			if (size > 0 && !in.read(data.data(), size))
+				throw uvm::core::UvmException(std::string("recorded blocks file ") + path + " is truncated");
+			blocks.push_back(fc::raw::unpack<recorded_block>(data));
+		}
+		if (in.gcount() != 0)
+			throw uvm::core::UvmException(std::string("recorded blocks file ") + path + " is truncated");
+		return blocks;
+	}
+
+	// the recorded txs left out of the produced block failed when replayed
+	static std::string block_mismatch(const block& recorded, const block& produced) {
+		std::string result = std::string("block #") + std::to_string(recorded.block_number) + " recorded with hash " + recorded.block_hash()
+			+ " but replayed as block #" + std::to_string(produced.block_number) + " with hash " + produced.block_hash();
+		std::set<std::string> produced_txs;
+		for (const auto& tx : produced.txs)
+			produced_txs.insert(tx.tx_hash());
+		for (const auto& tx : recorded.txs) {
+			if (produced_txs.find(tx.tx_hash()) == produced_txs.end())
+				result += std::string(", tx ") + tx.tx_hash() + " failed";
+		}
+		return result;
+	}
+
+	replay_result replay_blocks(blockchain& chain, const std::vector<recorded_block>& blocks) {
+		replay_result result;
+		tx_phase_recorder recorder;
+		recorder.install();
+		try {
+			for (const auto& recorded : blocks) {
+				for (const auto& tx : recorded.blk.txs) {
+					chain.accept_transaction_to_mempool(tx);
+				}
+				chain.generate_block(recorded.blk.block_time);
+				++result.blocks_count;
+				const auto& produced = chain.latest_block();
+				if (produced.block_hash() != recorded.blk.block_hash()) {
+					result.mismatch = block_mismatch(recorded.blk, produced);
+					break;
+				}
+				const auto& state_hash = chain.get_state_hash();
+				if (state_hash != recorded.state_hash) {
+					result.mismatch = std::string("state hash after block #") + std::to_string(recorded.blk.block_number)
+						+ " recorded as " + recorded.state_hash + " but replayed as " + state_hash;
+					break;
+				}
+			}
+		}
+		catch (...) {
+			recorder.uninstall();
+			throw;
+		}
+		recorder.uninstall();
+		result.txs = recorder.txs();
+		for (const auto& tx : result.txs) {
+			if (!tx.succeed)
+				++result.failed_txs_count;
+			result.total_ns += tx.total_ns;
+			for (size_t i = 0; i < tx_phases_count; ++i)
+				result.phase_ns[i] += tx.phase_ns[i];
+		}
+		result.state_hash = chain.get_state_hash();
+		return result;
+	}
+
+	static fc::mutable_variant_object phases_to_json(const int64_t* phase_ns) {
+		fc::mutable_variant_object phases;
+		for (size_t i = 0; i < tx_phases_count; ++i) {
+			phases[tx_phase_name((tx_phase)i)] = phase_ns[i];
+		}
+		return phases;
+	}
+
+	fc::mutable_variant_object replay_result::to_json() const {
+		fc::mutable_variant_object info;
+		info["blocks_count"] = blocks_count;
+		info["txs_count"] = txs.size();
+		info["failed_txs_count"] = failed_txs_count;
+		info["total_ns"] = total_ns;
+		info["phases_ns"] = phases_to_json(phase_ns);
+		fc::variants txs_json;
+		for (const auto& tx : txs) {
+			fc::mutable_variant_object tx_json;
+			tx_json["tx_id"] = tx.tx_id;
+			tx_json["succeed"] = tx.succeed;
+			tx_json["total_ns"] = tx.total_ns;
+			tx_json["phases_ns"] = phases_to_json(tx.phase_ns);
+			txs_json.push_back(tx_json);
+		}
+		info["txs"] = txs_json;
+		info["state_hash"] = state_hash;
+		info["mismatch"] = mismatch;
+		return info;
+	}
+}
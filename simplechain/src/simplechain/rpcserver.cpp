@@ -4,6 +4,8 @@
 #include <memory>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <set>
 #include <fc/io/json.hpp>
 
 namespace simplechain {
@@ -22,12 +24,15 @@ namespace simplechain {
 	{ "create_contract", &create_contract },
 	{ "invoke_contract", &invoke_contract },
 	{ "invoke_contract_offline", &invoke_contract_offline },
+	{ "profile_invoke_contract", &profile_invoke_contract },
 	{ "exit", &exit_chain },
 	{ "generate_block", &generate_block },
+	{ "undo_block", &undo_block },
 	{ "get_block_by_height", &get_block_by_height },
 	{ "get_tx", &get_tx },
 	{ "get_tx_receipt", &get_tx_receipt },
 	{ "get_chain_state", &get_chain_state },
+	{ "get_signature_cache_stats", &get_signature_cache_stats },
 	{ "list_accounts", &list_accounts },
 	{ "list_assets", &list_assets },
 	{ "list_contracts", &list_contracts },
@@ -61,12 +66,115 @@ namespace simplechain {
 
 	};
 
-	RpcServer::RpcServer(blockchain* chain, int port)
-		: _chain(chain), _port(port) {
+	// methods not changing chain state, they run concurrently in the read threads
+	static const std::set<std::string> readonly_rpc_methods = {
+		"get_account",
+		"invoke_contract_offline",
+		"profile_invoke_contract",
+		"get_block_by_height",
+		"get_tx",
+		"get_tx_receipt",
+		"get_chain_state",
+		"get_signature_cache_stats",
+		"list_accounts",
+		"list_assets",
+		"list_contracts",
+		"get_contract_info",
+		"get_account_balances",
+		"get_contract_storages",
+		"get_storage"
+	};
+
+	// methods with large results, their responses are streamed with chunked encoding
+	static const std::set<std::string> streamed_rpc_methods = {
+		"get_block_by_height",
+		"get_contract_storages",
+		"list_accounts",
+		"list_contracts"
+	};
+
+	// bytes buffered before sending a chunk of streamed response
+	static const size_t RPC_RESPONSE_CHUNK_SIZE = 64 * 1024;
+	// objects and arrays above this depth of a streamed result are written member by member
+	static const int RPC_STREAMED_JSON_DEPTH = 2;
+
+	RpcLatencyHistogram::RpcLatencyHistogram()
+		: _counts(bucket_bounds().size() + 1, 0), _count(0), _total_micros(0), _max_micros(0) {
+	}
+
+	const std::vector<uint64_t>& RpcLatencyHistogram::bucket_bounds() {
+		static const std::vector<uint64_t> bounds = {
+			100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000
+		};
+		return bounds;
+	}
+
+	void RpcLatencyHistogram::record(uint64_t micros) {
+		const auto& bounds = bucket_bounds();
+		auto bucket = std::lower_bound(bounds.begin(), bounds.end(), micros) - bounds.begin();
+		++_counts[bucket];
+		++_count;
+		_total_micros += micros;
+		_max_micros = std::max(_max_micros, micros);
+	}
+
+	fc::mutable_variant_object RpcLatencyHistogram::to_json() const {
+		fc::mutable_variant_object res;
+		res["count"] = _count;
+		res["total_us"] = _total_micros;
+		res["max_us"] = _max_micros;
+		fc::variants buckets;
+		const auto& bounds = bucket_bounds();
+		for (size_t i = 0; i < _counts.size(); i++) {
+			fc::mutable_variant_object bucket;
+			bucket["le_us"] = i < bounds.size() ? fc::variant(bounds[i]) : fc::variant("inf");
+			bucket["count"] = _counts[i];
+			buckets.push_back(bucket);
+		}
+		res["buckets"] = buckets;
+		return res;
+	}
+
+	RpcServer::RpcServer(blockchain* chain, int port, size_t read_threads_count)
+		: _chain(chain), _port(port), _read_threads_count(read_threads_count) {
 		_server = std::make_shared<HttpServer>();
+		if (_read_threads_count == 0)
+			_read_threads_count = std::max(1u, std::thread::hardware_concurrency());
 	}
 	RpcServer::~RpcServer() {
+		_read_service_work.reset();
+		_read_service.stop();
+		for (auto& t : _read_threads) {
+			if (t.joinable())
+				t.join();
+		}
+		_write_service_work.reset();
+		_write_service.stop();
+		if (_write_thread.joinable())
+			_write_thread.join();
+	}
+
+	std::shared_ptr<blockchain> RpcServer::chain_snapshot() {
+		return std::atomic_load(&_chain_snapshot);
+	}
+
+	void RpcServer::publish_chain_snapshot() {
+		std::atomic_store(&_chain_snapshot, _chain->snapshot());
+	}
+
+	void RpcServer::record_latency(const std::string& method, std::chrono::steady_clock::time_point start_time) {
+		auto micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+		std::lock_guard<std::mutex> lock(_latencies_mutex);
+		_latencies[method].record(uint64_t(micros));
+	}
 
+	fc::mutable_variant_object RpcServer::latencies_to_json() {
+		std::lock_guard<std::mutex> lock(_latencies_mutex);
+		fc::mutable_variant_object res;
+		for (const auto& p : _latencies) {
+			res[p.first] = p.second.to_json();
+		}
+		return res;
 	}
 
 	static std::string read_all_string_from_stream(const std::istream& stream) {
@@ -86,8 +194,7 @@ namespace simplechain {
 		}
 	}
 
-	static RpcRequest read_rpc_request_from_stream(const std::istream& stream) {
-		auto json_val = read_json_from_stream(stream);
+	static RpcRequest read_rpc_request(const fc::variant& json_val) {
 		params_assert(json_val.is_object());
 		auto json_obj = json_val.as<fc::mutable_variant_object>();
 		params_assert(json_obj.find("method") != json_obj.end() && json_obj["method"].is_string());
@@ -99,6 +206,10 @@ namespace simplechain {
 		RpcRequest req;
 		req.method = method;
 		req.params = params;
+		if (json_obj.find("id") != json_obj.end()) {
+			req.has_id = true;
+			req.id = json_obj["id"];
+		}
 		return req;
 	}
 
@@ -111,47 +222,302 @@ namespace simplechain {
 			<< str;
 	}
 
-	static void send_rpc_response(shared_ptr<HttpServer::Response> response, const RpcResponse& rpc_response) {
+	// writes json to a http response with chunked encoding, a chunk is sent once it's large enough
+	class ChunkedJsonWriter {
+	private:
+		shared_ptr<HttpServer::Response> _response;
+		std::string _buffer;
+	public:
+		explicit ChunkedJsonWriter(shared_ptr<HttpServer::Response> response) : _response(response) {
+			*_response << "HTTP/1.1 200 OK\r\n"
+				<< "Access-Control-Allow-Origin: *" << "\r\n"
+				<< "Access-Control-Allow-Headers: *" << "\r\n"
+				<< "Access-Control-Allow-Methods: *" << "\r\n"
+				<< "Content-Type: application/json" << "\r\n"
+				<< "Transfer-Encoding: chunked" << "\r\n\r\n";
+		}
+
+		void write(const std::string& str) {
+			_buffer += str;
+			if (_buffer.size() >= RPC_RESPONSE_CHUNK_SIZE)
+				flush();
+		}
+
+		// objects and arrays not deeper than RPC_STREAMED_JSON_DEPTH are written member by member,
+		// so the json string of a large value is never built at once
+		void write_variant(const fc::variant& value, int depth = 0) {
+			if (depth < RPC_STREAMED_JSON_DEPTH && value.is_object()) {
+				write("{");
+				bool first = true;
+				for (const auto& entry : value.get_object()) {
+					if (!first)
+						write(",");
+					first = false;
+					write(fc::json::to_string(fc::variant(entry.key())));
+					write(":");
+					write_variant(entry.value(), depth + 1);
+				}
+				write("}");
+			}
+			else if (depth < RPC_STREAMED_JSON_DEPTH && value.is_array()) {
+				write("[");
+				bool first = true;
+				for (const auto& item : value.get_array()) {
+					if (!first)
+						write(",");
+					first = false;
+					write_variant(item, depth + 1);
+				}
+				write("]");
+			}
+			else {
+				write(fc::json::to_string(value));
+			}
+		}
+
+		void finish() {
+			flush();
+			*_response << "0\r\n\r\n";
+		}
+
+	private:
+		void flush() {
+			if (_buffer.empty())
+				return;
+			*_response << std::hex << _buffer.size() << std::dec << "\r\n" << _buffer << "\r\n";
+			_response->send();
+			_buffer.clear();
+		}
+	};
+
+	static fc::mutable_variant_object rpc_response_to_json(const RpcRequest& rpc_request, const RpcResponse& rpc_response, bool with_result = true) {
 		fc::mutable_variant_object res_json;
-		res_json["result"] = rpc_response.result;
+		if (rpc_request.has_id)
+			res_json["id"] = rpc_request.id;
+		if (with_result)
+			res_json["result"] = rpc_response.result;
 		res_json["code"] = rpc_response.error_code;
 		if (rpc_response.has_error) {
 			res_json["message"] = rpc_response.error;
 			res_json["error"] = rpc_response.error;
 		}
-		auto res_json_str = fc::json::to_string(res_json);
+		return res_json;
+	}
+
+	static void write_rpc_response(ChunkedJsonWriter& writer, const RpcRequest& rpc_request, const RpcResponse& rpc_response) {
+		// result is streamed, other fields are small
+		const auto& res_json = fc::json::to_string(rpc_response_to_json(rpc_request, rpc_response, false));
+		writer.write("{\"result\":");
+		writer.write_variant(rpc_response.result);
+		writer.write(",");
+		writer.write(res_json.substr(1));
+	}
+
+	static void send_rpc_response(shared_ptr<HttpServer::Response> response, const RpcRequest& rpc_request, const RpcResponse& rpc_response) {
+		if (streamed_rpc_methods.find(rpc_request.method) != streamed_rpc_methods.end()) {
+			ChunkedJsonWriter writer(response);
+			write_rpc_response(writer, rpc_request, rpc_response);
+			writer.finish();
+			return;
+		}
+		auto res_json_str = fc::json::to_string(rpc_response_to_json(rpc_request, rpc_response));
 		send_string_to_response(response, res_json_str);
 	}
 
+	// items without id are notifications and get no response, a batch of only notifications gets an empty body
+	static void send_rpc_batch_response(shared_ptr<HttpServer::Response> response, const std::vector<RpcRequest>& rpc_requests, const std::vector<RpcResponse>& rpc_responses) {
+		if (std::none_of(rpc_requests.begin(), rpc_requests.end(), [](const RpcRequest& req) { return req.has_id; })) {
+			send_string_to_response(response, "");
+			return;
+		}
+		ChunkedJsonWriter writer(response);
+		writer.write("[");
+		bool first = true;
+		for (size_t i = 0; i < rpc_responses.size(); i++) {
+			if (!rpc_requests[i].has_id)
+				continue;
+			if (!first)
+				writer.write(",");
+			first = false;
+			write_rpc_response(writer, rpc_requests[i], rpc_responses[i]);
+		}
+		writer.write("]");
+		writer.finish();
+	}
+
+	static RpcResponse rpc_error_response(const std::string& error) {
+		RpcResponse rpc_res;
+		rpc_res.has_error = true;
+		rpc_res.error = error;
+		rpc_res.error_code = 100;
+		return rpc_res;
+	}
+
+	static RpcResponse call_rpc_method(blockchain* chain, HttpServer* server, const RpcRequest& rpc_req) {
+		RpcResponse rpc_res;
+		const auto& handler = rpc_methods.at(rpc_req.method);
+		try {
+			auto result = handler(chain, server, rpc_req.params);
+			rpc_res.result = result;
+		}
+		catch (const fc::exception& e) {
+			rpc_res.has_error = true;
+			rpc_res.error = e.to_detail_string();
+			rpc_res.error_code = 100;
+		}
+		catch (const std::exception& e) {
+			rpc_res.has_error = true;
+			rpc_res.error = e.what();
+			rpc_res.error_code = 100;
+		}
+		catch (...) {
+			rpc_res = rpc_error_response("unknown error of rpc method " + rpc_req.method);
+		}
+		return rpc_res;
+	}
+
+	struct RpcBatch {
+		std::vector<RpcRequest> requests;
+		std::vector<RpcResponse> responses;
+		std::vector<bool> valid;
+		std::atomic<size_t> pending;
+	};
+
+	void RpcServer::handle_rpc_batch(shared_ptr<HttpServer::Response> response, const fc::variants& items, std::chrono::steady_clock::time_point start_time) {
+		params_assert(!items.empty(), "empty rpc batch");
+		auto batch = std::make_shared<RpcBatch>();
+		batch->requests.resize(items.size());
+		batch->responses.resize(items.size());
+		batch->valid.resize(items.size(), false);
+		size_t valid_count = 0;
+		bool all_readonly = true;
+		for (size_t i = 0; i < items.size(); i++) {
+			try {
+				batch->requests[i] = read_rpc_request(items[i]);
+				params_assert(rpc_methods.find(batch->requests[i].method) != rpc_methods.end());
+				batch->valid[i] = true;
+				++valid_count;
+				if (readonly_rpc_methods.find(batch->requests[i].method) == readonly_rpc_methods.end())
+					all_readonly = false;
+			}
+			catch (const std::exception& e) {
+				batch->responses[i] = rpc_error_response(e.what());
+			}
+			catch (...) {
+				batch->responses[i] = rpc_error_response("invalid rpc request");
+			}
+			if (!batch->valid[i] && !batch->requests[i].has_id) {
+				// an invalid item is answered with its id if it has one, or null
+				batch->requests[i].has_id = true;
+				if (items[i].is_object()) {
+					const auto& item_obj = items[i].get_object();
+					auto id_it = item_obj.find("id");
+					if (id_it != item_obj.end())
+						batch->requests[i].id = id_it->value();
+				}
+			}
+		}
+		if (all_readonly && valid_count > 0) {
+			batch->pending = valid_count;
+			auto chain = chain_snapshot(); // all items see the same state
+			for (size_t i = 0; i < items.size(); i++) {
+				if (!batch->valid[i])
+					continue;
+				_read_service.post([this, response, batch, i, start_time, chain]() {
+					try {
+						batch->responses[i] = call_rpc_method(chain.get(), _server.get(), batch->requests[i]);
+					}
+					catch (...) {
+						batch->responses[i] = rpc_error_response("rpc internal error");
+					}
+					record_latency(batch->requests[i].method, start_time);
+					if (--batch->pending > 0)
+						return;
+					try {
+						send_rpc_batch_response(response, batch->requests, batch->responses);
+					}
+					catch (...) {
+						// the connection is gone, nothing to answer
+					}
+				});
+			}
+			return;
+		}
+		_write_service.post([this, response, batch, start_time]() {
+			for (size_t i = 0; i < batch->requests.size(); i++) {
+				if (!batch->valid[i])
+					continue;
+				batch->responses[i] = call_rpc_method(_chain, _server.get(), batch->requests[i]);
+				record_latency(batch->requests[i].method, start_time);
+			}
+			try {
+				publish_chain_snapshot();
+				send_rpc_batch_response(response, batch->requests, batch->responses);
+			}
+			catch (...) {
+				// the connection is gone, nothing to answer
+			}
+		});
+	}
+
 	void RpcServer::start() {
 		_server->config.address = "0.0.0.0";
 		_server->config.port = _port;
 
+		publish_chain_snapshot();
+		_read_service_work = std::make_shared<boost::asio::io_service::work>(_read_service);
+		for (size_t i = 0; i < _read_threads_count; i++) {
+			_read_threads.push_back(thread([this]() {
+				_read_service.run();
+			}));
+		}
+		_write_service_work = std::make_shared<boost::asio::io_service::work>(_write_service);
+		_write_thread = thread([this]() {
+			_write_service.run();
+		});
+
 		_server->resource["^/api"]["POST"] = [&](shared_ptr<HttpServer::Response> response, shared_ptr<HttpServer::Request> request) {
+			auto start_time = std::chrono::steady_clock::now();
 			try {
-				auto rpc_req = read_rpc_request_from_stream(request->content);
-
-				auto res_str = std::string("method: ") + rpc_req.method;
-				RpcResponse rpc_res;
+				auto json_val = read_json_from_stream(request->content);
+				if (json_val.is_array()) {
+					handle_rpc_batch(response, json_val.as<fc::variants>(), start_time);
+					return;
+				}
+				auto rpc_req = read_rpc_request(json_val);
 
 				params_assert(rpc_methods.find(rpc_req.method) != rpc_methods.end());
-				auto handler = rpc_methods[rpc_req.method];
-				try {
-					auto result = handler(this->_chain, this->_server.get(), rpc_req.params);
-					rpc_res.result = result;
+				if (readonly_rpc_methods.find(rpc_req.method) != readonly_rpc_methods.end()) {
+					auto chain = chain_snapshot();
+					_read_service.post([this, response, rpc_req, start_time, chain]() {
+						RpcResponse rpc_res;
+						try {
+							rpc_res = call_rpc_method(chain.get(), _server.get(), rpc_req);
+						}
+						catch (...) {
+							rpc_res = rpc_error_response("rpc internal error");
+						}
+						record_latency(rpc_req.method, start_time);
+						try {
+							send_rpc_response(response, rpc_req, rpc_res);
+						}
+						catch (...) {
+							// the connection is gone, nothing to answer
+						}
+					});
+					return;
 				}
-				catch (const fc::exception& e) {
-					rpc_res.has_error = true;
-					rpc_res.error = e.to_detail_string();
-					rpc_res.error_code = 100;
-				}
-				catch (const std::exception& e) {
-					rpc_res.has_error = true;
-					rpc_res.error = e.what();
-					rpc_res.error_code = 100;
-				}
-
-				send_rpc_response(response, rpc_res);
+				_write_service.post([this, response, rpc_req, start_time]() {
+					auto rpc_res = call_rpc_method(_chain, _server.get(), rpc_req);
+					record_latency(rpc_req.method, start_time);
+					try {
+						publish_chain_snapshot();
+						send_rpc_response(response, rpc_req, rpc_res);
+					}
+					catch (...) {
+						// the connection is gone, nothing to answer
+					}
+				});
 			}
 			catch (const exception &e) {
 				*response << "HTTP/1.1 400 Bad Request\r\nContent-Length: " << strlen(e.what()) << "\r\n\r\n"
@@ -159,6 +525,11 @@ namespace simplechain {
 			}
 		};
 
+		// latency histograms of rpc methods
+		_server->resource["^/rpc_stats$"]["GET"] = [&](shared_ptr<HttpServer::Response> response, shared_ptr<HttpServer::Request> request) {
+			send_string_to_response(response, fc::json::to_string(latencies_to_json()));
+		};
+
 		_server->resource["^/api"]["OPTIONS"] = [](shared_ptr<HttpServer::Response> response, shared_ptr<HttpServer::Request> request) {
 			send_string_to_response(response, "");
 		};
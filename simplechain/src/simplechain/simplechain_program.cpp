@@ -3,6 +3,7 @@
 #include <simplechain/rpcserver.h>
 #include <uvm/uvm_lutil.h>
 #include <fc/crypto/hex.hpp>
+#include <fc/io/json.hpp>
 #include <cbor_diff/cbor_diff.h>
 #include <cbor_diff/cbor_diff_tests.h>
 #include <simplechain/native_contract_tests.h>
@@ -10,6 +11,21 @@
 using namespace simplechain;
 #ifndef RUN_BOOST_TESTS
 
+// find and remove the arg starting with prefix from argv, return false if not found
+static bool take_prefixed_arg(int& argc, char** argv, const std::string& prefix, std::string& value) {
+	for (int i = 1; i < argc; ++i) {
+		std::string arg(argv[i]);
+		if (arg.compare(0, prefix.size(), prefix) == 0) {
+			value = arg.substr(prefix.size());
+			for (int j = i; j + 1 < argc; ++j)
+				argv[j] = argv[j + 1];
+			--argc;
+			return true;
+		}
+	}
+	return false;
+}
+
 int main(int argc, char** argv) {
 	std::cout << "Hello, simplechain based on uvm" << std::endl;
 	// cbor_diff::test_cbor_diff();
@@ -17,6 +33,32 @@ int main(int argc, char** argv) {
 	// test_token_native_contract();
 	try {
 		auto chain = std::make_shared<simplechain::blockchain>();
+		// --data-dir=<dir> keeps the chain state on disk and restarts from it
+		std::string data_dir;
+		if (take_prefixed_arg(argc, argv, "--data-dir=", data_dir))
+			chain->open_state_db(data_dir);
+		// --record=<file> appends generated blocks and the state hash after each of them to file
+		std::string record_path;
+		if (take_prefixed_arg(argc, argv, "--record=", record_path))
+			chain->record_blocks_to(record_path);
+		// --replay=<file> [--expect-state-hash=<hex>] replays recorded blocks, checking each block and state hash
+		// against the recorded ones, prints the timings report and exits
+		std::string replay_path;
+		if (take_prefixed_arg(argc, argv, "--replay=", replay_path)) {
+			std::string expected_state_hash;
+			bool check_state_hash = take_prefixed_arg(argc, argv, "--expect-state-hash=", expected_state_hash);
+			const auto& result = replay_blocks(*chain, read_recorded_blocks(replay_path));
+			std::cout << fc::json::to_pretty_string(result.to_json()) << std::endl;
+			if (!result.mismatch.empty()) {
+				std::cerr << "replayed chain differs from the recorded one: " << result.mismatch << std::endl;
+				return 1;
+			}
+			if (check_state_hash && result.state_hash != expected_state_hash) {
+				std::cerr << "state hash mismatch, expected " << expected_state_hash << " but got " << result.state_hash << std::endl;
+				return 1;
+			}
+			return 0;
+		}
 
 		if (argc == 2) {
 			// TODO: remove this demo code
@@ -19,6 +19,7 @@
 #include <uvm/lstate.h>
 #include <uvm/exceptions.h>
 #include <uvm/uvm_bytestream.h>
+#include <uvm/uvm_gas_manager.h>
 #include <fc/crypto/sha1.hpp>
 #include <fc/crypto/sha256.hpp>
 #include <fc/crypto/ripemd160.hpp>
@@ -33,11 +34,13 @@
 #include <simplechain/contract_object.h>
 #include <simplechain/blockchain.h>
 #include <simplechain/address_helper.h>
+#include <simplechain/tx_phase_timer.h>
 
 namespace simplechain {
 	using namespace uvm::lua::api;
 
-			static int has_error = 0;
+			// per thread, contracts are also evaluated in the rpc read threads
+			static thread_local int has_error = 0;
 
 			/**
 			* whether exception happen in L
@@ -341,7 +344,8 @@ namespace simplechain {
 			*/
 			std::shared_ptr<UvmModuleByteStream> SimpleChainUvmChainApi::open_contract(lua_State *L, const char *name)
 			{
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT, "chain_api", "open_contract");
+				tx_phase_scope phase_scope(tx_phase_bytecode_load);
 
 				auto evaluator = get_contract_evaluator(L);
 				std::string contract_name = uvm::lua::lib::unwrap_any_contract_name(name);
@@ -357,7 +361,8 @@ namespace simplechain {
             
 			std::shared_ptr<UvmModuleByteStream> SimpleChainUvmChainApi::open_contract_by_address(lua_State *L, const char *address)
             {
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT, "chain_api", "open_contract_by_address");
+				tx_phase_scope phase_scope(tx_phase_bytecode_load);
 				auto evaluator = get_contract_evaluator(L);
 				auto code = get_contract_code_by_id(evaluator, std::string(address));
 				if (code && (code->code.size() <= LUA_MODULE_BYTE_STREAM_BUF_SIZE))
@@ -519,12 +524,14 @@ namespace simplechain {
 			
 			bool SimpleChainUvmChainApi::commit_storage_changes_to_uvm(lua_State *L, AllContractsChangesMap &changes)
 			{
+				tx_phase_scope phase_scope(tx_phase_storage_commit);
 				auto evaluator = get_contract_evaluator(L);
 				//auto use_cbor_diff_flag = use_cbor_diff(L);
 				auto use_cbor_diff_flag = true;
 				cbor_diff::CborDiff differ;
 				jsondiff::JsonDiff json_differ;
 				int64_t storage_gas = 0;
+				std::map<std::string, int64_t> contracts_storage_gas;
 
 				auto gas_limit = uvm::lua::lib::get_lua_state_instructions_limit(L);
 				const char* out_of_gas_error = "contract storage changes out of gas";
@@ -583,6 +590,7 @@ namespace simplechain {
 					// printf("changes size: %d bytes\n", changes_size);
 					auto gas_change = changes_size * 10; // 1 byte storage cost 10 gas
 					storage_gas += gas_change;
+					contracts_storage_gas[contract_id] += gas_change;
 					if (storage_gas < 0 && gas_limit > 0) {
 						throw_exception(L, UVM_API_LVM_LIMIT_OVER_ERROR, out_of_gas_error);
 						return false;
@@ -600,6 +608,11 @@ namespace simplechain {
 					}
 				}
 				uvm::lua::lib::increment_lvm_instructions_executed_count(L, static_cast<int>(storage_gas));
+				if (L->gas_ledger) {
+					for (const auto& p : contracts_storage_gas) {
+						L->gas_ledger->add("storage", "write " + p.first, p.second);
+					}
+				}
 				return true;
 			}
 			intptr_t SimpleChainUvmChainApi::register_object_in_pool(lua_State *L, intptr_t object_addr, UvmOutsideObjectTypes type)
@@ -698,7 +711,7 @@ namespace simplechain {
 			lua_Integer SimpleChainUvmChainApi::transfer_from_contract_to_address(lua_State *L, const char *contract_address, const char *to_address,
 				const char *asset_type, int64_t amount)
 			{
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT, "chain_api", "transfer_from_contract_to_address");
 				contract_address_type f_addr;
 				address t_addr;
 				try {
@@ -740,14 +753,14 @@ namespace simplechain {
 			lua_Integer SimpleChainUvmChainApi::transfer_from_contract_to_public_account(lua_State *L, const char *contract_address, const char *to_account_name,
 				const char *asset_type, int64_t amount)
 			{
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT, "chain_api", "transfer_from_contract_to_public_account");
 				// TODO: not implemented yet
 				return -1;
 			}
 
 			int64_t SimpleChainUvmChainApi::get_contract_balance_amount(lua_State *L, const char *contract_address, const char* asset_symbol)
 			{
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT, "chain_api", "get_contract_balance_amount");
 				contract_address_type c_addr;
 				try {
 					c_addr = contract_address_type(contract_address);
@@ -799,7 +812,7 @@ namespace simplechain {
 
 			int64_t SimpleChainUvmChainApi::get_transaction_fee(lua_State *L)
 			{
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT, "chain_api", "get_transaction_fee");
 				try {
 					return 0;
 				}
@@ -813,7 +826,7 @@ namespace simplechain {
 
 			uint32_t SimpleChainUvmChainApi::get_chain_now(lua_State *L)
 			{				
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT, "chain_api", "get_chain_now");
 				try {
 					auto evaluator = get_contract_evaluator(L);
 					return evaluator->get_chain()->latest_block().block_time.sec_since_epoch();
@@ -828,7 +841,7 @@ namespace simplechain {
 
 			uint32_t SimpleChainUvmChainApi::get_chain_random(lua_State *L)
 			{
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT, "chain_api", "get_chain_random");
 				try {
 					auto evaluator = get_contract_evaluator(L);
 					const auto& chain = evaluator->get_chain();
@@ -850,7 +863,7 @@ namespace simplechain {
 
 			std::string SimpleChainUvmChainApi::get_transaction_id(lua_State *L)
 			{
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT, "chain_api", "get_transaction_id");
 				return get_transaction_id_without_gas(L);
 			}
 
@@ -869,7 +882,7 @@ namespace simplechain {
 
 			uint32_t SimpleChainUvmChainApi::get_header_block_num(lua_State *L)
 			{
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT, "chain_api", "get_header_block_num");
 				try {
 					auto evaluator = get_contract_evaluator(L);
 					return (uint32_t) evaluator->get_chain()->latest_block().block_number;
@@ -900,7 +913,7 @@ namespace simplechain {
 
 			uint32_t SimpleChainUvmChainApi::wait_for_future_random(lua_State *L, int next)
 			{
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT, "chain_api", "wait_for_future_random");
 				try {
 					auto evaluator = get_contract_evaluator(L);
 					const auto& chain = evaluator->get_chain();
@@ -919,7 +932,7 @@ namespace simplechain {
 
 			int32_t SimpleChainUvmChainApi::get_waited(lua_State *L, uint32_t num)
 			{
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT, "chain_api", "get_waited");
 				try {
 					if (num <= 1)
 						return -2;
@@ -941,7 +954,7 @@ namespace simplechain {
 
 			void SimpleChainUvmChainApi::emit(lua_State *L, const char* contract_id, const char* event_name, const char* event_param)
 			{
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT, "events", "emit");
 				try {
 					auto evaluator = get_contract_evaluator(L);
 					contract_address_type contract_addr(contract_id);
@@ -981,10 +994,7 @@ namespace simplechain {
 
 			static std::vector<char> hex_to_chars(const std::string& hex_string) {
 				std::vector<char> chars;
-				try {
-					boost::algorithm::unhex(hex_string, std::inserter(chars, chars.begin()));
-				}
-				catch (...) {
+				if (!uvm::util::hex_decode(hex_string, chars)) {
 					throw uvm::core::UvmException("parse hex to bytes error");
 				}
 				return chars;
@@ -997,9 +1007,7 @@ namespace simplechain {
 				return bytes;
 			}
 			std::string SimpleChainUvmChainApi::bytes_to_hex(std::vector<unsigned char> bytes) {
-				std::vector<char> chars(bytes.size());
-				memcpy(chars.data(), bytes.data(), bytes.size());
-				return fc::to_hex(chars);
+				return uvm::util::hex_encode((const char*)bytes.data(), bytes.size());
 			}
 			std::string SimpleChainUvmChainApi::sha256_hex(const std::string& hex_string) {
 				const auto& chars = hex_to_chars(hex_string);
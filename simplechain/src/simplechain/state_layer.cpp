@@ -0,0 +1,131 @@
+#include <simplechain/state_layer.h>
+#include <uvm/exceptions.h>
+
+namespace simplechain {
+	state_layer::state_layer(std::shared_ptr<state_layer> parent)
+		: _parent(parent) {
+	}
+
+	std::shared_ptr<state_layer> state_layer::parent() const {
+		return _parent;
+	}
+
+	bool state_layer::find_storage(const std::string& contract_address, const std::string& key, StorageDataType& value) const {
+		for (auto layer = this; layer; layer = layer->_parent.get()) {
+			auto it1 = layer->_storages.find(contract_address);
+			if (it1 == layer->_storages.end())
+				continue;
+			auto it2 = it1->second.find(key);
+			if (it2 == it1->second.end())
+				continue;
+			value = it2->second;
+			return true;
+		}
+		return false;
+	}
+
+	bool state_layer::find_balance(const std::string& account_address, asset_id_t asset_id, balance_t& balance) const {
+		for (auto layer = this; layer; layer = layer->_parent.get()) {
+			auto it1 = layer->_balances.find(account_address);
+			if (it1 == layer->_balances.end())
+				continue;
+			auto it2 = it1->second.find(asset_id);
+			if (it2 == it1->second.end())
+				continue;
+			balance = it2->second;
+			return true;
+		}
+		return false;
+	}
+
+	bool state_layer::find_contract(const std::string& contract_address, contract_object& contract_obj) const {
+		for (auto layer = this; layer; layer = layer->_parent.get()) {
+			auto it = layer->_contracts.find(contract_address);
+			if (it != layer->_contracts.end()) {
+				contract_obj = it->second;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool state_layer::find_contract_by_name(const std::string& name, std::string& contract_address, contract_object& contract_obj) const {
+		for (auto layer = this; layer; layer = layer->_parent.get()) {
+			for (const auto& p : layer->_contracts) {
+				if (p.second.contract_name == name) {
+					contract_address = p.first;
+					contract_obj = p.second;
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	bool state_layer::find_tx_receipt(const std::string& tx_id, transaction_receipt& tx_receipt) const {
+		for (auto layer = this; layer; layer = layer->_parent.get()) {
+			auto it = layer->_tx_receipts.find(tx_id);
+			if (it != layer->_tx_receipts.end()) {
+				tx_receipt = it->second;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void state_layer::set_storage(const std::string& contract_address, const std::string& key, const StorageDataType& value) {
+		_storages[contract_address][key] = value;
+	}
+
+	void state_layer::set_balance(const std::string& account_address, asset_id_t asset_id, balance_t balance) {
+		_balances[account_address][asset_id] = balance;
+	}
+
+	void state_layer::store_contract(const std::string& contract_address, const contract_object& contract_obj) {
+		_contracts[contract_address] = contract_obj;
+	}
+
+	void state_layer::set_tx_receipt(const std::string& tx_id, const transaction_receipt& tx_receipt) {
+		_tx_receipts[tx_id] = tx_receipt;
+	}
+
+	const state_layer::storages_type& state_layer::storages() const {
+		return _storages;
+	}
+
+	const state_layer::balances_type& state_layer::balances() const {
+		return _balances;
+	}
+
+	const state_layer::contracts_type& state_layer::contracts() const {
+		return _contracts;
+	}
+
+	const state_layer::tx_receipts_type& state_layer::tx_receipts() const {
+		return _tx_receipts;
+	}
+
+	void state_layer::merge_into_parent() {
+		if (!_parent)
+			throw uvm::core::UvmException("can't merge state layer without parent layer");
+		for (const auto& p : _storages) {
+			auto& parent_storages = _parent->_storages[p.first];
+			for (const auto& it : p.second) {
+				parent_storages[it.first] = it.second;
+			}
+		}
+		for (const auto& p : _balances) {
+			auto& parent_balances = _parent->_balances[p.first];
+			for (const auto& it : p.second) {
+				parent_balances[it.first] = it.second;
+			}
+		}
+		for (const auto& p : _contracts) {
+			_parent->_contracts[p.first] = p.second;
+		}
+		for (const auto& p : _tx_receipts) {
+			_parent->_tx_receipts[p.first] = p.second;
+		}
+	}
+
+}
@@ -0,0 +1,107 @@
+#include <simplechain/tx_phase_timer.h>
+
+namespace simplechain {
+
+	const char* tx_phase_name(tx_phase phase) {
+		switch (phase) {
+		case tx_phase_state_creation: return "state_creation";
+		case tx_phase_bytecode_load: return "bytecode_load";
+		case tx_phase_arg_marshalling: return "arg_marshalling";
+		case tx_phase_execution: return "execution";
+		case tx_phase_storage_commit: return "storage_commit";
+		case tx_phase_receipt: return "receipt";
+		default: return "other";
+		}
+	}
+
+	static thread_local tx_phase_recorder* current_tx_phase_recorder = nullptr;
+
+	tx_phase_recorder::tx_phase_recorder()
+		: _in_tx(false) {
+	}
+
+	tx_phase_recorder::~tx_phase_recorder() {
+		uninstall();
+	}
+
+	tx_phase_recorder* tx_phase_recorder::current() {
+		return current_tx_phase_recorder;
+	}
+
+	void tx_phase_recorder::install() {
+		current_tx_phase_recorder = this;
+	}
+
+	void tx_phase_recorder::uninstall() {
+		if (current_tx_phase_recorder == this)
+			current_tx_phase_recorder = nullptr;
+	}
+
+	void tx_phase_recorder::begin_tx(const std::string& tx_id) {
+		tx_phase_timings timings;
+		timings.tx_id = tx_id;
+		_txs.push_back(timings);
+		_in_tx = true;
+		_tx_start = clock_type::now();
+		_phase_start = _tx_start;
+		_phases.clear();
+		_phases.push_back(tx_phase_other);
+	}
+
+	void tx_phase_recorder::end_tx(bool succeed) {
+		if (!_in_tx)
+			return;
+		switch_phase(tx_phase_other);
+		auto& timings = _txs.back();
+		timings.succeed = succeed;
+		timings.total_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - _tx_start).count();
+		_in_tx = false;
+		_phases.clear();
+	}
+
+	void tx_phase_recorder::switch_phase(tx_phase next) {
+		auto now = clock_type::now();
+		if (!_phases.empty())
+			_txs.back().phase_ns[_phases.back()] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - _phase_start).count();
+		_phase_start = now;
+		if (!_phases.empty())
+			_phases.back() = next;
+	}
+
+	void tx_phase_recorder::enter_phase(tx_phase phase) {
+		if (!_in_tx)
+			return;
+		auto running = _phases.back();
+		switch_phase(running);
+		_phases.push_back(phase);
+	}
+
+	void tx_phase_recorder::leave_phase() {
+		if (!_in_tx || _phases.size() <= 1)
+			return;
+		switch_phase(_phases.back());
+		_phases.pop_back();
+	}
+
+	const std::vector<tx_phase_timings>& tx_phase_recorder::txs() const {
+		return _txs;
+	}
+
+	void tx_phase_recorder::clear() {
+		_txs.clear();
+		_in_tx = false;
+		_phases.clear();
+	}
+
+	tx_phase_scope::tx_phase_scope(tx_phase phase)
+		: _recorder(tx_phase_recorder::current()) {
+		if (_recorder)
+			_recorder->enter_phase(phase);
+	}
+
+	tx_phase_scope::~tx_phase_scope() {
+		if (_recorder)
+			_recorder->leave_phase();
+	}
+
+}
@@ -10,10 +10,12 @@ namespace simplechain
 	{
 		_scope = std::make_shared<uvm::lua::lib::UvmStateScope>(use_contract);
 		_scope->L()->allow_debug = true;
+		_scope->set_gas_ledger(&_gas_ledger);
 	}
 	UvmContractEngine::~UvmContractEngine()
 	{
-
+		// the scope may be shared beyond the engine
+		_scope->set_gas_ledger(nullptr);
 	}
 
 	bool UvmContractEngine::has_gas_limit() const
@@ -35,13 +37,21 @@ namespace simplechain
 		return _scope;
 	}
 
+	const uvm::lua::lib::GasLedger& UvmContractEngine::gas_ledger() const {
+		return _gas_ledger;
+	}
+
 	void UvmContractEngine::set_gas_limit(int64_t gas_limit)
 	{
 		_scope->set_instructions_limit(gas_limit);
+		// same limit the chain api checks on contract api calls, so the vm can check it without calling back
+		_scope->set_contract_api_instructions_limit(gas_limit);
 	}
 	void UvmContractEngine::set_no_gas_limit()
 	{
-		set_gas_limit(-1);
+		_scope->set_instructions_limit(-1);
+		// 0 is no limit, -1 would ask the chain api, which checks the gas limit of the evaluator
+		_scope->set_contract_api_instructions_limit(0);
 	}
 	void UvmContractEngine::set_gas_used(int64_t gas_used)
 	{
@@ -27,23 +27,18 @@ namespace cbor_diff {
 		cbor::output_dynamic output;
 		cbor::encoder encoder(output);
 		encoder.write_cbor_object(&value);
-		const auto& output_hex = output.hex();
-		return output_hex;
+		return uvm::util::hex_encode((const char*)output.data(), output.size(), true);
 	}
 	std::string cbor_to_hex(const cbor::CborObjectP value) {
 		cbor::output_dynamic output;
 		cbor::encoder encoder(output);
 		encoder.write_cbor_object(value.get());
-		const auto& output_hex = output.hex();
-		return output_hex;
+		return uvm::util::hex_encode((const char*)output.data(), output.size(), true);
 	}
 
 	cbor::CborObjectP cbor_from_hex(const std::string& hex_str) {
 		std::vector<char> input_bytes;
-		try {
-			boost::algorithm::unhex(hex_str, std::inserter(input_bytes, input_bytes.begin()));
-		}
-		catch (...) {
+		if (!uvm::util::hex_decode(hex_str, input_bytes)) {
 			throw CborDiffException("invalid hex string");
 		}
 		cbor::input input(input_bytes.data(), input_bytes.size());
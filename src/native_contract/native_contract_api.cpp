@@ -0,0 +1,90 @@
+#include <native_contract/native_contract_api.h>
+#include <uvm/exceptions.h>
+#include <boost/algorithm/string.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace uvm {
+	namespace contract {
+		using namespace cbor;
+
+		bool is_numeric_string(const std::string& number)
+		{
+			char* end = 0;
+			std::strtod(number.c_str(), &end);
+			return end != 0 && *end == 0;
+		}
+
+		bool is_integral_string(const std::string& number)
+		{
+			return is_numeric_string(number) && std::strchr(number.c_str(), '.') == 0;
+		}
+
+		native_contract_args::native_contract_args(const std::string& api_arg)
+			: _typed(false), _raw(api_arg) {
+			boost::split(_parsed, api_arg, [](char c) {return c == ','; });
+			for (auto& item : _parsed) {
+				boost::trim(item);
+			}
+		}
+
+		native_contract_args::native_contract_args(const CborArrayValue& values)
+			: _typed(true), _values(values) {
+		}
+
+		size_t native_contract_args::size() const {
+			return _typed ? _values.size() : _parsed.size();
+		}
+
+		std::string native_contract_args::string_at(size_t index) const {
+			if (index >= size())
+				throw uvm::core::UvmException("native contract argument index out of range");
+			if (!_typed)
+				return _parsed[index];
+			const auto& value = _values[index];
+			if (value->is_string())
+				return value->as_string();
+			if (value->is_integer())
+				return std::to_string(value->force_as_int());
+			throw uvm::core::UvmException("native contract argument must be string or integer");
+		}
+
+		bool native_contract_args::int_at(size_t index, int64_t& value) const {
+			if (index >= size())
+				return false;
+			if (!_typed) {
+				// same rule as the old comma-split args
+				if (!is_integral_string(_parsed[index]))
+					return false;
+				value = std::stoll(_parsed[index]);
+				return true;
+			}
+			const auto& item = _values[index];
+			if (item->is_int()) {
+				value = item->as_int();
+				return true;
+			}
+			if (item->is_extra_int()) {
+				if (item->is_positive_extra && item->as_extra_int() > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+					return false;
+				value = item->force_as_int();
+				return true;
+			}
+			return false;
+		}
+
+		std::string native_contract_args::to_string_arg() const {
+			if (!_typed)
+				return _raw;
+			std::string result;
+			for (size_t i = 0; i < _values.size(); i++) {
+				if (i > 0)
+					result += ",";
+				result += string_at(i);
+			}
+			return result;
+		}
+
+	}
+}
@@ -3,6 +3,7 @@
 #include <jsondiff/jsondiff.h>
 #include <cbor_diff/cbor_diff.h>
 #include <uvm/uvm_lutil.h>
+#include <uvm/uvm_signature_cache.h>
 #include <uvm/uvm_lib.h>
 #include <fc/crypto/hex.hpp>
 #include <fc/crypto/sha256.hpp>
@@ -62,14 +63,17 @@ namespace uvm {
 			return exchange_native_contract::native_contract_key();
 		}
 
-		std::set<std::string> exchange_native_contract::apis() const {
-			return { "init", "init_config", "fillOrder","cancelOrders","setMinFee","withdraw", "state", "feeReceiver","balanceOf","getOrder", "minFee","balanceOfPubk","getAddrByPubk", "on_deposit_asset" };
+		const std::set<std::string>& exchange_native_contract::apis() const {
+			static const std::set<std::string> names = { "init", "init_config", "fillOrder","cancelOrders","setMinFee","withdraw", "state", "feeReceiver","balanceOf","getOrder", "minFee","balanceOfPubk","getAddrByPubk", "on_deposit_asset" };
+			return names;
 		}
-		std::set<std::string> exchange_native_contract::offline_apis() const {
-			return { "state", "feeReceiver","balanceOf","getOrder", "minFee","balanceOfPubk","getAddrByPubk"};
+		const std::set<std::string>& exchange_native_contract::offline_apis() const {
+			static const std::set<std::string> names = { "state", "feeReceiver","balanceOf","getOrder", "minFee","balanceOfPubk","getAddrByPubk"};
+			return names;
 		}
-		std::set<std::string> exchange_native_contract::events() const {
-			return { "Inited", "OrderCanceled", "BuyOrderPutedOn","SellOrderPutedOn","Deposited","Withdrawed","CancelOrders","FillOrders","UserBalanceChange" };
+		const std::set<std::string>& exchange_native_contract::events() const {
+			static const std::set<std::string> names = { "Inited", "OrderCanceled", "BuyOrderPutedOn","SellOrderPutedOn","Deposited","Withdrawed","CancelOrders","FillOrders","UserBalanceChange" };
+			return names;
 		}
 
 		static const std::string not_inited_state_of_exchange_contract = "NOT_INITED";
@@ -110,14 +114,6 @@ namespace uvm {
 			return caller_address_string(); // FIXME: when get from_address, caller maybe other contract
 		}
 
-		static bool is_numeric(std::string number)
-		{
-			char* end = 0;
-			std::strtod(number.c_str(), &end);
-
-			return end != 0 && *end == 0;
-		}
-
 		static std::string getOrderOwnerAddressAndId(const exchange::Order& o, std::string& addr, std::string& id) {
 			const auto& sig_hex = o.sig;
 			const auto& infostr = o.orderInfo;
@@ -132,19 +128,17 @@ namespace uvm {
 			}
 
 			std::vector<char> sig_bytes;
-			try {
-				boost::algorithm::unhex(sig_hex, std::inserter(sig_bytes, sig_bytes.begin()));
-			}
-			catch (...) {
+			if (!uvm::util::hex_decode(sig_hex, sig_bytes)) {
 				return "parse sig hex to bytes error";
 			}
 
 			fc::ecc::compact_signature compact_sig;
 			if (sig_bytes.size() > compact_sig.size())
 				return "invalid sig bytes size";
+			memset(compact_sig.data, 0x0, compact_sig.size());
 			memcpy(compact_sig.data, sig_bytes.data(), sig_bytes.size());
 
-			const auto& recoved_public_key = fc::ecc::public_key(compact_sig, orderinfoDigest, false);
+			const auto& recoved_public_key = uvm::lua::lib::SignatureRecoverCache::instance().recover(compact_sig, orderinfoDigest);
 			if (!recoved_public_key.valid()) {
 				return "invalid signature";
 			}
@@ -158,11 +152,6 @@ namespace uvm {
 			return "OK";
 		}
 
-		static bool is_integral(std::string number)
-		{
-			return is_numeric(number.c_str()) && std::strchr(number.c_str(), '.') == 0;
-		}
-
 		exchange::OrderInfo exchange_native_contract::checkOrder(const exchange::FillOrder& fillOrder, std::string& addr, std::string& id, std::string& eventOrder,bool& isCompleted) {
 			if (getOrderOwnerAddressAndId(fillOrder.order, addr, id) != "OK") {
 				throw_error("fillOrder wrong");
@@ -201,7 +190,7 @@ namespace uvm {
 				}
 				feeReceiver = orderInfo.relayer;
 			}
-			if (!is_numeric(orderInfo.fee)) {
+			if (!is_numeric_string(orderInfo.fee)) {
 				throw_error("invalid fee percentage");
 			}
 			
@@ -518,7 +507,7 @@ namespace uvm {
 			//boost::trim(percentage);
 			if (feeReceiver.empty())
 				throw_error("feeReceiver is empty");
-			//if (!is_numeric(percentage))
+			//if (!is_numeric_string(percentage))
 			//	throw_error("argument format error, percentage is not numeric");
 			if (!is_valid_address(feeReceiver)) {
 				throw_error("feeReceiver is invalid address");
@@ -567,7 +556,7 @@ namespace uvm {
 				throw_error("symbol is empty");
 			}
 
-			if (!is_integral(parsed_args[1]))
+			if (!is_integral_string(parsed_args[1]))
 				throw_error("argument format error, minFee must be integral");
 
 			int64_t minFee = fc::to_int64(parsed_args[1]);
@@ -699,7 +688,7 @@ namespace uvm {
 			if (parsed_args.size() != 2)
 				throw_error("argument format error, need format: amount,symbol");
 
-			if (!is_integral(parsed_args[0]))
+			if (!is_integral_string(parsed_args[0]))
 				throw_error("argument format error, amount must be integral");
 		
 			int64_t amount = fc::to_int64(parsed_args[0]);
@@ -829,24 +818,30 @@ namespace uvm {
 		}
 
 		void exchange_native_contract::invoke(const std::string& api_name, const std::string& api_arg) {
-			std::map<std::string, std::function<void(const std::string&, const std::string&)>> apis = {
-			{ "init", std::bind(&exchange_native_contract::init_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "init_config", std::bind(&exchange_native_contract::init_config_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "fillOrder", std::bind(&exchange_native_contract::fillOrder_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "cancelOrders", std::bind(&exchange_native_contract::cancelOrders_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "balanceOf", std::bind(&exchange_native_contract::balanceOf_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "getOrder", std::bind(&exchange_native_contract::getOrder_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "state", std::bind(&exchange_native_contract::state_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "minFee", std::bind(&exchange_native_contract::minFee_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "setMinFee", std::bind(&exchange_native_contract::setMinFee_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "on_deposit_asset", std::bind(&exchange_native_contract::on_deposit_asset_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "withdraw", std::bind(&exchange_native_contract::withdraw_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "getAddrByPubk", std::bind(&exchange_native_contract::getAddrByPubk_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "balanceOfPubk", std::bind(&exchange_native_contract::balanceOfPubk_api, this, std::placeholders::_1, std::placeholders::_2) }
+			invoke_with_args(api_name, native_contract_args(api_arg));
+		}
+
+		void exchange_native_contract::invoke_with_args(const std::string& api_name, const native_contract_args& args) {
+			// sorted by api name
+			static const native_contract_api_entry<exchange_native_contract> api_table[] = {
+				{ "balanceOf", &exchange_native_contract::balanceOf_api },
+				{ "balanceOfPubk", &exchange_native_contract::balanceOfPubk_api },
+				{ "cancelOrders", &exchange_native_contract::cancelOrders_api },
+				{ "fillOrder", &exchange_native_contract::fillOrder_api },
+				{ "getAddrByPubk", &exchange_native_contract::getAddrByPubk_api },
+				{ "getOrder", &exchange_native_contract::getOrder_api },
+				{ "init", &exchange_native_contract::init_api },
+				{ "init_config", &exchange_native_contract::init_config_api },
+				{ "minFee", &exchange_native_contract::minFee_api },
+				{ "on_deposit_asset", &exchange_native_contract::on_deposit_asset_api },
+				{ "setMinFee", &exchange_native_contract::setMinFee_api },
+				{ "state", &exchange_native_contract::state_api },
+				{ "withdraw", &exchange_native_contract::withdraw_api }
 			};
-			if (apis.find(api_name) != apis.end())
+			auto api = find_native_contract_api(api_table, api_name);
+			if (api)
 			{
-				apis[api_name](api_name, api_arg);
+				call_native_contract_api(this, *api, api_name, args);
 				set_invoke_result_caller();
 				add_gas(gas_count_for_api_invoke(api_name));
 				return;
@@ -16,18 +16,26 @@ namespace uvm {
 			return token_native_contract::native_contract_key();
 		}
 
-		std::set<std::string> token_native_contract::apis() const {
-			return { "init", "init_token", "transfer", "transferFrom", "balanceOf", "approve", "approvedBalanceFrom", "allApprovedFromUser", "state", "supply", "precision", "tokenName", "tokenSymbol" };
+		const std::set<std::string>& token_native_contract::apis() const {
+			static const std::set<std::string> names = { "init", "init_token", "transfer", "transferBatch", "transferFrom", "balanceOf", "balancesOf", "approve", "approvedBalanceFrom", "allApprovedFromUser", "state", "supply", "precision", "tokenName", "tokenSymbol" };
+			return names;
 		}
-		std::set<std::string> token_native_contract::offline_apis() const {
-			return { "balanceOf", "approvedBalanceFrom", "allApprovedFromUser", "state", "supply", "precision", "tokenName", "tokenSymbol" };
+		const std::set<std::string>& token_native_contract::offline_apis() const {
+			static const std::set<std::string> names = { "balanceOf", "balancesOf", "approvedBalanceFrom", "allApprovedFromUser", "state", "supply", "precision", "tokenName", "tokenSymbol" };
+			return names;
 		}
-		std::set<std::string> token_native_contract::events() const {
-			return { "Inited", "Transfer", "Approved" };
+		const std::set<std::string>& token_native_contract::events() const {
+			static const std::set<std::string> names = { "Inited", "Transfer", "TransferBatch", "Approved" };
+			return names;
 		}
 
 		static const std::string not_inited_state_of_token_contract = "NOT_INITED";
 		static const std::string common_state_of_token_contract = "COMMON";
+		static const size_t max_token_batch_size = 1000;
+		// gas of each balance read by a batch api, besides the gas of the api call
+		static const uint64_t token_batch_item_gas = 10;
+		// gas of each balance written by a batch api
+		static const uint64_t token_balance_write_gas = 50;
 
 		void token_native_contract::init_api(const std::string& api_name, const std::string& api_arg)
 		{
@@ -105,20 +113,6 @@ namespace uvm {
 			return caller_address_string(); // FIXME: when get from_address, caller maybe other contract
 		}
 
-		static bool is_numeric(std::string number)
-		{
-			char* end = 0;
-			std::strtod(number.c_str(), &end);
-
-			return end != 0 && *end == 0;
-		}
-
-
-		static bool is_integral(std::string number)
-		{
-			return is_numeric(number.c_str()) && std::strchr(number.c_str(), '.') == 0;
-		}
-
 		// arg format: name,symbol,supply,precision
 		void token_native_contract::init_token_api(const std::string& api_name, const std::string& api_arg)
 		{
@@ -136,13 +130,13 @@ namespace uvm {
 			if (name.empty() || symbol.empty())
 				throw_error("argument format error, need format: name,symbol,supply,precision");
 			std::string supply_str = parsed_args[2];
-			if (!is_integral(supply_str))
+			if (!is_integral_string(supply_str))
 				throw_error("argument format error, need format: name,symbol,supply,precision");
 			int64_t supply = std::stoll(supply_str);
 			if (supply <= 0)
 				throw_error("argument format error, supply must be positive integer");
 			std::string precision_str = parsed_args[3];
-			if (!is_integral(precision_str))
+			if (!is_integral_string(precision_str))
 				throw_error("argument format error, need format: name,symbol,supply,precision");
 			int64_t precision = std::stoll(precision_str);
 			if (precision <= 0)
@@ -172,6 +166,23 @@ namespace uvm {
 			return;
 		}
 
+		// arg format: ownerAddress1,ownerAddress2,...
+		void token_native_contract::balances_of_api(const std::string& api_name, const native_contract_args& args)
+		{
+			if (get_storage_state() != common_state_of_token_contract)
+				throw_error("this token contract state doesn't allow transfer");
+			if (args.size() > max_token_batch_size)
+				throw_error("too many addresses in one batch");
+			jsondiff::JsonObject result;
+			for (size_t i = 0; i < args.size(); i++) {
+				const auto& owner_addr = args.string_at(i);
+				result[owner_addr] = get_balance_of_user(owner_addr);
+			}
+			add_gas(token_batch_item_gas * args.size());
+			set_api_result(uvm::util::json_ordered_dumps(result));
+			return;
+		}
+
 		void token_native_contract::state_api(const std::string& api_name, const std::string& api_arg)
 		{
 			const auto& state = get_storage_state();
@@ -210,18 +221,14 @@ namespace uvm {
 			return;
 		}
 
-		void token_native_contract::approved_balance_from_api(const std::string& api_name, const std::string& api_arg)
+		void token_native_contract::approved_balance_from_api(const std::string& api_name, const native_contract_args& args)
 		{
 			if (get_storage_state() != common_state_of_token_contract)
 				throw_error("this token contract state doesn't allow this api");
-			std::vector<std::string> parsed_args;
-			boost::split(parsed_args, api_arg, [](char c) {return c == ','; });
-			if (parsed_args.size() < 2)
+			if (args.size() < 2)
 				throw_error("argument format error, need format: spenderAddress, authorizerAddress");
-			std::string spender_address = parsed_args[0];
-			boost::trim(spender_address);
-			std::string authorizer_address = parsed_args[1];
-			boost::trim(authorizer_address);
+			std::string spender_address = args.string_at(0);
+			std::string authorizer_address = args.string_at(1);
 			int64_t approved_amount = 0;
 			auto allowed_data = get_allowed_of_user(authorizer_address);
 			if (allowed_data.find(spender_address) != allowed_data.end())
@@ -247,21 +254,16 @@ namespace uvm {
 			return;
 		}
 
-		void token_native_contract::transfer_api(const std::string& api_name, const std::string& api_arg)
+		void token_native_contract::transfer_api(const std::string& api_name, const native_contract_args& args)
 		{
 			if (get_storage_state() != common_state_of_token_contract)
 				throw_error("this token contract state doesn't allow transfer");
-			std::vector<std::string> parsed_args;
-			boost::split(parsed_args, api_arg, [](char c) {return c == ','; });
-			if (parsed_args.size() < 2)
+			if (args.size() < 2)
 				throw_error("argument format error, need format: toAddress,amount(with precision, integer)");
-			std::string to_address = parsed_args[0];
-			boost::trim(to_address);
-			std::string amount_str = parsed_args[1];
-			boost::trim(amount_str);
-			if (!is_integral(amount_str))
+			std::string to_address = args.string_at(0);
+			int64_t amount = 0;
+			if (!args.int_at(1, amount))
 				throw_error("argument format error, amount must be positive integer");
-			int64_t amount = std::stoll(amount_str);
 			if (amount <= 0)
 				throw_error("argument format error, amount must be positive integer");
 
@@ -286,21 +288,75 @@ namespace uvm {
 			return;
 		}
 
-		void token_native_contract::approve_api(const std::string& api_name, const std::string& api_arg)
+		// arg format: toAddress1,amount1,toAddress2,amount2,...
+		void token_native_contract::transfer_batch_api(const std::string& api_name, const native_contract_args& args)
+		{
+			if (get_storage_state() != common_state_of_token_contract)
+				throw_error("this token contract state doesn't allow transfer");
+			if (args.size() < 2 || args.size() % 2 != 0)
+				throw_error("argument format error, need format: toAddress1,amount1,toAddress2,amount2,...(amounts with precision, integer)");
+			auto count = args.size() / 2;
+			if (count > max_token_batch_size)
+				throw_error("too many transfers in one batch");
+
+			std::string from_addr = get_from_address();
+			// each balance is loaded once and written once after all transfers applied,
+			// the loaded balances are kept to skip the unchanged ones
+			std::map<std::string, int64_t> balances;
+			std::map<std::string, int64_t> old_balances;
+			balances[from_addr] = old_balances[from_addr] = get_balance_of_user(from_addr);
+			jsondiff::JsonArray transfers;
+			for (size_t i = 0; i < count; i++) {
+				std::string to_address = args.string_at(2 * i);
+				int64_t amount = 0;
+				if (!args.int_at(2 * i + 1, amount) || amount <= 0)
+					throw_error("argument format error, amount must be positive integer");
+				auto& from_balance = balances[from_addr];
+				if (from_balance < amount)
+					throw_error("you have not enoungh amount to transfer out");
+				from_balance -= amount;
+				auto to_it = balances.find(to_address);
+				if (to_it == balances.end()) {
+					auto to_balance = get_balance_of_user(to_address);
+					old_balances[to_address] = to_balance;
+					to_it = balances.insert(std::make_pair(to_address, to_balance)).first;
+				}
+				to_it->second += amount;
+
+				jsondiff::JsonObject transfer;
+				transfer["to"] = to_address;
+				transfer["amount"] = amount;
+				transfers.push_back(transfer);
+			}
+			uint64_t writes_count = 0;
+			for (const auto& p : balances) {
+				if (p.second == old_balances[p.first])
+					continue;
+				if (p.second > 0)
+					current_fast_map_set("users", p.first, CborObject::from_int(p.second));
+				else
+					current_fast_map_set("users", p.first, CborObject::create_null());
+				++writes_count;
+			}
+			add_gas(token_batch_item_gas * old_balances.size() + token_balance_write_gas * writes_count);
+
+			jsondiff::JsonObject event_arg;
+			event_arg["from"] = from_addr;
+			event_arg["transfers"] = transfers;
+			emit_event("TransferBatch", uvm::util::json_ordered_dumps(event_arg));
+			return;
+		}
+
+		void token_native_contract::approve_api(const std::string& api_name, const native_contract_args& args)
 		{
 			if (get_storage_state() != common_state_of_token_contract)
 				throw_error("this token contract state doesn't allow approve");
-			std::vector<std::string> parsed_args;
-			boost::split(parsed_args, api_arg, [](char c) {return c == ','; });
-			if (parsed_args.size() < 2)
+			if (args.size() < 2)
 				throw_error("argument format error, need format: spenderAddress, amount(with precision, integer)");
-			std::string spender_address = parsed_args[0];
-			boost::trim(spender_address);
-			std::string amount_str = parsed_args[1];
-			boost::trim(amount_str);
-			if (!is_integral(amount_str))
+			std::string spender_address = args.string_at(0);
+			int64_t amount = 0;
+			if (!args.int_at(1, amount))
 				throw_error("argument format error, amount must be positive integer");
-			int64_t amount = std::stoll(amount_str);
 			if (amount <= 0)
 				throw_error("argument format error, amount must be positive integer");
 			std::string contract_caller = get_from_address();
@@ -317,23 +373,17 @@ namespace uvm {
 			return;
 		}
 
-		void token_native_contract::transfer_from_api(const std::string& api_name, const std::string& api_arg)
+		void token_native_contract::transfer_from_api(const std::string& api_name, const native_contract_args& args)
 		{
 			if (get_storage_state() != common_state_of_token_contract)
 				throw_error("this token contract state doesn't allow transferFrom");
-			std::vector<std::string> parsed_args;
-			boost::split(parsed_args, api_arg, [](char c) {return c == ','; });
-			if (parsed_args.size() < 3)
+			if (args.size() < 3)
 				throw_error("argument format error, need format:fromAddress, toAddress, amount(with precision, integer)");
-			std::string from_address = parsed_args[0];
-			boost::trim(from_address);
-			std::string to_address = parsed_args[1];
-			boost::trim(to_address);
-			std::string amount_str = parsed_args[2];
-			boost::trim(amount_str);
-			if (!is_integral(amount_str))
+			std::string from_address = args.string_at(0);
+			std::string to_address = args.string_at(1);
+			int64_t amount = 0;
+			if (!args.int_at(2, amount))
 				throw_error("argument format error, amount must be positive integer");
-			int64_t amount = std::stoll(amount_str);
 			if (amount <= 0)
 				throw_error("argument format error, amount must be positive integer");
 
@@ -371,24 +421,32 @@ namespace uvm {
 		}
 
 		void token_native_contract::invoke(const std::string& api_name, const std::string& api_arg) {
-			std::map<std::string, std::function<void(const std::string&, const std::string&)>> apis = {
-				{"init", std::bind(&token_native_contract::init_api, this, std::placeholders::_1, std::placeholders::_2)},
-				{"init_token", std::bind(&token_native_contract::init_token_api, this, std::placeholders::_1, std::placeholders::_2)},
-				{"transfer", std::bind(&token_native_contract::transfer_api, this, std::placeholders::_1, std::placeholders::_2)},
-				{"transferFrom", std::bind(&token_native_contract::transfer_from_api, this, std::placeholders::_1, std::placeholders::_2)},
-				{"balanceOf", std::bind(&token_native_contract::balance_of_api, this, std::placeholders::_1, std::placeholders::_2)},
-				{"approve", std::bind(&token_native_contract::approve_api, this, std::placeholders::_1, std::placeholders::_2)},
-				{"approvedBalanceFrom", std::bind(&token_native_contract::approved_balance_from_api, this, std::placeholders::_1, std::placeholders::_2)},
-				{"allApprovedFromUser", std::bind(&token_native_contract::all_approved_from_user_api, this, std::placeholders::_1, std::placeholders::_2)},
-				{"state", std::bind(&token_native_contract::state_api, this, std::placeholders::_1, std::placeholders::_2)},
-				{"supply", std::bind(&token_native_contract::supply_api, this, std::placeholders::_1, std::placeholders::_2)},
-				{"precision", std::bind(&token_native_contract::precision_api, this, std::placeholders::_1, std::placeholders::_2)},
-				{"tokenName", std::bind(&token_native_contract::token_name_api, this, std::placeholders::_1, std::placeholders::_2)},
-				{"tokenSymbol", std::bind(&token_native_contract::token_symbol_api, this, std::placeholders::_1, std::placeholders::_2)},
+			invoke_with_args(api_name, native_contract_args(api_arg));
+		}
+
+		void token_native_contract::invoke_with_args(const std::string& api_name, const native_contract_args& args) {
+			// sorted by api name
+			static const native_contract_api_entry<token_native_contract> api_table[] = {
+				{ "allApprovedFromUser", &token_native_contract::all_approved_from_user_api },
+				{ "approve", nullptr, &token_native_contract::approve_api },
+				{ "approvedBalanceFrom", nullptr, &token_native_contract::approved_balance_from_api },
+				{ "balanceOf", &token_native_contract::balance_of_api },
+				{ "balancesOf", nullptr, &token_native_contract::balances_of_api },
+				{ "init", &token_native_contract::init_api },
+				{ "init_token", &token_native_contract::init_token_api },
+				{ "precision", &token_native_contract::precision_api },
+				{ "state", &token_native_contract::state_api },
+				{ "supply", &token_native_contract::supply_api },
+				{ "tokenName", &token_native_contract::token_name_api },
+				{ "tokenSymbol", &token_native_contract::token_symbol_api },
+				{ "transfer", nullptr, &token_native_contract::transfer_api },
+				{ "transferBatch", nullptr, &token_native_contract::transfer_batch_api },
+				{ "transferFrom", nullptr, &token_native_contract::transfer_from_api }
 			};
-			if (apis.find(api_name) != apis.end())
+			auto api = find_native_contract_api(api_table, api_name);
+			if (api)
 			{
-				apis[api_name](api_name, api_arg);
+				call_native_contract_api(this, *api, api_name, args);
 				set_invoke_result_caller();
 				add_gas(gas_count_for_api_invoke(api_name));
 				return;
@@ -20,34 +20,25 @@ namespace uvm {
 			return uniswap_native_contract::native_contract_key();
 		}
 
-		std::set<std::string> uniswap_native_contract::apis() const {
-			return { "init", "init_token", "transfer", "transferFrom", "balanceOf", "approve", "approvedBalanceFrom", "allApprovedFromUser", "state", "supply", "totalSupply", "precision", "tokenName", "tokenSymbol","addLiquidity",
+		const std::set<std::string>& uniswap_native_contract::apis() const {
+			static const std::set<std::string> names = { "init", "init_token", "transfer", "transferFrom", "balanceOf", "approve", "approvedBalanceFrom", "allApprovedFromUser", "state", "supply", "totalSupply", "precision", "tokenName", "tokenSymbol","addLiquidity",
 			"removeLiquidity","on_deposit_asset","init_config","withraw","setMinAddAmount","caculateExchangeAmount","getInfo","balanceOfAsset","getUserRemoveableLiquidity","caculatePoolShareByToken" };
+			return names;
 		}
-		std::set<std::string> uniswap_native_contract::offline_apis() const {
-			return { "balanceOf", "approvedBalanceFrom", "allApprovedFromUser", "state", "supply", "totalSupply", "precision", "tokenName", "tokenSymbol",
+		const std::set<std::string>& uniswap_native_contract::offline_apis() const {
+			static const std::set<std::string> names = { "balanceOf", "approvedBalanceFrom", "allApprovedFromUser", "state", "supply", "totalSupply", "precision", "tokenName", "tokenSymbol",
 			"caculateExchangeAmount","getInfo","balanceOfAsset","getUserRemoveableLiquidity","caculatePoolShareByToken" };
+			return names;
 		}
-		std::set<std::string> uniswap_native_contract::events() const {
-			return { "Inited", "Transfer", "Approved","SetMinAddAmount","Exchanged","Withdrawed",
+		const std::set<std::string>& uniswap_native_contract::events() const {
+			static const std::set<std::string> names = { "Inited", "Transfer", "Approved","SetMinAddAmount","Exchanged","Withdrawed",
 				"Deposited","LiquidityAdded","LiquidityTokenMinted","LiquidityRemoved","LiquidityTokenDestoryed" };
+			return names;
 		}
 
 		static const std::string not_inited_state_of_contract = "NOT_INITED";
 		static const std::string common_state_of_contract = "COMMON";
 
-		static bool is_numeric(std::string number)
-		{
-			char* end = 0;
-			std::strtod(number.c_str(), &end);
-			return end != 0 && *end == 0;
-		}
-
-		static bool is_integral(std::string number)
-		{
-			return is_numeric(number.c_str()) && std::strchr(number.c_str(), '.') == 0;
-		}
-
 		void uniswap_native_contract::init_api(const std::string& api_name, const std::string& api_arg)
 		{
 			this->token_native_contract::init_api(api_name, api_arg);
@@ -84,7 +75,7 @@ namespace uvm {
 			std::string min_amount1 = parsed_args[0];
 			std::string min_amount2 = parsed_args[1];
 
-			if (!is_integral(min_amount1) || !is_integral(min_amount2))
+			if (!is_integral_string(min_amount1) || !is_integral_string(min_amount2))
 				throw_error("argument format error, need format: min_asset1_amount,min_asset2_amount");
 
 			int64_t min_asset1_amount = std::stoll(min_amount1);
@@ -120,7 +111,7 @@ namespace uvm {
 			std::string min_amount1 = parsed_args[2];
 			std::string min_amount2 = parsed_args[3];
 			std::string feestr = parsed_args[4];
-			if (!is_integral(min_amount1)|| !is_integral(min_amount2) || !is_numeric(feestr))
+			if (!is_integral_string(min_amount1)|| !is_integral_string(min_amount2) || !is_numeric_string(feestr))
 				throw_error("argument format error, need format: asset1,asset2,min_asset1_amount,min_asset2_amount,fee_rate,token_name,token_symbol");
 
 			int64_t min_asset1_amount = std::stoll(min_amount1);
@@ -180,7 +171,7 @@ namespace uvm {
 			std::string max_add_asset2_amount_str = parsed_args[1];
 			std::string expired_blocknum_str = parsed_args[2];
 
-			if (!is_integral(add_asset1_amount_str) || !is_integral(max_add_asset2_amount_str) || !is_integral(expired_blocknum_str))
+			if (!is_integral_string(add_asset1_amount_str) || !is_integral_string(max_add_asset2_amount_str) || !is_integral_string(expired_blocknum_str))
 				throw_error("argument format error, need format: add_asset1_amount,max_add_asset2_amount,expired_blocknum");
 
 			int64_t add_asset1_amount = std::stoll(add_asset1_amount_str);
@@ -312,7 +303,7 @@ namespace uvm {
 			std::string min_remove_asset2_amount_str = parsed_args[2];
 			std::string expired_blocknum_str = parsed_args[3];
 
-			if (!is_integral(min_remove_asset1_amount_str) || !is_integral(min_remove_asset2_amount_str) || !is_integral(destory_token_amount_str) || !is_integral(expired_blocknum_str))
+			if (!is_integral_string(min_remove_asset1_amount_str) || !is_integral_string(min_remove_asset2_amount_str) || !is_integral_string(destory_token_amount_str) || !is_integral_string(expired_blocknum_str))
 				throw_error("argument format error, need format: destory_token_amount,min_remove_asset1_amount,min_remove_asset2_amount,expired_blocknum");
 
 			int64_t destory_token_amount = std::stoll(destory_token_amount_str);
@@ -463,7 +454,7 @@ namespace uvm {
 				std::string want_buy_asset_amount_str = parsed_args[1];
 				std::string expired_blocknum_str = parsed_args[2];
 
-				if (!is_integral(want_buy_asset_amount_str)|| !is_integral(expired_blocknum_str))
+				if (!is_integral_string(want_buy_asset_amount_str)|| !is_integral_string(expired_blocknum_str))
 					throw_error("argument format error, need format: want_buy_asset_symbol,min_want_buy_asset_amount,expired_blocknum");
 
 				int64_t want_buy_asset_amount = std::stoll(want_buy_asset_amount_str);
@@ -616,7 +607,7 @@ namespace uvm {
 			int64_t asset_2_pool_amount = get_int_current_contract_storage("asset_2_pool_amount");
 			int64_t supply = get_int_current_contract_storage("supply");
 
-			if (!is_integral(api_arg)) {
+			if (!is_integral_string(api_arg)) {
 				throw_error("input arg must be integer");
 			}
 			int64_t tokenAmount = std::stoll(api_arg);
@@ -676,7 +667,7 @@ namespace uvm {
 			if (parsed_args.size() != 2)
 				throw_error("argument format error, need format: amount,symbol");
 
-			if (!is_integral(parsed_args[0]))
+			if (!is_integral_string(parsed_args[0]))
 				throw_error("argument format error, amount must be integral");
 
 			int64_t amount = fc::to_int64(parsed_args[0]);
@@ -732,7 +723,7 @@ namespace uvm {
 			std::string want_sell_asset_amount_str = parsed_args[1];
 			std::string want_buy_asset_symbol = parsed_args[2];
 
-			if (!is_integral(want_sell_asset_amount_str))
+			if (!is_integral_string(want_sell_asset_amount_str))
 				throw_error("argument format error, need format: want_sell_asset_symbol,want_sell_asset_amount");
 
 			int64_t want_sell_asset_amount = std::stoll(want_sell_asset_amount_str);
@@ -799,35 +790,41 @@ namespace uvm {
 		
 
 		void uniswap_native_contract::invoke(const std::string& api_name, const std::string& api_arg) {
-			std::map<std::string, std::function<void(const std::string&, const std::string&)>> apis = {
-			{ "init", std::bind(&uniswap_native_contract::init_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "init_config", std::bind(&uniswap_native_contract::init_config_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "transfer", std::bind(&uniswap_native_contract::transfer_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "transferFrom", std::bind(&uniswap_native_contract::transfer_from_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "balanceOf", std::bind(&uniswap_native_contract::balance_of_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "approve", std::bind(&uniswap_native_contract::approve_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "approvedBalanceFrom", std::bind(&uniswap_native_contract::approved_balance_from_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "allApprovedFromUser", std::bind(&uniswap_native_contract::all_approved_from_user_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "state", std::bind(&uniswap_native_contract::state_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "supply", std::bind(&uniswap_native_contract::supply_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "totalSupply", std::bind(&uniswap_native_contract::totalSupply_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "precision", std::bind(&uniswap_native_contract::precision_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "tokenName", std::bind(&uniswap_native_contract::token_name_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "tokenSymbol", std::bind(&uniswap_native_contract::token_symbol_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "on_deposit_asset", std::bind(&uniswap_native_contract::on_deposit_asset_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "addLiquidity", std::bind(&uniswap_native_contract::addLiquidity_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "removeLiquidity", std::bind(&uniswap_native_contract::removeLiquidity_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "setMinAddAmount", std::bind(&uniswap_native_contract::setMinAddAmount_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "withdraw", std::bind(&uniswap_native_contract::withdraw_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "caculatePoolShareByToken", std::bind(&uniswap_native_contract::caculatePoolShareByToken_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "caculateExchangeAmount", std::bind(&uniswap_native_contract::caculateExchangeAmount_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "getInfo", std::bind(&uniswap_native_contract::getInfo_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "balanceOfAsset", std::bind(&uniswap_native_contract::balanceOfAsset_api, this, std::placeholders::_1, std::placeholders::_2) },
-			{ "getUserRemoveableLiquidity", std::bind(&uniswap_native_contract::getUserRemoveableLiquidity_api, this, std::placeholders::_1, std::placeholders::_2) },
+			invoke_with_args(api_name, native_contract_args(api_arg));
+		}
+
+		void uniswap_native_contract::invoke_with_args(const std::string& api_name, const native_contract_args& args) {
+			// sorted by api name
+			static const native_contract_api_entry<uniswap_native_contract> api_table[] = {
+				{ "addLiquidity", &uniswap_native_contract::addLiquidity_api },
+				{ "allApprovedFromUser", &uniswap_native_contract::all_approved_from_user_api },
+				{ "approve", nullptr, &uniswap_native_contract::approve_api },
+				{ "approvedBalanceFrom", nullptr, &uniswap_native_contract::approved_balance_from_api },
+				{ "balanceOf", &uniswap_native_contract::balance_of_api },
+				{ "balanceOfAsset", &uniswap_native_contract::balanceOfAsset_api },
+				{ "caculateExchangeAmount", &uniswap_native_contract::caculateExchangeAmount_api },
+				{ "caculatePoolShareByToken", &uniswap_native_contract::caculatePoolShareByToken_api },
+				{ "getInfo", &uniswap_native_contract::getInfo_api },
+				{ "getUserRemoveableLiquidity", &uniswap_native_contract::getUserRemoveableLiquidity_api },
+				{ "init", &uniswap_native_contract::init_api },
+				{ "init_config", &uniswap_native_contract::init_config_api },
+				{ "on_deposit_asset", &uniswap_native_contract::on_deposit_asset_api },
+				{ "precision", &uniswap_native_contract::precision_api },
+				{ "removeLiquidity", &uniswap_native_contract::removeLiquidity_api },
+				{ "setMinAddAmount", &uniswap_native_contract::setMinAddAmount_api },
+				{ "state", &uniswap_native_contract::state_api },
+				{ "supply", &uniswap_native_contract::supply_api },
+				{ "tokenName", &uniswap_native_contract::token_name_api },
+				{ "tokenSymbol", &uniswap_native_contract::token_symbol_api },
+				{ "totalSupply", &uniswap_native_contract::totalSupply_api },
+				{ "transfer", nullptr, &uniswap_native_contract::transfer_api },
+				{ "transferFrom", nullptr, &uniswap_native_contract::transfer_from_api },
+				{ "withdraw", &uniswap_native_contract::withdraw_api }
 			};
-			if (apis.find(api_name) != apis.end())
+			auto api = find_native_contract_api(api_table, api_name);
+			if (api)
 			{
-				apis[api_name](api_name, api_arg);
+				call_native_contract_api(this, *api, api_name, args);
 				set_invoke_result_caller();
 				add_gas(gas_count_for_api_invoke(api_name));
 				return;
@@ -500,10 +500,36 @@ static void *newbox(lua_State *L, size_t newsize) {
         lua_setfield(L, -2, "__gc");  /* metatable.__gc = boxgc */
     }
     lua_setmetatable(L, -2);
+    if (L->buffbox) {  /* reuse the storage of a finished buffer */
+        box->box = L->buffbox;
+        box->bsize = L->buffbox_size;
+        L->buffbox = nullptr;
+        L->buffbox_size = 0;
+        if (box->bsize >= newsize)
+            return box->box;
+    }
     return resizebox(L, -1, newsize);
 }
 
 
+/*
+** keep the storage of a finished buffer for the next one, the larger
+** one is kept, it is freed when the running C function returns
+*/
+static void releasebox(lua_State *L, int idx) {
+    UBox *box = (UBox *)lua_touserdata(L, idx);
+    if (box->bsize > L->buffbox_size) {
+        luaE_freebuffbox(L);
+        L->buffbox = box->box;
+        L->buffbox_size = box->bsize;
+        box->box = nullptr;
+        box->bsize = 0;
+    }
+    else
+        resizebox(L, idx, 0);
+}
+
+
 /*
 ** check whether buffer is using a userdata on the stack as a temporary
 ** buffer
@@ -531,7 +557,7 @@ LUALIB_API char *luaL_prepbuffsize(luaL_Buffer *B, size_t sz) {
             memcpy(newbuff, B->b, B->n * sizeof(char));  /* copy original content */
         }
         B->b = newbuff;
-        B->size = newsize;
+        B->size = ((UBox *)lua_touserdata(L, -1))->bsize;
     }
     return &B->b[B->n];
 }
@@ -555,7 +581,7 @@ LUALIB_API void luaL_pushresult(luaL_Buffer *B) {
     lua_State *L = B->L;
     lua_pushlstring(L, B->b, B->n);
     if (buffonstack(B)) {
-        resizebox(L, -2, 0);  /* delete old buffer */
+        releasebox(L, -2);  /* delete old buffer */
         lua_remove(L, -2);  /* remove its header from the stack */
     }
 }
@@ -3011,7 +3037,7 @@ LUALIB_API int luaL_push_cbor_as_json(lua_State* L, cbor::CborObjectP cbor_objec
 		const auto& bytes = cbor_object->as_bytes();
 		// bytes to hex
 		try {
-			const auto& hex_str = fc::to_hex(bytes);
+			const auto& hex_str = uvm::util::hex_encode(bytes.data(), bytes.size());
 			lua_pushstring(L, hex_str.c_str());
 			return 1;
 		}
@@ -972,3 +972,38 @@ void luaK_setlist(FuncState *fs, int base, int nelems, int tostore) {
     fs->freereg = base + 1;  /* free registers with list values */
 }
 
+
+/*
+** peephole pass over loaded code: mark the instruction pairs the interpreter
+** can run in one step. Only pairs inside one basic block are fused, so the
+** second instruction is already paid for when the first runs and gas is
+** charged exactly as if they ran apart. The code itself is not changed (it
+** is still what gets dumped, hashed and inspected).
+** Compare+JMP needs no mark: tests always run the following jump inline.
+*/
+void luaK_fuseops(uvm_types::GcProto *p) {
+    int n = int(p->codes.size());
+    p->fusedops.clear();
+    if (int(p->gasblocks.size()) != n)  /* no basic blocks: metered per instruction */
+        return;
+    bool fused = false;
+    std::vector<lu_byte> ops(n, UFUSE_NONE);
+    for (int pc = 0; pc + 1 < n; pc++) {
+        Instruction i = p->codes[pc];
+        Instruction next = p->codes[pc + 1];
+        if (p->gasblocks[pc + 1].length != 0)  /* next one starts a block */
+            continue;
+        switch (GET_OPCODE(i)) {
+        case UOP_GETTABUP: case UOP_GETTABLE:  /* 'a.b.c', 'self.storage.x', 'string.len' */
+            if (GET_OPCODE(next) == UOP_GETTABLE && GETARG_B(next) == GETARG_A(i)) {
+                ops[pc] = UFUSE_GETTABLE;
+                fused = true;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    if (fused)
+        p->fusedops.swap(ops);
+}
@@ -33,6 +33,7 @@
 #include "uvm/lvm.h"
 #include "uvm/lzio.h"
 #include "uvm/uvm_lib.h"
+#include "uvm/uvm_profiler.h"
 
 using uvm::lua::api::global_uvm_chain_api;
 
@@ -127,6 +128,7 @@ static void seterrorobj(lua_State *L, int errcode, StkId oldtop) {
 
 
 void luaD_throw(lua_State *L, int errcode) {
+	luaV_refundgasblock(L);  // the rest of the current basic block will not run
     if (L->errorJmp) {  // thread has an error handler?
         L->errorJmp->status = errcode;  // set status
         LUAI_THROW(L, L->errorJmp);  // jump to it
@@ -203,8 +205,15 @@ void luaD_reallocstack(lua_State *L, int newsize) {
     lua_assert(newsize <= LUAI_MAXSTACK || newsize == ERRORSTACKSIZE);
     lua_assert(L->stack_last - L->stack == L->stacksize - EXTRA_STACK);
 
-	auto newstack = static_cast<TValue*>(L->gc_state->gc_malloc_vector(newsize, sizeof(TValue)));
-	memcpy(newstack, L->stack, sizeof(TValue) * L->stacksize);
+	TValue *newstack;
+	if (newsize > lim) {  /* grow in place when possible, the old stack is freed otherwise */
+		newstack = static_cast<TValue*>(L->gc_state->gc_realloc(oldstack, sizeof(TValue) * lim, sizeof(TValue) * newsize));
+	}
+	else {  /* a new smaller stack, so the old one goes back to the gc heap */
+		newstack = static_cast<TValue*>(L->gc_state->gc_malloc_vector(newsize, sizeof(TValue)));
+		memcpy(newstack, oldstack, sizeof(TValue) * newsize);
+		L->gc_state->gc_free(oldstack);
+	}
 	L->stack = newstack;
     for (; lim < newsize; lim++)
         setnilvalue(L->stack + lim); /* erase new segment */
@@ -244,16 +253,22 @@ static int stackinuse(lua_State *L) {
 }
 
 
+/*
+** shrink only when the stack is more than three times the part in use,
+** to twice the part in use (plus EXTRA_STACK), so a recursion going up
+** and down does not realloc the stack on every call
+*/
 void luaD_shrinkstack(lua_State *L) {
     int inuse = stackinuse(L);
-    int goodsize = inuse + (inuse / 8) + 2 * EXTRA_STACK;
-    if (goodsize > LUAI_MAXSTACK) goodsize = LUAI_MAXSTACK;
+    int max = (inuse > LUAI_MAXSTACK / 3) ? LUAI_MAXSTACK : inuse * 3;
+    int goodsize = (inuse > LUAI_MAXSTACK / 2) ? LUAI_MAXSTACK : inuse * 2 + EXTRA_STACK;
+    if (goodsize < BASIC_STACK_SIZE) goodsize = BASIC_STACK_SIZE;
     if (L->stacksize > LUAI_MAXSTACK)  /* was handling stack overflow? */
         luaE_freeCI(L);  /* free all CIs (list grew because of an error) */
     else
         luaE_shrinkCI(L);  /* shrink list */
     if (inuse <= LUAI_MAXSTACK &&  /* not handling stack overflow? */
-        goodsize < L->stacksize)  /* trying to shrink? */
+        L->stacksize > max && goodsize < L->stacksize)  /* trying to shrink? */
         luaD_reallocstack(L, goodsize);  /* shrink it */
     else
         condmovestack(L, , );  /* don't change stack (change only for debugging) */
@@ -371,6 +386,7 @@ int luaD_precall(lua_State *L, StkId func, int nresults) {
     lua_CFunction f;
     CallInfo *ci;
 	L->ci_depth++;
+	luaV_refundgasblock(L);  /* callee (and metamethods) must see the exact instructions count */
     switch (ttype(func)) {
     case LUA_TCCL:  /* C closure */
         f = clCvalue(func)->f;
@@ -389,7 +405,14 @@ int luaD_precall(lua_State *L, StkId func, int nresults) {
         if (L->hookmask & LUA_MASKCALL)
             luaD_hook(L, LUA_HOOKCALL, -1);
         lua_unlock(L);
-        n = (*f)(L);  /* do the actual call */
+        if (L->profiler) {
+            L->profiler->on_cfunction_enter(L, f);
+            n = (*f)(L);  /* do the actual call */
+            L->profiler->on_cfunction_leave(L);
+        }
+        else
+            n = (*f)(L);  /* do the actual call */
+        luaE_freebuffbox(L);
         lua_lock(L);
 		if (L->state & (lua_VMState::LVM_STATE_BREAK | lua_VMState::LVM_STATE_SUSPEND)) {
 			return 1;
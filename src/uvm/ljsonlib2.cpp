@@ -49,10 +49,10 @@ static int json_to_lua(lua_State *L)
 		if (json_gas_punishment_fork_height >= 0 && global_uvm_chain_api->get_header_block_num(L) >= json_gas_punishment_fork_height) {
 			auto common_extra_gas = 10 * json_str_size;
 			if (json_str_size > little_large_size) {
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, common_extra_gas - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, common_extra_gas, "json", "json.loads");
 			}
 			else if (json_str_size > very_large_size) {
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, 10 * common_extra_gas - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, 10 * common_extra_gas, "json", "json.loads");
 			}
 		}
 	}
@@ -82,10 +82,10 @@ static int lua_to_json(lua_State *L)
 		if (json_gas_punishment_fork_height >= 0 && global_uvm_chain_api->get_header_block_num(L) >= json_gas_punishment_fork_height) {
 			auto common_extra_gas = 10 * json_str_size;
 			if (json_str_size > little_large_size) {
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, common_extra_gas - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, common_extra_gas, "json", "json.dumps");
 			}
 			else if (json_str_size > very_large_size) {
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, 10 * common_extra_gas - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, 10 * common_extra_gas, "json", "json.dumps");
 			}
 		}
 	}
@@ -102,8 +102,45 @@ void luaE_setdebt(l_mem debt) {
 }
 
 
+/*
+** CallInfo structures are allocated in slabs, freed ones are kept in
+** 'L->freeci' and the slabs go back to the gc heap when the thread's
+** stack is freed
+*/
+static void newcislab(lua_State *L) {
+    int i;
+    CallInfoSlab *slab = static_cast<CallInfoSlab*>(L->gc_state->gc_malloc(sizeof(CallInfoSlab)));
+    for (i = 0; i < CI_SLAB_SIZE; i++)
+        slab->cis[i].next = (i + 1 < CI_SLAB_SIZE) ? &slab->cis[i + 1] : L->freeci;
+    L->freeci = slab->cis;
+    slab->next = L->cislabs;
+    L->cislabs = slab;
+}
+
+
+static void freecislabs(lua_State *L) {
+    CallInfoSlab *slab = L->cislabs;
+    while (slab != nullptr) {
+        CallInfoSlab *next = slab->next;
+        L->gc_state->gc_free(slab);
+        slab = next;
+    }
+    L->cislabs = nullptr;
+    L->freeci = nullptr;
+}
+
+
+static void releaseci(lua_State *L, CallInfo *ci) {
+    ci->next = L->freeci;
+    L->freeci = ci;
+}
+
+
 CallInfo *luaE_extendCI(lua_State *L) {
-	CallInfo *ci = static_cast<CallInfo*>(L->gc_state->gc_malloc(sizeof(CallInfo)));
+	if (L->freeci == nullptr)
+		newcislab(L);
+	CallInfo *ci = L->freeci;
+	L->freeci = ci->next;
 	memset(ci, 0x0, sizeof(CallInfo));
     lua_assert(L->ci->next == nullptr);
     L->ci->next = ci;
@@ -123,12 +160,24 @@ void luaE_freeCI(lua_State *L) {
     ci->next = nullptr;
     while ((ci = next) != nullptr) {
         next = ci->next;
-		L->gc_state->gc_free(ci);
+        releaseci(L, ci);
         L->nci--;
     }
 }
 
 
+/*
+** free the storage kept for the next luaL_Buffer
+*/
+void luaE_freebuffbox(lua_State *L) {
+    if (L->buffbox) {
+        (*L->frealloc)(L->ud, L->buffbox, L->buffbox_size, 0);
+        L->buffbox = nullptr;
+        L->buffbox_size = 0;
+    }
+}
+
+
 /*
 ** free half of the CallInfo structures not in use by a thread
 */
@@ -137,7 +186,7 @@ void luaE_shrinkCI(lua_State *L) {
     CallInfo *next2;  /* next's next */
     /* while there are two nexts */
     while (ci->next != nullptr && (next2 = ci->next->next) != nullptr) {
-		L->gc_state->gc_free(ci->next); /* free next */
+        releaseci(L, ci->next);  /* free next */
         L->nci--;
         ci->next = next2;  /* remove 'next' from the list */
         next2->previous = ci;
@@ -172,7 +221,8 @@ static void freestack(lua_State *L) {
     L->ci = &L->base_ci;  /* free the entire 'ci' list */
     luaE_freeCI(L);
     lua_assert(L->nci == 0);
-	L->gc_state->gc_free_array(L->stack, L->stacksize, sizeof(TValue)); /* free stack array */
+    freecislabs(L);  /* all CallInfo are back in the slabs now */
+	L->gc_state->gc_free(L->stack); /* free stack array */
 }
 
 
@@ -216,6 +266,8 @@ static void f_luaopen(lua_State *L, void *ud) {
 static void preinit_thread(lua_State *L) {
     L->stack = nullptr;
     L->ci = nullptr;
+    L->freeci = nullptr;
+    L->cislabs = nullptr;
     L->nci = 0;
     L->stacksize = 0;
     L->twups = L;  /* thread has no upvalues */
@@ -289,6 +341,11 @@ LUA_API lua_State *lua_newstate(lua_Alloc f, void *ud) {
 	L->state = lua_VMState::LVM_STATE_NONE;
 	L->allow_debug = false;
 	L->breakpoints = new std::map<std::string, std::list<uint32_t> >();
+	L->breakpoints_version = 1;
+	L->profiler = nullptr;
+	L->gas_ledger = nullptr;
+	L->buffbox = nullptr;
+	L->buffbox_size = 0;
     
 	L->cbor_diff_state = 0;
 
@@ -297,6 +354,11 @@ LUA_API lua_State *lua_newstate(lua_Alloc f, void *ud) {
 	L->using_contract_id_stack = new std::stack<contract_info_stack_entry>();
 	L->call_op_msg = OpCode(0);
 	L->ci_depth = 0;
+	L->gas_block.ci = nullptr;
+	L->gas_block.begin = L->gas_block.end = nullptr;
+	L->gas_block.counter = nullptr;
+	L->api_instructions_limit = -1;
+	L->gas_per_instruction = false;
 
     for (i = 0; i < LUA_NUMTAGS; i++) L->mt[i] = nullptr;
     if (luaD_rawrunprotected(L, f_luaopen, nullptr) != LUA_OK) {
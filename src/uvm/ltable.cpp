@@ -26,6 +26,7 @@
 #include <math.h>
 #include <limits.h>
 
+#include <atomic>
 #include <map>
 #include <vector>
 
@@ -43,6 +44,8 @@
 #include <uvm/uvm_lutil.h>
 #include <uvm/uvm_api.h>
 
+using uvm::lua::api::global_uvm_chain_api;
+
 
 /*
 ** Maximum size of array part (MAXASIZE) is 2^MAXABITS. MAXABITS is
@@ -59,6 +62,12 @@
 */
 #define MAXHBITS	(MAXABITS - 1)
 
+/*
+** Largest hash part size hint (from NEWTABLE or lua_createtable) that is
+** preallocated; bigger tables just grow on demand
+*/
+#define MAXHASHHINT	(1u << 12)
+
 /*
 ** returns the index for 'key' if 'key' is an appropriate key to live in
 ** the array part of the table, 0 otherwise.
@@ -239,20 +248,77 @@ int luaH_next(lua_State *L, uvm_types::GcTable *t, StkId key) {
 	return 0;
 }
 
+/*
+** shapes are unique among all tables, so an inline cache can't match a table
+** allocated later at the address of a freed one
+*/
+static std::atomic<uint64_t> next_table_shape(1);
+
+static void newshape(uvm_types::GcTable *t) {
+	t->shape = next_table_shape.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+/*
+** whether integer keys of the hash part move into the array part once the
+** array reaches them (this changes '#' and the pairs order of such tables,
+** so it only applies from the TABLE_ARRAY_MIGRATION fork on)
+*/
+static bool arraymigration(lua_State *L) {
+	if (!global_uvm_chain_api)
+		return false;
+	auto fork_height = global_uvm_chain_api->get_fork_height(L, "TABLE_ARRAY_MIGRATION");
+	return fork_height >= 0 && global_uvm_chain_api->get_header_block_num_without_gas(L) >= fork_height;
+}
+
+
+/*
+** move the integer keys of the hash part in (oldasize, array size] into the
+** new array slots, then append the following keys while they are consecutive
+** and non-nil. Keys in the hash part are ordered, so this is deterministic
+*/
+static void migratetoarray(lua_State *L, uvm_types::GcTable *t, size_t oldasize) {
+	TValue first;
+	setivalue(&first, lua_cast(lua_Integer, oldasize) + 1);
+	auto it = t->entries.lower_bound(first);
+	if (it == t->entries.end() || !ttisinteger(&it->first) ||
+		l_castS2U(ivalue(&it->first)) - 1 > t->array.size())
+		return;  /* no candidate: don't ask for the fork height */
+	if (!arraymigration(L))
+		return;
+	while (it != t->entries.end() && ttisinteger(&it->first)) {
+		lua_Integer k = ivalue(&it->first);
+		if (l_castS2U(k) - 1 < t->array.size())
+			setobj2t(L, &t->array[k - 1], &it->second);
+		else if (l_castS2U(k) - 1 == t->array.size() && !ttisnil(&it->second))
+			t->array.push_back(it->second);
+		else
+			break;
+		auto key_it = t->keys.find(std::to_string(k));
+		if (key_it != t->keys.end() && ttisinteger(&key_it->second))
+			t->keys.erase(key_it);
+		it = t->entries.erase(it);
+	}
+	newshape(t);  /* 'keys' lost the moved keys */
+}
+
+
 void luaH_resize(lua_State *L, uvm_types::GcTable *t, unsigned int nasize,
     unsigned int nhsize) {
     unsigned int i;
     int j;
     unsigned int oldasize = t->array.size();
-	if (nasize > oldasize)  /* array part must grow? */
-	{
-		for (unsigned int i = 0; i < nasize - oldasize; i++) {
-			t->array.push_back(*luaO_nilobject);
-		}
+	if (nasize > oldasize) {  /* array part must grow? */
+		t->array.resize(nasize, *luaO_nilobject);  /* at once, new slots are nil */
+		if (!t->entries.empty())
+			migratetoarray(L, t, oldasize);
 	}
 	else {
 		t->array.resize(nasize);
 	}
+	/* the hash part keeps its layout (it decides the traversal order), only preallocate it */
+	if (nhsize > t->keys.size())
+		t->keys.reserve(nhsize < MAXHASHHINT ? nhsize : MAXHASHHINT);
 	UNUSED(i);
 	UNUSED(j);
 }
@@ -271,6 +337,7 @@ void luaH_resizearray(lua_State *L, uvm_types::GcTable *t, unsigned int nasize)
 
 uvm_types::GcTable *luaH_new(lua_State *L) {
 	auto o = L->gc_state->gc_new_object<uvm_types::GcTable>();
+	newshape(o);
     return o;
 }
 
@@ -314,6 +381,8 @@ TValue *luaH_newkey(lua_State *L, uvm_types::GcTable *t, const TValue *key, bool
 	// if key is int and == len(array+1), newkey put to array part
 	if (is_int && size_t(k) == (t->array.size() + 1)) {
 		t->array.push_back(*luaO_nilobject);
+		if (!t->entries.empty())
+			migratetoarray(L, t, t->array.size());  /* the following keys may be in the hash part */
 		return &t->array[k-1];
 	}
 	TValue key_obj(*key);
@@ -326,6 +395,7 @@ TValue *luaH_newkey(lua_State *L, uvm_types::GcTable *t, const TValue *key, bool
 	
 	t->entries[key_obj] = *luaO_nilobject;
 	t->keys[key_str] = key_obj;
+	newshape(t);  /* 'keys' may now resolve a key to another entry */
 	auto it = t->entries.find(key_obj);
 	return &it->second;
 }
@@ -338,6 +408,13 @@ const TValue *luaH_getint(uvm_types::GcTable *t, lua_Integer key) {
     if (l_castS2U(key) - 1 < t->array.size())
         return &t->array[key - 1];
     else {
+		/* integer keys of the hash part are stored as integers: find them without the string key */
+		TValue ko;
+		setivalue(&ko, key);
+		auto direct_it = t->entries.find(ko);
+		if (direct_it != t->entries.end())
+			return &direct_it->second;
+		/* else it may be there under the same string key ("1" and 1 share a slot) */
 		const auto& key_str = std::to_string(key);
 		auto key_obj_it = t->keys.find(key_str);
 		if (key_obj_it == t->keys.end())
@@ -12,11 +12,18 @@
 #include <limits.h>
 #include <stddef.h>
 #include <string.h>
+#include <algorithm>
 
 #include <uvm/lua.h>
 
 #include <uvm/lauxlib.h>
 #include <uvm/lualib.h>
+#include <uvm/lobject.h>
+#include <uvm/lvm.h>
+#include <uvm/uvm_api.h>
+#include <uvm/uvm_lib.h>
+
+using uvm::lua::api::global_uvm_chain_api;
 
 
 /*
@@ -256,37 +263,16 @@ static int tlength(lua_State *L)
 
 /*
 ** Produce a "random" 'unsigned int' to randomize pivot choice. This
-** macro is used only when 'sort' detects a big imbalance in the result
-** of a partition. (If you don't want/need this "randomness", ~0 is a
-** good choice.)
-*/
-#if !defined(l_randomizePivot)		/* { */
-
-#include <time.h>
-
-/* size of 'e' measured in number of 'unsigned int's */
-#define sof(e)		(sizeof(e) / sizeof(unsigned int))
-
-/*
-** Use 'time' and 'clock' as sources of "randomness". Because we don't
-** know the types 'clock_t' and 'time_t', we cannot cast them to
-** anything without risking overflows. A safe way to use their values
-** is to copy them to an array of a known type and use the array values.
+** is used only when 'sort' detects a big imbalance in the result
+** of a partition. Contracts must sort the same way on every node, so
+** it is derived from the interval instead of 'clock' and 'time'.
 */
-static unsigned int l_randomizePivot(void) {
-    clock_t c = clock();
-    time_t t = time(nullptr);
-    unsigned int buff[sof(c) + sof(t)];
-    unsigned int i, rnd = 0;
-    memcpy(buff, &c, sof(c) * sizeof(unsigned int));
-    memcpy(buff + sof(c), &t, sof(t) * sizeof(unsigned int));
-    for (i = 0; i < sof(buff); i++)
-        rnd += buff[i];
+static unsigned int l_randomizePivot(unsigned int lo, unsigned int up) {
+    unsigned int rnd = lo * 2654435761u;
+    rnd ^= up + 0x9e3779b9u + (rnd << 6) + (rnd >> 2);
     return rnd;
 }
 
-#endif					/* } */
-
 
 /* arrays larger than 'RANLIMIT' may use randomized pivots */
 #define RANLIMIT	100u
@@ -423,15 +409,210 @@ static void auxsort(lua_State *L, unsigned int lo, unsigned int up,
             up = p - 1;  /* tail call for [lo .. p - 1]  (lower interval) */
         }
         if ((up - lo) / 128u > n) /* partition too imbalanced? */
-            rnd = l_randomizePivot();  /* try a new randomization */
+            rnd = l_randomizePivot(lo, up);  /* try a new randomization */
     }  /* tail call auxsort(L, lo, up, rnd) */
 }
 
 
+/*
+** {======================================================
+** Native sort of the array part of tables without metatable
+** whose elements are all integers or all strings, when there is
+** no order function. Equal elements of these arrays can not be
+** told apart, so the result is the same as with 'auxsort'.
+** =======================================================
+*/
+
+/* intervals not larger than this are sorted by insertion */
+#define NATIVESORT_INSERTION_LIMIT	16u
+
+/* comparisons of the native sort charged as one instruction */
+#define NATIVESORT_COMPARISONS_PER_INSTRUCTION	8u
+
+
+struct IntegerLess {
+    bool operator()(const TValue *a, const TValue *b) const {
+        return ivalue(a) < ivalue(b);
+    }
+};
+
+
+struct StringLess {
+    lua_State *L;
+    bool operator()(const TValue *a, const TValue *b) const {
+        return luaV_lessthan(L, a, b) != 0;
+    }
+};
+
+
+/*
+** introsort: quicksort with median of three pivots, heapsort when the
+** recursion gets too deep and insertion sort for small intervals. It
+** does not depend on the standard library, so the number of
+** comparisons (and the gas) is the same on every platform.
+*/
+template <typename Less>
+class NativeSorter {
+public:
+    NativeSorter(TValue *a, Less less) : comparisons(0), a(a), less(less) {}
+
+    void sort(size_t n) {
+        if (n < 2)
+            return;
+        size_t depth = 0;
+        for (size_t m = n; m > 1; m >>= 1)
+            depth += 2;
+        introsort(0, n - 1, depth);
+    }
+
+    size_t comparisons;
+
+private:
+    bool lt(const TValue &x, const TValue &y) {
+        comparisons++;
+        return less(&x, &y);
+    }
+
+    void insertion(size_t lo, size_t up) {
+        for (size_t i = lo + 1; i <= up; i++) {
+            for (size_t j = i; j > lo && lt(a[j], a[j - 1]); j--)
+                std::swap(a[j], a[j - 1]);
+        }
+    }
+
+    void siftdown(size_t lo, size_t root, size_t n) {
+        for (;;) {
+            size_t child = 2 * root + 1;
+            if (child >= n)
+                return;
+            if (child + 1 < n && lt(a[lo + child], a[lo + child + 1]))
+                child++;
+            if (!lt(a[lo + root], a[lo + child]))
+                return;
+            std::swap(a[lo + root], a[lo + child]);
+            root = child;
+        }
+    }
+
+    void heapsort(size_t lo, size_t up) {
+        size_t n = up - lo + 1;
+        for (size_t i = n / 2; i > 0; i--)
+            siftdown(lo, i - 1, n);
+        for (size_t end = n - 1; end > 0; end--) {
+            std::swap(a[lo], a[lo + end]);
+            siftdown(lo, 0, end);
+        }
+    }
+
+    void introsort(size_t lo, size_t up, size_t depth) {
+        while (up - lo >= NATIVESORT_INSERTION_LIMIT) {
+            if (depth == 0) {
+                heapsort(lo, up);
+                return;
+            }
+            depth--;
+            size_t mid = lo + (up - lo) / 2;
+            /* sort a[lo], a[mid] and a[up], a[mid] is the pivot */
+            if (lt(a[mid], a[lo]))
+                std::swap(a[mid], a[lo]);
+            if (lt(a[up], a[mid])) {
+                std::swap(a[up], a[mid]);
+                if (lt(a[mid], a[lo]))
+                    std::swap(a[mid], a[lo]);
+            }
+            TValue pivot = a[mid];
+            /* Hoare partition: a[lo .. j] <= pivot <= a[j + 1 .. up], lo <= j < up */
+            size_t i = lo;
+            size_t j = up;
+            for (;;) {
+                while (lt(a[i], pivot))
+                    i++;
+                while (lt(pivot, a[j]))
+                    j--;
+                if (i >= j)
+                    break;
+                std::swap(a[i], a[j]);
+                i++;
+                j--;
+            }
+            if (j - lo < up - j) {  /* recurse into the smaller interval */
+                introsort(lo, j, depth);
+                lo = j + 1;
+            }
+            else {
+                introsort(j + 1, up, depth);
+                up = j;
+            }
+        }
+        insertion(lo, up);
+    }
+
+    TValue *a;
+    Less less;
+};
+
+
+static void chargenativesort(lua_State *L, size_t comparisons) {
+    if (comparisons < NATIVESORT_COMPARISONS_PER_INSTRUCTION)
+        return;
+    auto sort_gas_fork_height = global_uvm_chain_api->get_fork_height(L, "TABLE_SORT_GAS");
+    /* the block num is read without gas, so the gas before the fork stays the same */
+    if (sort_gas_fork_height >= 0 && global_uvm_chain_api->get_header_block_num_without_gas(L) >= sort_gas_fork_height) {
+        /* the instruction calling table.sort is already counted */
+        uvm::lua::lib::charge_lvm_api_gas(L,
+            1 + int(comparisons / NATIVESORT_COMPARISONS_PER_INSTRUCTION), "table", "table.sort");
+    }
+}
+
+
+/*
+** sort the first 'n' elements of the table at index 1 in place,
+** returns 0 when the table or its elements need the generic sort
+*/
+static int nativesort(lua_State *L, lua_Integer n) {
+    if (lua_type(L, 1) != LUA_TTABLE || !lua_isnoneornil(L, 2))
+        return 0;
+    if (lua_getmetatable(L, 1)) {  /* may have metamethods */
+        lua_pop(L, 1);
+        return 0;
+    }
+    auto t = static_cast<uvm_types::GcTable*>(const_cast<void*>(lua_topointer(L, 1)));
+    if ((size_t)n > t->array.size())
+        return 0;
+    TValue *a = t->array.data();
+    bool allintegers = true;
+    bool allstrings = true;
+    for (lua_Integer i = 0; i < n; i++) {
+        allintegers = allintegers && ttisinteger(a + i);
+        allstrings = allstrings && ttisstring(a + i);
+        if (!allintegers && !allstrings)
+            return 0;
+    }
+    size_t comparisons;
+    if (allintegers) {
+        NativeSorter<IntegerLess> sorter(a, IntegerLess());
+        sorter.sort((size_t)n);
+        comparisons = sorter.comparisons;
+    }
+    else {
+        StringLess less = { L };
+        NativeSorter<StringLess> sorter(a, less);
+        sorter.sort((size_t)n);
+        comparisons = sorter.comparisons;
+    }
+    chargenativesort(L, comparisons);
+    return 1;
+}
+
+/* }====================================================== */
+
+
 static int sort(lua_State *L) {
     lua_Integer n = aux_getn(L, 1, TAB_RW);
     if (n > 1) {  /* non-trivial interval? */
         luaL_argcheck(L, n < INT_MAX, 1, "array too big");
+        if (nativesort(L, n))
+            return 0;
         luaL_checkstack(L, 40, "");  /* assume array is smaller than 2^40 */
         if (!lua_isnoneornil(L, 2))  /* is there a 2nd argument? */
             luaL_checktype(L, 2, LUA_TFUNCTION);  /* must be a function */
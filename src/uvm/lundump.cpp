@@ -14,6 +14,8 @@
 
 #include <uvm/lua.h>
 
+#include <uvm/lcode.h>
+
 #include <uvm/ldebug.h>
 #include <uvm/ldo.h>
 #include <uvm/lfunc.h>
@@ -21,17 +23,13 @@
 #include <uvm/lobject.h>
 #include <uvm/lstring.h>
 #include <uvm/lundump.h>
+#include <uvm/lvm.h>
 #include <uvm/lzio.h>
 #include <uvm/uvm_lib.h>
 
 using uvm::lua::api::global_uvm_chain_api;
 
 
-#if !defined(luai_verifycode)
-#define luai_verifycode(L,b,f)  /* empty */
-#endif
-
-
 typedef struct {
     lua_State *L;
     ZIO *Z;
@@ -246,6 +244,143 @@ static bool LoadDebug(LoadState *S, uvm_types::GcProto *f) {
 }
 
 
+/*
+** static checks of one loaded function: register ranges, constant, upvalue
+** and prototype indices, jump targets and stack sizes. The interpreter
+** skips the matching runtime checks for verified prototypes. A function
+** that fails is still loaded (deployed bytecode must keep behaving the same)
+** and just runs with all the runtime checks
+*/
+static bool VerifyCode(const uvm_types::GcProto *f) {
+#define checkv(c)	{ if (!(c)) return false; }
+#define checkreg(r)	checkv((r) < maxstack)
+#define checkrk(r)	checkv(ISK(r) ? INDEXK(r) < nk : (r) < maxstack)
+#define checktarget(t)	checkv((t) >= 0 && (t) < n)
+    const int n = int(f->codes.size());
+    const int maxstack = f->maxstacksize;
+    const int nk = int(f->ks.size());
+    const int nup = int(f->upvalues.size());
+    checkv(n > 0 && GET_OPCODE(f->codes[n - 1]) == UOP_RETURN);  /* can't run off the end */
+    checkv(f->numparams <= maxstack);
+    checkv(f->lineinfos.empty() || int(f->lineinfos.size()) == n);
+    for (const auto *p : f->ps) {  /* upvalues captured by closures of sub functions */
+        checkv(p != nullptr);
+        for (const auto &uv : p->upvalues)
+            checkv(uv.instack ? uv.idx < maxstack : uv.idx < nup);
+    }
+    for (int pc = 0; pc < n; pc++) {
+        Instruction i = f->codes[pc];
+        OpCode op = GET_OPCODE(i);
+        checkv(op < UOP_DUMMY_COUNT);
+        int a = GETARG_A(i);
+        int b = 0, c = 0;
+        switch (getOpMode(op)) {
+        case iABC:
+            b = GETARG_B(i);
+            c = GETARG_C(i);
+            if (op != UOP_CCALL && op != UOP_CSTATICCALL) {  /* B is an arguments count there */
+                if (getBMode(op) == OpArgR) checkreg(b);
+                if (getBMode(op) == OpArgK) checkrk(b);
+            }
+            if (getCMode(op) == OpArgR) checkreg(c);
+            if (getCMode(op) == OpArgK) checkrk(c);
+            break;
+        case iABx:
+            b = GETARG_Bx(i);
+            if (getBMode(op) == OpArgK) checkv(b < nk);
+            break;
+        case iAsBx:
+            b = GETARG_sBx(i);
+            break;
+        case iAx:
+            break;
+        }
+        if (testAMode(op) || op == UOP_SETTABLE || op == UOP_SETUPVAL || op == UOP_TEST || op == UOP_TFORCALL
+            || op == UOP_RETURN || op == UOP_SETLIST)
+            checkreg(a);
+        switch (op) {
+        case UOP_LOADKX:
+            checkv(pc + 1 < n && GET_OPCODE(f->codes[pc + 1]) == UOP_EXTRAARG);
+            checkv(GETARG_Ax(f->codes[pc + 1]) < nk);
+            break;
+        case UOP_LOADBOOL:
+            if (c) checktarget(pc + 2);
+            break;
+        case UOP_LOADNIL:
+            checkreg(a + b);
+            break;
+        case UOP_GETUPVAL: case UOP_SETUPVAL: case UOP_GETTABUP:
+            checkv(b < nup);
+            break;
+        case UOP_SETTABUP:
+            checkv(a < nup);
+            break;
+        case UOP_SELF:
+            checkreg(a + 1);
+            break;
+        case UOP_CONCAT:
+            checkv(b < c);
+            break;
+        case UOP_JMP:
+            checktarget(pc + 1 + b);
+            checkv(a <= maxstack);  /* A - 1 is the first register to close */
+            break;
+        case UOP_EQ: case UOP_LT: case UOP_LE: case UOP_TEST: case UOP_TESTSET:
+            /* the next instruction is executed as part of the test */
+            checkv(pc + 1 < n && GET_OPCODE(f->codes[pc + 1]) == UOP_JMP);
+            break;
+        case UOP_CALL: case UOP_TAILCALL:
+            if (b > 0) checkreg(a + b - 1);
+            if (op == UOP_CALL && c > 1) checkreg(a + c - 2);
+            break;
+        case UOP_RETURN:
+            if (b > 1) checkreg(a + b - 2);
+            break;
+        case UOP_FORLOOP: case UOP_FORPREP:
+            checkreg(a + 3);
+            checktarget(pc + 1 + b);
+            break;
+        case UOP_TFORCALL:
+            checkv(c > 0);
+            checkreg(a + 2 + c);
+            checkv(pc + 1 < n && GET_OPCODE(f->codes[pc + 1]) == UOP_TFORLOOP);
+            break;
+        case UOP_TFORLOOP:
+            checkreg(a + 1);
+            checktarget(pc + 1 + b);
+            break;
+        case UOP_SETLIST:
+            if (b > 0) checkreg(a + b);
+            if (c == 0) checkv(pc + 1 < n && GET_OPCODE(f->codes[pc + 1]) == UOP_EXTRAARG);
+            break;
+        case UOP_CLOSURE:
+            checkv(b < int(f->ps.size()));
+            break;
+        case UOP_VARARG:
+            checkv(f->is_vararg);
+            if (b > 1) checkreg(a + b - 2);
+            break;
+        case UOP_EXTRAARG:  /* only valid as operand of the previous instruction */
+            checkv(pc > 0 && (GET_OPCODE(f->codes[pc - 1]) == UOP_LOADKX
+                || (GET_OPCODE(f->codes[pc - 1]) == UOP_SETLIST && GETARG_C(f->codes[pc - 1]) == 0)));
+            break;
+        case UOP_CCALL: case UOP_CSTATICCALL:
+            checkv(b > 0);
+            checkreg(a + b);
+            if (c > 1) checkreg(a + c - 2);
+            break;
+        default:
+            break;
+        }
+    }
+    return true;
+#undef checkv
+#undef checkreg
+#undef checkrk
+#undef checktarget
+}
+
+
 static void LoadFunction(LoadState *S, uvm_types::GcProto *f, uvm_types::GcString *psource) {
     f->source = LoadString(S);
     if (f->source == nullptr)  /* no source in dump? */
@@ -272,6 +407,10 @@ static void LoadFunction(LoadState *S, uvm_types::GcProto *f, uvm_types::GcStrin
 		return;
 	}
     LoadDebug(S, f);
+    f->verified = VerifyCode(f) ? 1 : 0;
+    luaV_buildgasblocks(f);
+    luaK_fuseops(f);
+    f->icaches.resize(f->codes.size());
 }
 
 
@@ -334,6 +473,7 @@ uvm_types::GcLClosure *luaU_undump(lua_State *L, ZIO *Z, const char *name) {
     cl->p = luaF_newproto(L);
     LoadFunction(&S, cl->p, nullptr);
     lua_assert(cl->nupvalues == cl->p->upvalues.size());
-    luai_verifycode(L, buff, cl->p);
+    if (cl->nupvalues != cl->p->upvalues.size())
+        cl->p->verified = 0;  /* upvalue indices were checked against the prototype only */
     return cl;
 }
@@ -40,6 +40,7 @@
 #include <uvm/uvm_lib.h>
 #include <uvm/uvm_storage.h>
 #include <uvm/exceptions.h>
+#include <uvm/uvm_profiler.h>
 
 using uvm::lua::api::global_uvm_chain_api;
 
@@ -77,7 +78,8 @@ using uvm::lua::api::global_uvm_chain_api;
 
 #endif
 
-static std::shared_ptr<uvm::core::ExecuteContext> last_execute_context;
+// per thread, so lua states running in other threads(eg. rpc read threads) don't replace the debugged one
+static thread_local std::shared_ptr<uvm::core::ExecuteContext> last_execute_context;
 /*
 ** Try to convert a value to a float. The float case is already handled
 ** by the macro 'tonumber'.
@@ -783,6 +785,156 @@ void luaV_finishOp(uvm::core::ExecuteContext* ctx, lua_State *L) {
 
 
 
+/*
+** {==================================================================
+** Basic-block gas metering
+** ===================================================================
+*/
+
+/* EXTRAARG operands consumed by the previous instruction are never fetched (and not charged) */
+static bool isextraoperand(const Instruction *begin, const Instruction *pc) {
+	if (pc <= begin || GET_OPCODE(*pc) != UOP_EXTRAARG)
+		return false;
+	Instruction prev = *(pc - 1);
+	return GET_OPCODE(prev) == UOP_LOADKX
+		|| (GET_OPCODE(prev) == UOP_SETLIST && GETARG_C(prev) == 0);
+}
+
+/* instructions the interpreter fetches in [from, end) of the block led by 'begin' */
+static int gasblockcost(const Instruction *begin, const Instruction *from, const Instruction *end) {
+	int cost = 0;
+	for (const Instruction *pc = from; pc < end; pc++) {
+		if (!isextraoperand(begin, pc))
+			cost++;
+	}
+	return cost;
+}
+
+static void markleader(std::vector<char> &leaders, int pc) {
+	if (pc >= 0 && size_t(pc) < leaders.size())
+		leaders[pc] = 1;
+}
+
+/*
+** split the code of 'p' into basic blocks. A block ends after every
+** instruction that may leave the straight line (jumps, tests, calls) and
+** every jump target starts a new one; targets are computed the same way
+** the interpreter computes them, so any pc it can land on is a leader
+*/
+void luaV_buildgasblocks(uvm_types::GcProto *p) {
+	int n = int(p->codes.size());
+	p->gasblocks.clear();
+	if (n == 0)
+		return;
+	std::vector<char> leaders(n, 0);
+	leaders[0] = 1;
+	for (int pc = 0; pc < n; pc++) {
+		Instruction i = p->codes[pc];
+		switch (GET_OPCODE(i)) {
+		case UOP_JMP: case UOP_FORLOOP: case UOP_FORPREP: case UOP_TFORLOOP:
+			markleader(leaders, pc + 1 + GETARG_sBx(i));
+			markleader(leaders, pc + 1);
+			break;
+		case UOP_EQ: case UOP_LT: case UOP_LE: case UOP_TEST: case UOP_TESTSET:
+		case UOP_TFORCALL:
+			/* the following instruction is executed inline as a jump or skipped */
+			if (pc + 1 < n)
+				markleader(leaders, pc + 2 + GETARG_sBx(p->codes[pc + 1]));
+			markleader(leaders, pc + 1);
+			markleader(leaders, pc + 2);
+			break;
+		case UOP_LOADBOOL:
+			if (GETARG_C(i)) {
+				markleader(leaders, pc + 1);
+				markleader(leaders, pc + 2);
+			}
+			break;
+		case UOP_CALL: case UOP_TAILCALL: case UOP_RETURN:
+		case UOP_CCALL: case UOP_CSTATICCALL:
+			markleader(leaders, pc + 1);
+			break;
+		default:
+			break;
+		}
+	}
+	const Instruction *codes = p->codes.data();
+	p->gasblocks.resize(n);
+	int begin = 0;
+	for (int pc = 1; pc <= n; pc++) {
+		if (pc == n || leaders[pc]) {
+			p->gasblocks[begin].length = pc - begin;
+			p->gasblocks[begin].cost = gasblockcost(codes + begin, codes + begin, codes + pc);
+			begin = pc;
+		}
+	}
+}
+
+/*
+** mark the pcs of 'p' whose line has a breakpoint of the contract, so the
+** debugger checks a bit per instruction instead of searching the breakpoints
+*/
+void luaV_buildbreakpoints(lua_State *L, uvm_types::GcProto *p, const std::string &contract_address) {
+	p->breakpointpcs.clear();
+	p->breakpointsversion = L->breakpoints_version;
+	p->breakpointscontract = contract_address;
+	auto found = L->breakpoints->find(contract_address);
+	if (found == L->breakpoints->end() || found->second.empty())
+		return;
+	const auto &lines = found->second;
+	bool any = false;
+	std::vector<bool> pcs(p->lineinfos.size(), false);
+	for (size_t pc = 0; pc < p->lineinfos.size(); pc++) {
+		if (std::find(lines.begin(), lines.end(), uint32_t(p->lineinfos[pc])) != lines.end()) {
+			pcs[pc] = true;
+			any = true;
+		}
+	}
+	if (any)
+		p->breakpointpcs.swap(pcs);
+}
+
+/*
+** give back the gas charged in advance for the part of the pending block
+** that was not executed. Called whenever control leaves the block early
+** (calls, errors, stops); the rest of it is then metered per instruction
+*/
+void luaV_refundgasblock(lua_State *L) {
+	GasBlockCharge &block = L->gas_block;
+	if (block.ci == nullptr)
+		return;
+	const Instruction *pc = block.ci->u.l.savedpc;
+	if (block.counter && pc > block.begin && pc < block.end)
+		*block.counter -= gasblockcost(block.begin, pc, block.end);
+	block.ci = nullptr;
+}
+
+/* }================================================================== */
+
+
+/*
+** table lookup of the constant key of instruction 'pc' through its inline
+** cache. Entries are never removed from a table, so while the table keeps its
+** shape a key keeps the slot 'luaH_get' found for it. Only found keys are
+** cached (a missing key may be added later) and only string keys (integer
+** keys may live in the array part, which moves when it grows)
+*/
+static const TValue *icacheget(uvm_types::GcProto *p, const Instruction *pc, uvm_types::GcTable *t,
+	const TValue *key) {
+	if (p->icaches.empty() || !ttisstring(key))
+		return luaH_get(t, key);
+	InlineCache &ic = p->icaches[pc - p->codes.data()];
+	if (ic.shape == t->shape)
+		return ic.slot;
+	const TValue *slot = luaH_get(t, key);
+	if (slot != luaO_nilobject) {
+		ic.shape = t->shape;
+		ic.slot = slot;
+	}
+	return slot;
+}
+
+
+
 
 /*
 ** {==================================================================
@@ -835,7 +987,20 @@ void luaV_finishOp(uvm::core::ExecuteContext* ctx, lua_State *L) {
     else Protect(luaV_finishget(this, L,t,k,v,aux)); }
 
 
-/* same for 'luaV_settable' */
+/*
+** 'luaH_get' for the key in argument B/C of the current instruction, through
+** the inline cache of the instruction when that key is a constant
+*/
+#define cachedgetB(h,k)	(ISK(GETARG_B(i)) ? icacheget(cl->p, ci->u.l.savedpc - 1, h, k) : luaH_get(h, k))
+#define cachedgetC(h,k)	(ISK(GETARG_C(i)) ? icacheget(cl->p, ci->u.l.savedpc - 1, h, k) : luaH_get(h, k))
+
+/* same as 'gettableProtected' for a key in argument C */
+#define gettableCachedC(L,t,k,v)  { const TValue *aux; \
+  if (luaV_fastget(L,t,k,aux,cachedgetC)) { setobj2s(L, v, aux); } \
+    else Protect(luaV_finishget(this, L,t,k,v,aux)); }
+
+
+/* same for 'luaV_settable' (key in argument B) */
 #define settableProtected(L,t,k,v) { const TValue *slot; \
 	  Protect(        \
 	if (t && ttistable(t)) {           \
@@ -854,7 +1019,7 @@ void luaV_finishOp(uvm::core::ExecuteContext* ctx, lua_State *L) {
 		}\
 	} \
 	); \
-  if (!luaV_fastset(L,t,k,slot,luaH_get,v)) \
+  if (!luaV_fastset(L,t,k,slot,cachedgetB,v)) \
     Protect(luaV_finishset(this, L,t,k,v,slot)); }
 // FIXME: end duplicate code in uvm_lib.cpp
 
@@ -887,6 +1052,24 @@ if (!(cond)) {      \
      }                             \
 }
 
+/* same, but only for checks the load time verifier already did on verified prototypes */
+#define lua_check_unverified_in_current_line(cond, error_msg) {    \
+if (!cl->p->verified)      \
+  lua_check_in_vm_error_in_current_line(cond, error_msg); \
+}
+
+/*
+** whether the next instruction, fused with the current one by luaK_fuseops,
+** can run in this same step: it is in the basic block already charged,
+** nothing asked the vm to stop in between and nobody traces single
+** instructions (the profiler and the step log must see the fused one too)
+*/
+#define fusednext(op) (!cl->p->fusedops.empty() \
+	&& cl->p->fusedops[ci->u.l.savedpc - 1 - cl->p->codes.data()] == (op) \
+	&& L->gas_block.ci == ci && !L->hookmask && !L->force_stopping \
+	&& !L->profiler && !use_step_log \
+	&& !(stopped_pointer && *stopped_pointer > 0))
+
 #define luaG_runerror_in_current_line(L, error_msg) { \
 	const auto& msg = std::string(error_msg) + " in line " + std::to_string(current_line()); \
 	luaG_runerror(L, msg.c_str());    \
@@ -1106,9 +1289,7 @@ namespace uvm {
 				L->state = lua_VMState::LVM_STATE_NONE;
 			}
 
-			bool use_step_log = global_uvm_chain_api != nullptr && global_uvm_chain_api->use_step_log(L);
-            bool use_gas_log = global_uvm_chain_api != nullptr && global_uvm_chain_api->use_gas_log(L);
-			UNUSED(use_gas_log);
+			auto profiler = L->profiler;
 
 			
 				if (!ci || ci->u.l.savedpc == nullptr) {
@@ -1123,29 +1304,38 @@ namespace uvm {
 					printf("%s\tline:%d, now gas %d\n", luaP_opnames[GET_OPCODE(i)], cur_line, int(*insts_executed_count));
 					ci->u.l.savedpc++;
 				}
+				if (profiler)
+					profiler->on_instruction(L, ci, cl->p, int(ci->u.l.savedpc - 1 - cl->p->codes.data()), GET_OPCODE(i));
 
 				StkId ra;
 
-				*insts_executed_count += 1; // executed instructions count
-
-											// limit instructions count, and executed instructions
-				if (has_insts_limit && *insts_executed_count > insts_limit)
+				if (use_step_log || !charge_gas_block(L, ci->u.l.savedpc - 1))
 				{
-					global_uvm_chain_api->throw_exception(L, UVM_API_LVM_LIMIT_OVER_ERROR, "over instructions limit");
-					//vmbreak;
-					return false;
+					*insts_executed_count += 1; // executed instructions count
+
+												// limit instructions count, and executed instructions
+					if (has_insts_limit && *insts_executed_count > insts_limit)
+					{
+						global_uvm_chain_api->throw_exception(L, UVM_API_LVM_LIMIT_OVER_ERROR, "over instructions limit");
+						//vmbreak;
+						return false;
+					}
 				}
-				if (stopped_pointer && *stopped_pointer > 0)
+				if (stopped_pointer && *stopped_pointer > 0) {
+					luaV_refundgasblock(L);
 					return false;
 					//vmbreak;
-				if (L->force_stopping)
+				}
+				if (L->force_stopping) {
+					luaV_refundgasblock(L);
 					return false;
 					//vmbreak;
+				}
 
 
 				// when over contract api limit, also vmbreak
 				if ((GET_OPCODE(i) == UOP_CALL || GET_OPCODE(i) == UOP_TAILCALL)
-					&& global_uvm_chain_api->check_contract_api_instructions_over_limit(L))
+					&& check_contract_api_instructions_over_limit(L))
 				{
 					const auto& msg = std::string("over instructions limit at line ") + std::to_string(current_line());
 					global_uvm_chain_api->throw_exception(L, UVM_API_LVM_LIMIT_OVER_ERROR, msg.c_str());
@@ -1184,7 +1374,7 @@ namespace uvm {
 					}
 					vmcase(UOP_LOADNIL) {
 						int b = GETARG_B(i);
-						lua_check_in_vm_error_in_current_line(b >= 0, "loadnil instruction arg must be positive integer");
+						lua_check_unverified_in_current_line(b >= 0, "loadnil instruction arg must be positive integer");
 						do {
 							setnilvalue(ra++);
 						} while (b--);
@@ -1192,13 +1382,13 @@ namespace uvm {
 					}
 					vmcase(UOP_GETUPVAL) {
 						int b = GETARG_B(i);
-						lua_check_in_vm_error_in_current_line(b < cl->nupvalues && b >= 0, "upvalue error");
+						lua_check_unverified_in_current_line(b < cl->nupvalues && b >= 0, "upvalue error");
 						setobj2s(L, ra, cl->upvals[b]->v);
 						vmbreak;
 					}
 					vmcase(UOP_GETTABUP) {
 						auto upval_index = GETARG_B(i);
-						lua_check_in_vm_error_in_current_line(upval_index < cl->nupvalues && upval_index >= 0, "upvalue error");
+						lua_check_unverified_in_current_line(upval_index < cl->nupvalues && upval_index >= 0, "upvalue error");
 						if (nullptr == cl->upvals[upval_index])
 						{
 							*stopped_pointer = 1;
@@ -1206,10 +1396,16 @@ namespace uvm {
 						}
 						TValue *upval = cl->upvals[upval_index]->v;
 						TValue *rc = RKC(i);
-						gettableProtected(L, upval, rc, ra);
+						gettableCachedC(L, upval, rc, ra);
+						if (fusednext(UFUSE_GETTABLE)) {
+							i = *(ci->u.l.savedpc++);
+							ra = RA(i);
+							goto fused_gettable;
+						}
 						vmbreak;
 					}
 					vmcase(UOP_GETTABLE) {
+					fused_gettable:
 						StkId rb = RB(i);
 						TValue *rc = RKC(i);
 						bool istable = ttistable(rb);
@@ -1219,12 +1415,17 @@ namespace uvm {
 							L->force_stopping = true;
 							vmbreak;
 						}
-						gettableProtected(L, rb, rc, ra);
+						gettableCachedC(L, rb, rc, ra);
+						if (fusednext(UFUSE_GETTABLE)) {
+							i = *(ci->u.l.savedpc++);
+							ra = RA(i);
+							goto fused_gettable;
+						}
 						vmbreak;
 					}
 					vmcase(UOP_SETTABUP) {
 						auto upval_index = GETARG_A(i);
-						lua_check_in_vm_error_in_current_line(upval_index < cl->nupvalues && upval_index >= 0, "upvalue error");
+						lua_check_unverified_in_current_line(upval_index < cl->nupvalues && upval_index >= 0, "upvalue error");
 						if (!cl->upvals[upval_index])
 						{
 							luaG_runerror_in_current_line(L, "set upvalue of nil, need table here");
@@ -1239,7 +1440,7 @@ namespace uvm {
 					}
 					vmcase(UOP_SETUPVAL) {
 						auto upval_index = GETARG_B(i);
-						lua_check_in_vm_error_in_current_line(upval_index < cl->nupvalues && upval_index >= 0, "upvalue error");
+						lua_check_unverified_in_current_line(upval_index < cl->nupvalues && upval_index >= 0, "upvalue error");
 						UpVal *uv = cl->upvals[upval_index];
 						setobj(L, uv->v, ra);
 						luaC_upvalbarrier(L, uv);
@@ -1265,9 +1466,8 @@ namespace uvm {
 						const TValue *aux;
 						StkId rb = RB(i);
 						TValue *rc = RKC(i);
-						uvm_types::GcString *key = tsvalue(rc);  /* key must be a string */
 						setobjs2s(L, ra + 1, rb);
-						if (luaV_fastget(L, rb, key, aux, luaH_getstr)) {
+						if (luaV_fastget(L, rb, rc, aux, cachedgetC)) {  /* key must be a string */
 							setobj2s(L, ra, aux);
 						}
 						else
@@ -1613,6 +1813,7 @@ namespace uvm {
 						auto ts = luaS_new(L, "import_contract_from_address");
 						setsvalue2s(L, &key, ts);				
 						gettableProtected(L, gt, &key, ra);
+						ra = RA(i);  /* a metamethod may move the stack */
 
 						setsvalue2s(L, ra+1, contract_address);
 						//call import contract
@@ -1640,7 +1841,7 @@ namespace uvm {
 						setobj(L, ra + 1, ra); //contract table set to ra+1
 						setsvalue2s(L, &key, api_name);
 						gettableProtected(L, ra, &key, ra); //get api to ra
-
+						ra = RA(i);  /* a metamethod may move the stack */
 						
 						if (!ttisfunction(ra)) {
 							luaG_runerror_in_current_line(L, "get api is not function ");
@@ -1714,6 +1915,7 @@ namespace uvm {
 					vmcase(UOP_RETURN) {
 						int a = GETARG_A(i);
 						int b = GETARG_B(i);
+						luaV_refundgasblock(L); /* the frame is leaving, don't keep pointing to its ci */
 						int top = lua_gettop(L);
 						// return R(a), R(a+1), ... , R(a+b-2), b is return result count + 1, index from 0
 						if (use_last_return && b > 1 && top >= a + 1)
@@ -1841,7 +2043,7 @@ namespace uvm {
 					}
 					vmcase(UOP_CLOSURE) {
 						auto p_index = GETARG_Bx(i);
-						lua_check_in_vm_error_in_current_line(p_index < int(cl->p->ps.size()), "too large sub proto index");
+						lua_check_unverified_in_current_line(p_index < int(cl->p->ps.size()), "too large sub proto index");
 						uvm_types::GcProto *p = cl->p->ps[p_index];
 						uvm_types::GcLClosure *ncl = getcached(p, cl->upvals.empty() ? nullptr : cl->upvals.data(), base);  /* cached closure */
 						if (ncl == nullptr) {  /* no match? */
@@ -1903,88 +2105,68 @@ namespace uvm {
 						setobj(L, ra, L->evalstacktop - 1);
 						vmbreak;
 					}
+					/* the comparisons may call metamethods, which can move the stack,
+					   so the operands and 'ra' are taken again after each of them */
 					vmcase(UOP_CMP) {
-						TValue *rb = RKB(i);
-						TValue *rc = RKC(i);
-						Protect(
-							if (luaV_equalobj(L, rb, rc)) {
-								setivalue(ra, 0);
-							}
-							else if (!luaV_lessthan(L, rb, rc)) {
-								setivalue(ra, 1);
-							}
-							else {
-								setivalue(ra, -1);
-							}
-							)
-							vmbreak;
+						int res;
+						Protect(res = luaV_equalobj(L, RKB(i), RKC(i)));
+						if (res) {
+							res = 0;
+						}
+						else {
+							Protect(res = luaV_lessthan(L, RKB(i), RKC(i)) ? -1 : 1);
+						}
+						ra = RA(i);
+						setivalue(ra, res);
+						vmbreak;
 					}
 					vmcase(UOP_CMP_EQ) {
-						TValue *rb = RKB(i);
-						TValue *rc = RKC(i);
-						Protect(
-							if (luaV_equalobj(L, rb, rc)) {
-								setivalue(ra, 1);
-							}
-							else {
-								setivalue(ra, 0);
-							}
-							)
-							vmbreak;
+						int res;
+						Protect(res = luaV_equalobj(L, RKB(i), RKC(i)));
+						ra = RA(i);
+						setivalue(ra, res ? 1 : 0);
+						vmbreak;
 					}
 					vmcase(UOP_CMP_NE) {
-						TValue *rb = RKB(i);
-						TValue *rc = RKC(i);
-						Protect(
-							if (luaV_equalobj(L, rb, rc)) {
-								setivalue(ra, 0);
-							}
-							else {
-								setivalue(ra, 1);
-							}
-							)
-							vmbreak;
+						int res;
+						Protect(res = luaV_equalobj(L, RKB(i), RKC(i)));
+						ra = RA(i);
+						setivalue(ra, res ? 0 : 1);
+						vmbreak;
 					}
 					vmcase(UOP_CMP_GT) {
-						TValue *rb = RKB(i);
-						TValue *rc = RKC(i);
-						Protect(
-							if (luaV_lessthan(L, rb, rc) || luaV_equalobj(L, rb, rc)) {
-								setivalue(ra, 0);
-							}
-							else {
-								setivalue(ra, 1);
-							}
-							)
-							vmbreak;
+						int res;
+						Protect(res = luaV_lessthan(L, RKB(i), RKC(i)));
+						if (!res) {
+							Protect(res = luaV_equalobj(L, RKB(i), RKC(i)));
+						}
+						ra = RA(i);
+						setivalue(ra, res ? 0 : 1);
+						vmbreak;
 					}
 					vmcase(UOP_CMP_LT) {
-						TValue *rb = RKB(i);
-						TValue *rc = RKC(i);
-						Protect(
-							if (luaV_lessthan(L, rb, rc)) {
-								setivalue(ra, 1);
-							}
-							else {
-								setivalue(ra, 0);
-							}
-							)
-							vmbreak;
+						int res;
+						Protect(res = luaV_lessthan(L, RKB(i), RKC(i)));
+						ra = RA(i);
+						setivalue(ra, res ? 1 : 0);
+						vmbreak;
 					}
 					vmcase(UOP_DUMMY_COUNT) {
 						
 					}
 				}
 
-				if (!enum_has_flag(L->state, lua_VMState::LVM_STATE_FAULT) && L->allow_debug && L->using_contract_id_stack && !L->using_contract_id_stack->empty())
+				if (!enum_has_flag(L->state, lua_VMState::LVM_STATE_FAULT) && L->allow_debug && L->breakpoints && !L->breakpoints->empty()
+					&& L->using_contract_id_stack && !L->using_contract_id_stack->empty())
 				{
-					const auto& current_contract_address = L->using_contract_id_stack->top().contract_id;
-					if (L->breakpoints->find(current_contract_address) != L->breakpoints->end()) {
-						const auto& contract_breakpoints = L->breakpoints->at(current_contract_address);
+					// calls and returns inside this function switch frames without prepare_newframe
+					if (cl->p != breakpoints_proto || L->breakpoints_version != breakpoints_version
+						|| L->using_contract_id_stack->size() != breakpoints_contract_depth)
+						resolve_breakpoints(L);
+					if (breakpointpcs) {
 						auto inst_index_in_proto = ci->u.l.savedpc - cl->p->codes.data();
-						if (cl->p->lineinfos.size() > size_t(inst_index_in_proto)) {
-							uint32_t line = cl->p->lineinfos[inst_index_in_proto];
-							if (std::find(contract_breakpoints.begin(), contract_breakpoints.end(), line) != contract_breakpoints.end()) {
+						if (breakpointpcs->size() > size_t(inst_index_in_proto)) {
+							if ((*breakpointpcs)[inst_index_in_proto]) {
 								union_change_state(L, lua_VMState::LVM_STATE_BREAK);
 								if (L->using_contract_id_stack)
 									this->using_contract_id_stack = *(L->using_contract_id_stack);
@@ -2004,6 +2186,38 @@ namespace uvm {
 			return true;
 		}
 
+		bool ExecuteContext::charge_gas_block(lua_State* L, const Instruction *pc) {
+			auto &block = L->gas_block;
+			// the debugger stops between any two instructions, so it always sees the exact gas
+			if (L->gas_per_instruction || (L->allow_debug && L->breakpoints && !L->breakpoints->empty())) {
+				luaV_refundgasblock(L);
+				return false;
+			}
+			if (block.ci == ci && pc > block.begin && pc < block.end)
+				return true; // inside a block already paid for
+			block.ci = nullptr;
+			const auto &gasblocks = cl->p->gasblocks;
+			auto idx = pc - cl->p->codes.data();
+			if (idx < 0 || size_t(idx) >= gasblocks.size() || gasblocks[idx].length == 0)
+				return false;
+			const auto &gasblock = gasblocks[idx];
+			// a block that may cross the limit is metered per instruction, so the error is raised at the same instruction
+			if (has_insts_limit && *insts_executed_count + gasblock.cost > insts_limit)
+				return false;
+			*insts_executed_count += gasblock.cost;
+			block.ci = ci;
+			block.begin = pc;
+			block.end = pc + gasblock.length;
+			block.counter = insts_executed_count;
+			return true;
+		}
+
+		bool ExecuteContext::check_contract_api_instructions_over_limit(lua_State* L) {
+			if (L->api_instructions_limit >= 0)
+				return L->api_instructions_limit > 0 && *insts_executed_count > L->api_instructions_limit;
+			return global_uvm_chain_api->check_contract_api_instructions_over_limit(L);
+		}
+
 		bool ExecuteContext::executeToNextCi(lua_State* L) {
 			if (L->state != lua_VMState::LVM_STATE_NONE) {
 				L->state = lua_VMState::LVM_STATE_NONE;
@@ -2036,12 +2250,7 @@ namespace uvm {
 			} while (has_next_ci);
 		}
 
-		void ExecuteContext::prepare_newframe(lua_State *L) {
-			lua_assert(ci == L->ci);
-			cl = clLvalue(ci->func);  /* local reference to function's closure */
-			k = cl->p->ks.empty() ? nullptr : cl->p->ks.data();  /* local reference to function's constant table */
-			base = ci->u.l.base;  /* local copy of function's base */
-
+		void ExecuteContext::prepare_execute(lua_State *L) {
 			auto insts_limit = uvm::lua::lib::get_lua_state_value(L, INSTRUCTIONS_LIMIT_LUA_STATE_MAP_KEY).int_value;
 			auto *stopped_pointer = uvm::lua::lib::get_lua_state_value(L, LUA_STATE_STOP_TO_RUN_IN_LVM_STATE_MAP_KEY).int_pointer_value;
 			if (nullptr == stopped_pointer)
@@ -2060,22 +2269,42 @@ namespace uvm {
 				lua_state_value_of_exected_count.int_pointer_value = insts_executed_count;
 				uvm::lua::lib::set_lua_state_value(L, INSTRUCTIONS_EXECUTED_COUNT_LUA_STATE_MAP_KEY, lua_state_value_of_exected_count, LUA_STATE_VALUE_INT_POINTER);
 			}
-			if (*insts_executed_count < 0)
-				*insts_executed_count = 0;
-
-			lua_getglobal(L, "last_return");
-			bool use_last_return = true; // lua_istable(L, -1);
-			lua_pop(L, 1);
+			bool use_last_return = true;
+			bool use_step_log = global_uvm_chain_api != nullptr && global_uvm_chain_api->use_step_log(L);
 
+			this->use_step_log = use_step_log;
 			this->insts_executed_count = insts_executed_count;
 			this->stopped_pointer = stopped_pointer;
 			this->use_last_return = use_last_return;
 			this->insts_limit = insts_limit;
 			this->has_insts_limit = has_insts_limit;
-			this->k = k;
-			this->ci = ci;
-			this->base = base;
-			this->cl = cl;
+			this->breakpointpcs = nullptr;
+			this->breakpoints_proto = nullptr;
+			this->breakpoints_contract_depth = 0;
+			this->breakpoints_version = 0;
+		}
+
+		void ExecuteContext::prepare_newframe(lua_State *L) {
+			lua_assert(ci == L->ci);
+			cl = clLvalue(ci->func);  /* local reference to function's closure */
+			k = cl->p->ks.empty() ? nullptr : cl->p->ks.data();  /* local reference to function's constant table */
+			base = ci->u.l.base;  /* local copy of function's base */
+			if (*insts_executed_count < 0)
+				*insts_executed_count = 0;
+			if (L->allow_debug && L->breakpoints && !L->breakpoints->empty()
+				&& L->using_contract_id_stack && !L->using_contract_id_stack->empty())
+				resolve_breakpoints(L);
+		}
+
+		void ExecuteContext::resolve_breakpoints(lua_State *L) {
+			const auto& current_contract_address = L->using_contract_id_stack->top().contract_id;
+			auto p = cl->p;
+			if (p->breakpointsversion != L->breakpoints_version || p->breakpointscontract != current_contract_address)
+				luaV_buildbreakpoints(L, p, current_contract_address);
+			breakpointpcs = p->breakpointpcs.empty() ? nullptr : &p->breakpointpcs;
+			breakpoints_proto = p;
+			breakpoints_contract_depth = L->using_contract_id_stack->size();
+			breakpoints_version = L->breakpoints_version;
 		}
 
 		std::map<std::string, TValue> ExecuteContext::view_localvars(lua_State* L) const {
@@ -2207,7 +2436,10 @@ std::shared_ptr<uvm::core::ExecuteContext> luaV_execute(lua_State *L)
 	ci->callstatus |= CIST_FRESH;  /* fresh invocation of 'luaV_execute" */
 	auto execute_ctx = std::make_shared<uvm::core::ExecuteContext>();
 	execute_ctx->ci = ci;
+	execute_ctx->prepare_execute(L);
 	execute_ctx->enter_newframe(L);
+	if (L->profiler)
+		L->profiler->on_execute_leave(L);
 	last_execute_context = execute_ctx;
 	UNUSED(cl);
 	UNUSED(k);
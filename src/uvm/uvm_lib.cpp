@@ -20,6 +20,9 @@
 #include <fc/crypto/hex.hpp>
 #include <fc/crypto/base58.hpp>
 #include <fc/crypto/elliptic.hpp>
+#include <fc/crypto/sha1.hpp>
+#include <fc/crypto/sha256.hpp>
+#include <fc/crypto/ripemd160.hpp>
 
 #include <uvm/uvm_api.h>
 #include <uvm/uvm_lib.h>
@@ -33,6 +36,8 @@
 #include <uvm/ldebug.h>
 #include <uvm/lauxlib.h>
 #include <uvm/lualib.h>
+#include <uvm/uvm_gas_manager.h>
+#include <uvm/uvm_signature_cache.h>
 #include <uvm/lfunc.h>
 #include <uvm/ltable.h>
 #include <uvm/uvm_storage.h>
@@ -83,6 +88,7 @@ namespace uvm
                 "next", "rawequal", "rawlen", "rawget", "rawset", "select",
                 "setmetatable",
 				"hex_to_bytes", "bytes_to_hex", "sha256_hex", "sha1_hex", "sha3_hex", "ripemd160_hex", "get_address_role", "pubkey_to_address", "str_to_hex",
+				"hex_to_bin", "bin_to_hex", "sha256_bin", "sha1_bin", "sha3_bin", "ripemd160_bin", "signature_recover_bin", "signature_recover_batch", "new_hasher",
 				"get_pay_back_balance", "get_contract_lock_balance_info_by_asset", "get_contract_lock_balance_info", "foreclose_balance_from_miners", "obtain_pay_back_balance", "lock_contract_balance_to_miner",
 				"cbor_encode", "cbor_decode", "signature_recover", "get_address_role","send_message"
             };
@@ -102,24 +108,30 @@ namespace uvm
                 return &states_map;
             }
 
+            // lua states run in several threads(eg. rpc read threads), every access of states_map takes it
             static std::mutex states_map_mutex;
 
             static L_V1 create_value_map_for_lua_state(lua_State *L)
             {
+                std::lock_guard<std::mutex> lock(states_map_mutex);
                 LStatesMap *states_map = get_lua_states_value_hashmap();
                 auto it = states_map->find(L);
                 if (it == states_map->end())
                 {
-                    states_map_mutex.lock();
                     L_V1 map = std::make_shared<L_VM1>();
                     states_map->insert(std::make_pair(L, map));
-                    states_map_mutex.unlock();
                     return map;
                 }
                 else
                     return it->second;
             }
 
+            static void erase_value_map_of_lua_state(lua_State *L)
+            {
+                std::lock_guard<std::mutex> lock(states_map_mutex);
+                get_lua_states_value_hashmap()->erase(L);
+            }
+
 			// transfer from contract to account
 			static int transfer_from_contract_to_public_account(lua_State *L)
             {
@@ -333,6 +345,30 @@ namespace uvm
                 return 1;
             }
 
+			// @throws uvm::core::UvmException
+			static SignatureRecoverCache::signature_item to_signature_item(const char* sig, size_t sig_size, const char* digest, size_t digest_size) {
+				fc::ecc::compact_signature compact_sig;
+				if (sig_size > compact_sig.size())
+					throw uvm::core::UvmException("invalid sig bytes size");
+				if (digest_size != 32)
+					throw uvm::core::UvmException("raw bytes should be 32 bytes");
+				memset(compact_sig.data, 0x0, compact_sig.size());
+				memcpy(compact_sig.data, sig, sig_size);
+				return SignatureRecoverCache::signature_item(compact_sig, fc::sha256(digest, digest_size));
+			}
+
+			// @return serialized compressed public key
+			// @throws uvm::core::UvmException
+			static std::string recover_public_key(const char* sig, size_t sig_size, const char* digest, size_t digest_size) {
+				const auto& item = to_signature_item(sig, sig_size, digest, digest_size);
+				auto recoved_public_key = SignatureRecoverCache::instance().recover(item.first, item.second);
+				if (!recoved_public_key.valid()) {
+					throw uvm::core::UvmException("invalid signature");
+				}
+				const auto& public_key_chars = recoved_public_key.serialize();
+				return std::string(public_key_chars.begin(), public_key_chars.end());
+			}
+
 			static int signature_recover(lua_State* L) {
 				// signature_recover(sig_hex, raw_hex): public_key_hex_string
 				if (lua_gettop(L) < 2 || !lua_isstring(L, 1) || !lua_isstring(L, 2)) {
@@ -340,25 +376,14 @@ namespace uvm
 					L->force_stopping = true;
 					return 0;
 				}
-				uvm::lua::lib::increment_lvm_instructions_executed_count(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT * 10 - 1);
+				uvm::lua::lib::charge_lvm_api_gas(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT * 10, "crypto", "signature_recover");
 				std::string sig_hex(luaL_checkstring(L, 1));
 				std::string raw_hex(luaL_checkstring(L, 2));
 				
 				try {
 					const auto& sig_bytes = uvm::lua::api::global_uvm_chain_api->hex_to_bytes(sig_hex);
 					const auto& raw_bytes = uvm::lua::api::global_uvm_chain_api->hex_to_bytes(raw_hex);
-					fc::ecc::compact_signature compact_sig;
-					if (sig_bytes.size() > compact_sig.size())
-						throw uvm::core::UvmException("invalid sig bytes size");
-					if (raw_bytes.size() != 32)
-						throw uvm::core::UvmException("raw bytes should be 32 bytes");
-					memcpy(compact_sig.data, sig_bytes.data(), sig_bytes.size());
-					fc::sha256 raw_bytes_as_digest((char*)raw_bytes.data(), raw_bytes.size());
-					auto recoved_public_key = fc::ecc::public_key(compact_sig, raw_bytes_as_digest, false);
-					if (!recoved_public_key.valid()) {
-						throw uvm::core::UvmException("invalid signature");
-					}
-					const auto& public_key_chars = recoved_public_key.serialize();
+					const auto& public_key_chars = recover_public_key((const char*)sig_bytes.data(), sig_bytes.size(), (const char*)raw_bytes.data(), raw_bytes.size());
 					std::vector<unsigned char> public_key_bytes(public_key_chars.begin(), public_key_chars.end());
 					const auto& public_key_hex = uvm::lua::api::global_uvm_chain_api->bytes_to_hex(public_key_bytes);
 					lua_pushstring(L, public_key_hex.c_str());
@@ -402,10 +427,7 @@ namespace uvm
 					}
 					std::string pubkey_hex(luaL_checkstring(L, 1));
 					std::vector<char> pubkey_chars;
-					try {
-						boost::algorithm::unhex(pubkey_hex, std::inserter(pubkey_chars, pubkey_chars.begin()));
-					}
-					catch (...) {
+					if (!uvm::util::hex_decode(pubkey_hex, pubkey_chars)) {
 						throw uvm::core::UvmException("invalid pubkey hex");
 					}
 					fc::ecc::public_key_data pubkey_data;
@@ -470,7 +492,7 @@ namespace uvm
 				}
 				try {
 					std::string str(luaL_checkstring(L, 1));
-					const auto& hex_str = fc::to_hex(str.c_str(), str.size());
+					const auto& hex_str = uvm::util::hex_encode(str);
 					lua_pushstring(L, hex_str.c_str());
 					return 1;
 				}
@@ -559,7 +581,7 @@ namespace uvm
 					cbor::output_dynamic output;
 					cbor::encoder encoder(output);
 					encoder.write_cbor_object(cbor_object.get());
-					const auto& output_hex = output.hex();
+					const auto& output_hex = uvm::util::hex_encode((const char*)output.data(), output.size(), true);
 					lua_pushstring(L, output_hex.c_str());
 					return 1;
 				}
@@ -585,10 +607,7 @@ namespace uvm
 				try {
 					std::string hex_str(luaL_checkstring(L, 1));
 					std::vector<char> input_bytes;
-					try {
-						boost::algorithm::unhex(hex_str, std::inserter(input_bytes, input_bytes.begin()));
-					}
-					catch (...) {
+					if (!uvm::util::hex_decode(hex_str, input_bytes)) {
 						throw uvm::core::UvmException("invalid hex string");
 					}
 					cbor::input input(input_bytes.data(), input_bytes.size());
@@ -709,6 +728,301 @@ namespace uvm
 				}
 			}
 
+			// the *_bin functions take and return binary strings, so contracts can skip the hex conversions
+
+			static int hex_to_bin(lua_State* L) {
+				// hex_to_bin(hex_str): binary string
+				if (lua_gettop(L) < 1 || !lua_isstring(L, 1)) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR,
+						"hex_to_bin need 1 hex string argument");
+					return 0;
+				}
+				size_t hex_size = 0;
+				auto hex_str = luaL_checklstring(L, 1, &hex_size);
+				if (hex_size % 2 != 0) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR,
+						"invalid hex string");
+					return 0;
+				}
+				luaL_Buffer buffer;
+				auto out = luaL_buffinitsize(L, &buffer, hex_size / 2);
+				if (!uvm::util::hex_decode(hex_str, hex_size, out)) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR,
+						"invalid hex string");
+					return 0;
+				}
+				luaL_pushresultsize(&buffer, hex_size / 2);
+				return 1;
+			}
+
+			static int bin_to_hex(lua_State* L) {
+				// bin_to_hex(data): lower case hex string, unlike str_to_hex data can contain '\0'
+				if (lua_gettop(L) < 1 || !lua_isstring(L, 1)) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR,
+						"bin_to_hex need 1 string argument");
+					return 0;
+				}
+				size_t size = 0;
+				auto data = luaL_checklstring(L, 1, &size);
+				luaL_Buffer buffer;
+				auto out = luaL_buffinitsize(L, &buffer, 2 * size);
+				uvm::util::hex_encode(data, size, out);
+				luaL_pushresultsize(&buffer, 2 * size);
+				return 1;
+			}
+
+			static int sha256_bin(lua_State* L) {
+				if (lua_gettop(L) < 1 || !lua_isstring(L, 1)) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR,
+						"sha256_bin need 1 string argument");
+					return 0;
+				}
+				size_t size = 0;
+				auto data = luaL_checklstring(L, 1, &size);
+				auto result = fc::sha256::hash(data, static_cast<uint32_t>(size));
+				lua_pushlstring(L, result.data(), result.data_size());
+				return 1;
+			}
+
+			static int sha1_bin(lua_State* L) {
+				if (lua_gettop(L) < 1 || !lua_isstring(L, 1)) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR,
+						"sha1_bin need 1 string argument");
+					return 0;
+				}
+				size_t size = 0;
+				auto data = luaL_checklstring(L, 1, &size);
+				auto result = fc::sha1::hash(data, static_cast<uint32_t>(size));
+				lua_pushlstring(L, result.data(), result.data_size());
+				return 1;
+			}
+
+			static int ripemd160_bin(lua_State* L) {
+				if (lua_gettop(L) < 1 || !lua_isstring(L, 1)) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR,
+						"ripemd160_bin need 1 string argument");
+					return 0;
+				}
+				size_t size = 0;
+				auto data = luaL_checklstring(L, 1, &size);
+				auto result = fc::ripemd160::hash(data, static_cast<uint32_t>(size));
+				lua_pushlstring(L, result.data(), result.data_size());
+				return 1;
+			}
+
+			static int sha3_bin(lua_State* L) {
+				if (lua_gettop(L) < 1 || !lua_isstring(L, 1)) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR,
+						"sha3_bin need 1 string argument");
+					return 0;
+				}
+				try {
+					size_t size = 0;
+					auto data = luaL_checklstring(L, 1, &size);
+					// keccak is provided by the chain api only
+					const auto& result_hex = uvm::lua::api::global_uvm_chain_api->sha3_hex(uvm::util::hex_encode(data, size));
+					std::string result;
+					if (!uvm::util::hex_decode(result_hex, result))
+						throw uvm::core::UvmException("invalid sha3 result");
+					lua_pushlstring(L, result.data(), result.size());
+					return 1;
+				}
+				catch (const std::exception& e) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR,
+						e.what());
+					return 0;
+				}
+				catch (...) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR,
+						"error when sha3_bin");
+					return 0;
+				}
+			}
+
+			static int signature_recover_bin(lua_State* L) {
+				// signature_recover_bin(sig, digest): public key binary string
+				if (lua_gettop(L) < 2 || !lua_isstring(L, 1) || !lua_isstring(L, 2)) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR, "signature_recover_bin need accept 2 string arguments");
+					L->force_stopping = true;
+					return 0;
+				}
+				uvm::lua::lib::charge_lvm_api_gas(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT * 10, "crypto", "signature_recover_bin");
+				size_t sig_size = 0;
+				size_t digest_size = 0;
+				auto sig = luaL_checklstring(L, 1, &sig_size);
+				auto digest = luaL_checklstring(L, 2, &digest_size);
+				try {
+					const auto& public_key = recover_public_key(sig, sig_size, digest, digest_size);
+					lua_pushlstring(L, public_key.data(), public_key.size());
+					return 1;
+				}
+				catch (const std::exception& e) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR,
+						e.what());
+					return 0;
+				}
+				catch (...) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR,
+						"error when signature_recover_bin");
+					return 0;
+				}
+			}
+
+			static const size_t signature_recover_batch_max_count = 1000;
+
+			static int signature_recover_batch(lua_State* L) {
+				// signature_recover_batch(sig_hex_array, raw_hex_array): array of public_key_hex_string, "" for an invalid signature
+				if (lua_gettop(L) < 2 || !lua_istable(L, 1) || !lua_istable(L, 2)) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR, "signature_recover_batch need accept 2 arrays of hex strings");
+					L->force_stopping = true;
+					return 0;
+				}
+				auto count = lua_rawlen(L, 1);
+				if (count != lua_rawlen(L, 2) || count > signature_recover_batch_max_count) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR,
+						"signature_recover_batch need 2 arrays of the same size, at most %d items", int(signature_recover_batch_max_count));
+					L->force_stopping = true;
+					return 0;
+				}
+				// each item costs as much as a signature_recover, charged before recovering so cache hits don't change it
+				uvm::lua::lib::charge_lvm_api_gas(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT * 10 * int(std::max<size_t>(count, 1)), "crypto", "signature_recover_batch");
+				try {
+					std::vector<SignatureRecoverCache::signature_item> items;
+					items.reserve(count);
+					for (size_t i = 1; i <= count; i++) {
+						lua_rawgeti(L, 1, lua_Integer(i));
+						lua_rawgeti(L, 2, lua_Integer(i));
+						if (!lua_isstring(L, -2) || !lua_isstring(L, -1))
+							throw uvm::core::UvmException("signature_recover_batch need arrays of hex strings");
+						const auto& sig_bytes = uvm::lua::api::global_uvm_chain_api->hex_to_bytes(lua_tostring(L, -2));
+						const auto& raw_bytes = uvm::lua::api::global_uvm_chain_api->hex_to_bytes(lua_tostring(L, -1));
+						lua_pop(L, 2);
+						items.push_back(to_signature_item((const char*)sig_bytes.data(), sig_bytes.size(), (const char*)raw_bytes.data(), raw_bytes.size()));
+					}
+					const auto& public_keys = SignatureRecoverCache::instance().recover_batch(items);
+					lua_createtable(L, int(count), 0);
+					for (size_t i = 0; i < public_keys.size(); i++) {
+						std::string public_key_hex;
+						if (public_keys[i].valid()) {
+							const auto& public_key_chars = public_keys[i].serialize();
+							std::vector<unsigned char> public_key_bytes(public_key_chars.begin(), public_key_chars.end());
+							public_key_hex = uvm::lua::api::global_uvm_chain_api->bytes_to_hex(public_key_bytes);
+						}
+						lua_pushstring(L, public_key_hex.c_str());
+						lua_rawseti(L, -2, lua_Integer(i + 1));
+					}
+					return 1;
+				}
+				catch (const std::exception& e) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR,
+						e.what());
+					return 0;
+				}
+				catch (...) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR,
+						"error when signature_recover_batch");
+					return 0;
+				}
+			}
+
+#define UVM_HASHER_METATABLE "UvmHasher_metatable"
+
+			enum UvmHasherAlgorithm {
+				UVM_HASHER_SHA256 = 1,
+				UVM_HASHER_SHA1 = 2,
+				UVM_HASHER_RIPEMD160 = 3
+			};
+
+			/**
+			 * state of a hasher object, kept in a full userdata.
+			 * vmgc runs no __gc, the fc encoders keep their state inline(fc::fwd) so the userdata memory is all they own
+			 */
+			struct UvmHasher {
+				int algorithm;
+				fc::sha256::encoder sha256_encoder;
+				fc::sha1::encoder sha1_encoder;
+				fc::ripemd160::encoder ripemd160_encoder;
+			};
+
+			static int new_hasher(lua_State* L) {
+				// new_hasher(algorithm): hasher, algorithm is sha256, sha1 or ripemd160
+				// hasher:update(data) hashes more data and returns the hasher, hasher:digest()/hasher:hexdigest() returns the hash of all data so far
+				if (lua_gettop(L) < 1 || !lua_isstring(L, 1)) {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR,
+						"new_hasher need 1 algorithm name argument");
+					return 0;
+				}
+				std::string algorithm_name(luaL_checkstring(L, 1));
+				int algorithm;
+				if (algorithm_name == "sha256")
+					algorithm = UVM_HASHER_SHA256;
+				else if (algorithm_name == "sha1")
+					algorithm = UVM_HASHER_SHA1;
+				else if (algorithm_name == "ripemd160")
+					algorithm = UVM_HASHER_RIPEMD160;
+				else {
+					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR,
+						"new_hasher only supports sha256, sha1 and ripemd160");
+					return 0;
+				}
+				auto hasher = new (lua_newuserdata(L, sizeof(UvmHasher))) UvmHasher();
+				hasher->algorithm = algorithm;
+				luaL_getmetatable(L, UVM_HASHER_METATABLE);
+				lua_setmetatable(L, -2);
+				return 1;
+			}
+
+			static int uvm_core_lib_Hasher_update(lua_State* L) {
+				auto hasher = (UvmHasher*)luaL_checkudata(L, 1, UVM_HASHER_METATABLE);
+				size_t size = 0;
+				auto data = luaL_checklstring(L, 2, &size);
+				switch (hasher->algorithm) {
+				case UVM_HASHER_SHA256: hasher->sha256_encoder.write(data, static_cast<uint32_t>(size)); break;
+				case UVM_HASHER_SHA1: hasher->sha1_encoder.write(data, static_cast<uint32_t>(size)); break;
+				case UVM_HASHER_RIPEMD160: hasher->ripemd160_encoder.write(data, static_cast<uint32_t>(size)); break;
+				default: break;
+				}
+				lua_pushvalue(L, 1);
+				return 1;
+			}
+
+			// hash of the data so far, the hasher can still be updated
+			static std::string hasher_result(const UvmHasher* hasher) {
+				switch (hasher->algorithm) {
+				case UVM_HASHER_SHA256: {
+					auto encoder = hasher->sha256_encoder;
+					auto result = encoder.result();
+					return std::string(result.data(), result.data_size());
+				}
+				case UVM_HASHER_SHA1: {
+					auto encoder = hasher->sha1_encoder;
+					auto result = encoder.result();
+					return std::string(result.data(), result.data_size());
+				}
+				case UVM_HASHER_RIPEMD160: {
+					auto encoder = hasher->ripemd160_encoder;
+					auto result = encoder.result();
+					return std::string(result.data(), result.data_size());
+				}
+				default:
+					return std::string();
+				}
+			}
+
+			static int uvm_core_lib_Hasher_digest(lua_State* L) {
+				auto hasher = (UvmHasher*)luaL_checkudata(L, 1, UVM_HASHER_METATABLE);
+				const auto& result = hasher_result(hasher);
+				lua_pushlstring(L, result.data(), result.size());
+				return 1;
+			}
+
+			static int uvm_core_lib_Hasher_hexdigest(lua_State* L) {
+				auto hasher = (UvmHasher*)luaL_checkudata(L, 1, UVM_HASHER_METATABLE);
+				const auto& result = uvm::util::hex_encode(hasher_result(hasher));
+				lua_pushlstring(L, result.data(), result.size());
+				return 1;
+			}
+
 			static int delegate_call(lua_State* L) {
 				// delegate_call(contractAddr: string, apiName: string, params args: object[]): object
 				auto top = lua_gettop(L);
@@ -1461,10 +1775,10 @@ namespace uvm
 				// fast_map_get(storage_name, key)
 				auto common_gas = 50;
 				if (uvm::lua::lib::get_lua_state_instructions_executed_count(L) > gas_penalty_threshold) {
-					uvm::lua::lib::increment_lvm_instructions_executed_count(L, 2 * common_gas - 1);
+					uvm::lua::lib::charge_lvm_api_gas(L, 2 * common_gas, "storage", "fast_map_get");
 				}
 				else {
-					uvm::lua::lib::increment_lvm_instructions_executed_count(L, common_gas - 1);
+					uvm::lua::lib::charge_lvm_api_gas(L, common_gas, "storage", "fast_map_get");
 				}
 				if (lua_gettop(L) < 2 || !lua_isstring(L, 1) || !lua_isstring(L, 2)) {
 					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR, "invalid arguments of fast_map_get");
@@ -1483,10 +1797,10 @@ namespace uvm
 				// fast_map_set(storage, key, value)
 				auto common_gas = 100;
 				if (uvm::lua::lib::get_lua_state_instructions_executed_count(L) > gas_penalty_threshold) {
-					uvm::lua::lib::increment_lvm_instructions_executed_count(L, 2 * common_gas - 1);
+					uvm::lua::lib::charge_lvm_api_gas(L, 2 * common_gas, "storage", "fast_map_set");
 				}
 				else {
-					uvm::lua::lib::increment_lvm_instructions_executed_count(L, common_gas - 1);
+					uvm::lua::lib::charge_lvm_api_gas(L, common_gas, "storage", "fast_map_set");
 				}
 				if (lua_gettop(L) < 3 || !lua_isstring(L, 1) || !lua_isstring(L, 2)) {
 					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR, "invalid arguments of fast_map_set");
@@ -1600,10 +1914,10 @@ end
 			{
 				auto common_gas = 100;
 				if (uvm::lua::lib::get_lua_state_instructions_executed_count(L) > gas_penalty_threshold) {
-					uvm::lua::lib::increment_lvm_instructions_executed_count(L, 2 * common_gas - 1);
+					uvm::lua::lib::charge_lvm_api_gas(L, 2 * common_gas, "call", "send_message");
 				}
 				else {
-					uvm::lua::lib::increment_lvm_instructions_executed_count(L, common_gas - 1);
+					uvm::lua::lib::charge_lvm_api_gas(L, common_gas, "call", "send_message");
 				}
 				if (lua_gettop(L) < 3 || !lua_isstring(L, 1) || !lua_isstring(L, 2) || !lua_istable(L, 3)) {
 					uvm::lua::api::global_uvm_chain_api->throw_exception(L, UVM_API_SIMPLE_ERROR, "invalid arguments of send_message");
@@ -1666,6 +1980,8 @@ end
 				
 				auto Lbak = &LbakStruct;
 				Lbak->oldpc = L->oldpc;
+				// the stack can be moved(and the old one freed) by the call, so keep the top as an offset
+				auto orig_top = savestack(L, L->top);
 
 				//call api func
 				lua_insert(L, 4);
@@ -1779,13 +2095,11 @@ end
 					L->ci_depth = Lbak->ci_depth;
 					L->basehookcount = Lbak->basehookcount;
 					L->evalstacktop = Lbak->evalstacktop;
-					L->nci = Lbak->nci;
-					L->top = Lbak->top;
+					L->top = restorestack(L, orig_top);
 					L->nCcalls = Lbak->nCcalls;
 					L->memerrmsg = Lbak->memerrmsg;
 					L->ci_depth = Lbak->ci_depth;
 					L->oldpc = Lbak->oldpc;
-					L->stack_last = Lbak->stack_last;
 					L->allow_contract_modify = Lbak->allow_contract_modify;
 					L->state = Lbak->state;
 					L->errorJmp = Lbak->errorJmp;
@@ -1858,6 +2172,17 @@ end
 				lua_pop(L, 1);
 
 				add_global_c_function(L, "Stream", &uvm_core_lib_Stream);
+
+				luaL_newmetatable(L, UVM_HASHER_METATABLE);
+				lua_pushcfunction(L, &uvm_core_lib_Hasher_update);
+				lua_setfield(L, -2, "update");
+				lua_pushcfunction(L, &uvm_core_lib_Hasher_digest);
+				lua_setfield(L, -2, "digest");
+				lua_pushcfunction(L, &uvm_core_lib_Hasher_hexdigest);
+				lua_setfield(L, -2, "hexdigest");
+				lua_pushvalue(L, -1);
+				lua_setfield(L, -2, "__index");
+				lua_pop(L, 1);
 				
 				lua_createtable(L, 0, 0);
 				lua_pushcfunction(L, &uvm_core_lib_storage_metatable_index);
@@ -1899,6 +2224,13 @@ end
 				add_global_c_function(L, "sha1_hex", sha1_hex);
 				add_global_c_function(L, "sha3_hex", sha3_hex);
 				add_global_c_function(L, "ripemd160_hex", ripemd160_hex);
+				add_global_c_function(L, "hex_to_bin", hex_to_bin);
+				add_global_c_function(L, "bin_to_hex", bin_to_hex);
+				add_global_c_function(L, "sha256_bin", sha256_bin);
+				add_global_c_function(L, "sha1_bin", sha1_bin);
+				add_global_c_function(L, "sha3_bin", sha3_bin);
+				add_global_c_function(L, "ripemd160_bin", ripemd160_bin);
+				add_global_c_function(L, "new_hasher", new_hasher);
 
 				reset_lvm_instructions_executed_count(L);
                 lua_atpanic(L, panic_message);
@@ -1927,6 +2259,8 @@ end
 					add_global_c_function(L, "cbor_encode", &cbor_encode);
 					add_global_c_function(L, "cbor_decode", &cbor_decode);
 					add_global_c_function(L, "signature_recover", &signature_recover);
+					add_global_c_function(L, "signature_recover_bin", &signature_recover_bin);
+					add_global_c_function(L, "signature_recover_batch", &signature_recover_batch);
 					add_global_c_function(L, "get_address_role", &get_address_role);
 					add_global_c_function(L, "pubkey_to_address", &pubkey_to_address);
 					add_global_c_function(L, "in_delegate_call", &in_delegate_call);
@@ -2031,7 +2365,7 @@ end
                         lua_free(L, stopped_pointer);
                     }
                     
-                    states_map->erase(L);
+                    erase_value_map_of_lua_state(L);
                 }
 
                 lua_close(L);
@@ -2042,13 +2376,13 @@ end
             */
             void close_all_lua_state_values()
             {
+                std::lock_guard<std::mutex> lock(states_map_mutex);
                 LStatesMap *states_map = get_lua_states_value_hashmap();
                 states_map->clear();
             }
             void close_lua_state_values(lua_State *L)
             {
-                LStatesMap *states_map = get_lua_states_value_hashmap();
-                states_map->erase(L);
+                erase_value_map_of_lua_state(L);
             }
 
             UvmStateValueNode get_lua_state_value_node(lua_State *L, const char *key)
@@ -2087,6 +2421,16 @@ end
                 return get_lua_state_value(L, INSTRUCTIONS_LIMIT_LUA_STATE_MAP_KEY).int_value;
             }
 
+            void set_lua_state_api_instructions_limit(lua_State *L, int64_t limit)
+            {
+                L->api_instructions_limit = limit;
+            }
+
+            void set_lua_state_gas_per_instruction(lua_State *L, bool gas_per_instruction)
+            {
+                L->gas_per_instruction = gas_per_instruction;
+            }
+
             int get_lua_state_instructions_executed_count(lua_State *L)
             {
 				int64_t *insts_executed_count = get_lua_state_value(L, INSTRUCTIONS_EXECUTED_COUNT_LUA_STATE_MAP_KEY).int_pointer_value;
@@ -2713,6 +3057,18 @@ end
               }
             }
 
+            void charge_lvm_api_gas(lua_State *L, int api_gas, const char *category, const char *subcategory, const char *subcategory_suffix)
+            {
+                increment_lvm_instructions_executed_count(L, api_gas - 1);
+                if (L->gas_ledger)
+                {
+                    std::string full_subcategory(subcategory);
+                    if (subcategory_suffix)
+                        full_subcategory += subcategory_suffix;
+                    L->gas_ledger->add(category, full_subcategory, api_gas);
+                }
+            }
+
             int execute_contract_api(lua_State *L, const char *contract_name,
 				const char *api_name, cbor::CborArrayValue& args, std::string *result_json_string)
             {
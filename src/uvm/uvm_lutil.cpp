@@ -13,6 +13,11 @@
 #include <fc/crypto/hex.hpp>
 #include <fc/variant_object.hpp>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UVM_HEX_USE_SSE2
+#endif
+
 namespace uvm
 {
 	namespace util
@@ -132,6 +137,129 @@ namespace uvm
 			return result;
 		}
 
+		static const char lower_hex_chars[] = "0123456789abcdef";
+		static const char upper_hex_chars[] = "0123456789ABCDEF";
+
+		// hex char => value, -1 for non-hex chars
+		static int hex_char_value(char c)
+		{
+			if (c >= '0' && c <= '9')
+				return c - '0';
+			if (c >= 'a' && c <= 'f')
+				return c - 'a' + 10;
+			if (c >= 'A' && c <= 'F')
+				return c - 'A' + 10;
+			return -1;
+		}
+
+#ifdef UVM_HEX_USE_SSE2
+		// nibbles(0-15) to hex chars
+		static inline __m128i sse2_nibbles_to_hex(__m128i nibbles, __m128i alpha_offset)
+		{
+			auto over_9 = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+			auto chars = _mm_add_epi8(nibbles, _mm_set1_epi8('0'));
+			return _mm_add_epi8(chars, _mm_and_si128(over_9, alpha_offset));
+		}
+
+		// hex chars to nibbles, sets the invalid lanes of invalid
+		static inline __m128i sse2_hex_to_nibbles(__m128i chars, __m128i& invalid)
+		{
+			// chars >= 0x80 are negative so fail both ranges
+			auto is_digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+			auto lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+			auto is_alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+			auto digits = _mm_and_si128(is_digit, _mm_sub_epi8(chars, _mm_set1_epi8('0')));
+			auto alphas = _mm_and_si128(is_alpha, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10)));
+			invalid = _mm_or_si128(invalid, _mm_andnot_si128(_mm_or_si128(is_digit, is_alpha), _mm_set1_epi8(-1)));
+			return _mm_or_si128(digits, alphas);
+		}
+
+		// pairs of nibbles(high first) in 16-bit lanes to bytes in the low half of the lanes
+		static inline __m128i sse2_join_nibbles(__m128i nibbles)
+		{
+			auto high = _mm_and_si128(nibbles, _mm_set1_epi16(0x00ff));
+			auto low = _mm_srli_epi16(nibbles, 8);
+			return _mm_or_si128(_mm_slli_epi16(high, 4), low);
+		}
+#endif
+
+		void hex_encode(const char* data, size_t size, char* out, bool upper_case)
+		{
+			const char* hex_chars = upper_case ? upper_hex_chars : lower_hex_chars;
+			size_t i = 0;
+#ifdef UVM_HEX_USE_SSE2
+			auto alpha_offset = _mm_set1_epi8(upper_case ? ('A' - '0' - 10) : ('a' - '0' - 10));
+			auto low_mask = _mm_set1_epi8(0x0f);
+			for (; i + 16 <= size; i += 16) {
+				auto bytes = _mm_loadu_si128((const __m128i*)(data + i));
+				auto high = sse2_nibbles_to_hex(_mm_and_si128(_mm_srli_epi16(bytes, 4), low_mask), alpha_offset);
+				auto low = sse2_nibbles_to_hex(_mm_and_si128(bytes, low_mask), alpha_offset);
+				_mm_storeu_si128((__m128i*)(out + 2 * i), _mm_unpacklo_epi8(high, low));
+				_mm_storeu_si128((__m128i*)(out + 2 * i + 16), _mm_unpackhi_epi8(high, low));
+			}
+#endif
+			for (; i < size; i++) {
+				auto byte = (unsigned char)data[i];
+				out[2 * i] = hex_chars[byte >> 4];
+				out[2 * i + 1] = hex_chars[byte & 0x0f];
+			}
+		}
+
+		std::string hex_encode(const char* data, size_t size, bool upper_case)
+		{
+			std::string result(2 * size, '\0');
+			if (size > 0)
+				hex_encode(data, size, &result[0], upper_case);
+			return result;
+		}
+
+		std::string hex_encode(const std::string& data, bool upper_case)
+		{
+			return hex_encode(data.data(), data.size(), upper_case);
+		}
+
+		bool hex_decode(const char* hex, size_t size, char* out)
+		{
+			if (size % 2 != 0)
+				return false;
+			size_t i = 0;
+#ifdef UVM_HEX_USE_SSE2
+			auto invalid = _mm_setzero_si128();
+			for (; i + 32 <= size; i += 32) {
+				auto first = sse2_hex_to_nibbles(_mm_loadu_si128((const __m128i*)(hex + i)), invalid);
+				auto second = sse2_hex_to_nibbles(_mm_loadu_si128((const __m128i*)(hex + i + 16)), invalid);
+				auto bytes = _mm_packus_epi16(sse2_join_nibbles(first), sse2_join_nibbles(second));
+				_mm_storeu_si128((__m128i*)(out + i / 2), bytes);
+			}
+			if (_mm_movemask_epi8(invalid) != 0)
+				return false;
+#endif
+			for (; i < size; i += 2) {
+				auto high = hex_char_value(hex[i]);
+				auto low = hex_char_value(hex[i + 1]);
+				if (high < 0 || low < 0)
+					return false;
+				out[i / 2] = (char)((high << 4) | low);
+			}
+			return true;
+		}
+
+		bool hex_decode(const std::string& hex, std::string& out)
+		{
+			if (hex.size() % 2 != 0)
+				return false;
+			out.resize(hex.size() / 2);
+			return out.empty() || hex_decode(hex.data(), hex.size(), &out[0]);
+		}
+
+		bool hex_decode(const std::string& hex, std::vector<char>& out)
+		{
+			if (hex.size() % 2 != 0)
+				return false;
+			out.resize(hex.size() / 2);
+			return out.empty() || hex_decode(hex.data(), hex.size(), out.data());
+		}
+
 		std::vector<std::string> &string_split(const std::string &s, char delim, std::vector<std::string> &elems)
 		{
 			std::stringstream ss(s);
@@ -378,14 +506,7 @@ namespace uvm
 		}
 
 		std::string buffer_to_hex(const Buffer& buffer) {
-			std::vector<char> chars(buffer.size());
-			memcpy(chars.data(), buffer.data(), buffer.size());
-			try {
-				return fc::to_hex(chars);
-			}
-			catch (const std::exception& e) {
-				throw uvm::core::UvmException(e.what());
-			}
+			return hex_encode((const char*)buffer.data(), buffer.size());
 		}
 
 		int64_t hex_to_int(const std::string& hex_str) {
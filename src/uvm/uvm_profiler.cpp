@@ -0,0 +1,285 @@
+#include <uvm/lprefix.h>
+#include <uvm/uvm_profiler.h>
+#include <uvm/lua.h>
+#include <uvm/lobject.h>
+#include <uvm/lopcodes.h>
+#include <uvm/lstate.h>
+#include <algorithm>
+#include <sstream>
+#include <stdio.h>
+
+namespace uvm
+{
+    namespace lua
+    {
+        namespace lib
+        {
+
+			static void write_json_string(std::ostringstream& out, const std::string& str)
+			{
+				out << '"';
+				for (auto c : str) {
+					switch (c) {
+					case '"': out << "\\\""; break;
+					case '\\': out << "\\\\"; break;
+					case '\n': out << "\\n"; break;
+					case '\r': out << "\\r"; break;
+					case '\t': out << "\\t"; break;
+					default:
+						if ((unsigned char)c < 0x20) {
+							char buf[8];
+							snprintf(buf, sizeof(buf), "\\u%04x", (unsigned int)(unsigned char)c);
+							out << buf;
+						}
+						else {
+							out << c;
+						}
+					}
+				}
+				out << '"';
+			}
+
+			static void write_json_counter(std::ostringstream& out, const UvmProfiler::Counter& counter)
+			{
+				out << "\"count\":" << counter.count << ",\"time_ns\":" << counter.time_ns;
+			}
+
+			UvmProfiler::UvmProfiler()
+			{
+				reset();
+			}
+
+			void UvmProfiler::reset()
+			{
+				_opcode_counts.assign(UNUM_OPCODES, 0);
+				_instructions_count = 0;
+				_charged_ns = 0;
+				_functions.clear();
+				_cfunctions.clear();
+				_stacks.clear();
+				_cframes.clear();
+				_ci = nullptr;
+				_proto = nullptr;
+				_function = nullptr;
+				_stack_key = nullptr;
+				_stack = nullptr;
+				_has_last = false;
+				_last_function = nullptr;
+				_last_line = nullptr;
+				_last_stack = nullptr;
+			}
+
+			void UvmProfiler::charge_elapsed(clock_type::time_point now)
+			{
+				if (!_has_last)
+					return;
+				auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - _last_time).count();
+				_last_function->time_ns += elapsed;
+				_last_line->time_ns += elapsed;
+				_last_stack->time_ns += elapsed;
+				_charged_ns += elapsed;
+				_last_time = now;
+			}
+
+			std::string UvmProfiler::proto_name(const uvm_types::GcProto* p)
+			{
+				std::string source = p->source ? std::string(getstr(p->source)) : std::string("?");
+				return source + ":" + std::to_string(p->linedefined);
+			}
+
+			std::string UvmProfiler::frame_name(CallInfo* ci) const
+			{
+				if (isLua(ci))
+					return proto_name(clLvalue(ci->func)->p);
+				lua_CFunction f = nullptr;
+				if (ttisCclosure(ci->func))
+					f = clCvalue(ci->func)->f;
+				else if (ttislcf(ci->func))
+					f = fvalue(ci->func);
+				auto found = _cfunctions.find(f);
+				return found != _cfunctions.end() ? found->second.name : std::string("?");
+			}
+
+			void UvmProfiler::enter_frame(lua_State* L, CallInfo* ci, uvm_types::GcProto* p)
+			{
+				std::vector<CallInfo*> frames;
+				for (auto frame = ci; frame && frame != &L->base_ci; frame = frame->previous)
+					frames.push_back(frame);
+				std::string stack_key;
+				for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+					if (!stack_key.empty())
+						stack_key += ";";
+					stack_key += frame_name(*it);
+				}
+				auto stack_it = _stacks.insert(std::make_pair(stack_key, Counter())).first;
+				_stack_key = &stack_it->first;
+				_stack = &stack_it->second;
+				_function = &_functions[proto_name(p)];
+				_ci = ci;
+				_proto = p;
+			}
+
+			void UvmProfiler::on_instruction(lua_State* L, CallInfo* ci, uvm_types::GcProto* p, int pc, int opcode)
+			{
+				auto now = clock_type::now();
+				charge_elapsed(now);
+				if (ci != _ci || p != _proto)
+					enter_frame(L, ci, p);
+				if (opcode >= 0 && size_t(opcode) < _opcode_counts.size())
+					++_opcode_counts[opcode];
+				++_instructions_count;
+				int line = (pc >= 0 && size_t(pc) < p->lineinfos.size()) ? p->lineinfos[pc] : -1;
+				auto& line_counter = _function->lines[line];
+				++_function->total.count;
+				++line_counter.count;
+				++_stack->count;
+				_has_last = true;
+				_last_time = now;
+				_last_function = &_function->total;
+				_last_line = &line_counter;
+				_last_stack = _stack;
+			}
+
+			void UvmProfiler::on_cfunction_enter(lua_State* L, lua_CFunction f)
+			{
+				auto now = clock_type::now();
+				charge_elapsed(now);
+				auto found = _cfunctions.find(f);
+				if (found == _cfunctions.end()) {
+					// name it by the calling code, eg. the field name of json.dumps
+					CFunctionStats stats;
+					lua_Debug ar;
+					if (lua_getstack(L, 0, &ar) && lua_getinfo(L, "n", &ar) && ar.name)
+						stats.name = ar.name;
+					else
+						stats.name = "?";
+					found = _cfunctions.insert(std::make_pair(f, stats)).first;
+				}
+				++found->second.total.count;
+				CFrame frame;
+				frame.f = f;
+				frame.ci = L->ci;
+				frame.start = now;
+				frame.charged_ns_at_start = _charged_ns;
+				frame.stack_key = _stack_key;
+				frame.has_last = _has_last;
+				frame.last_function = _last_function;
+				frame.last_line = _last_line;
+				frame.last_stack = _last_stack;
+				_cframes.push_back(frame);
+				// lua code called by the C function starts new frames
+				_has_last = false;
+				_ci = nullptr;
+			}
+
+			void UvmProfiler::on_cfunction_leave(lua_State* L)
+			{
+				// drop frames of C functions left by errors
+				while (!_cframes.empty() && _cframes.back().ci != L->ci)
+					_cframes.pop_back();
+				if (_cframes.empty())
+					return;
+				auto frame = _cframes.back();
+				_cframes.pop_back();
+				auto now = clock_type::now();
+				charge_elapsed(now);
+				auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - frame.start).count();
+				auto& stats = _cfunctions[frame.f];
+				stats.total.time_ns += elapsed;
+				// time of lua code called by it was charged to that code already
+				auto self_ns = elapsed - (_charged_ns - frame.charged_ns_at_start);
+				std::string stack_key = frame.stack_key ? (*frame.stack_key + ";" + stats.name) : stats.name;
+				_stacks[stack_key].time_ns += self_ns;
+				_charged_ns += self_ns;
+				_has_last = frame.has_last;
+				_last_time = now;
+				_last_function = frame.last_function;
+				_last_line = frame.last_line;
+				_last_stack = frame.last_stack;
+				_ci = nullptr;
+			}
+
+			void UvmProfiler::on_execute_leave(lua_State* L)
+			{
+				charge_elapsed(clock_type::now());
+				_has_last = false;
+				_ci = nullptr;
+			}
+
+			std::string UvmProfiler::to_collapsed_stacks(bool by_time) const
+			{
+				std::map<std::string, int64_t> weights;
+				for (const auto& p : _stacks) {
+					auto weight = by_time ? p.second.time_ns / 1000 : int64_t(p.second.count);
+					if (weight > 0)
+						weights[p.first] = weight;
+				}
+				std::ostringstream out;
+				for (const auto& p : weights) {
+					out << p.first << " " << p.second << "\n";
+				}
+				return out.str();
+			}
+
+			std::string UvmProfiler::to_json() const
+			{
+				std::ostringstream out;
+				out << "{\"instructions\":" << _instructions_count << ",\"time_ns\":" << _charged_ns;
+				out << ",\"opcodes\":{";
+				bool first = true;
+				for (size_t i = 0; i < _opcode_counts.size(); ++i) {
+					if (_opcode_counts[i] == 0)
+						continue;
+					if (!first)
+						out << ",";
+					first = false;
+					write_json_string(out, luaP_opnames[i]);
+					out << ":" << _opcode_counts[i];
+				}
+				out << "},\"functions\":[";
+				first = true;
+				for (const auto& p : _functions) {
+					if (!first)
+						out << ",";
+					first = false;
+					out << "{\"name\":";
+					write_json_string(out, p.first);
+					out << ",";
+					write_json_counter(out, p.second.total);
+					out << ",\"lines\":{";
+					bool first_line = true;
+					for (const auto& line : p.second.lines) {
+						if (!first_line)
+							out << ",";
+						first_line = false;
+						out << "\"" << line.first << "\":{";
+						write_json_counter(out, line.second);
+						out << "}";
+					}
+					out << "}}";
+				}
+				out << "],\"cfunctions\":[";
+				first = true;
+				std::vector<const CFunctionStats*> cfunctions;
+				for (const auto& p : _cfunctions)
+					cfunctions.push_back(&p.second);
+				std::sort(cfunctions.begin(), cfunctions.end(), [](const CFunctionStats* a, const CFunctionStats* b) {
+					return a->total.time_ns > b->total.time_ns;
+				});
+				for (const auto stats : cfunctions) {
+					if (!first)
+						out << ",";
+					first = false;
+					out << "{\"name\":";
+					write_json_string(out, stats->name);
+					out << ",";
+					write_json_counter(out, stats->total);
+					out << "}";
+				}
+				out << "]}";
+				return out.str();
+			}
+
+        }
+    }
+}
@@ -0,0 +1,183 @@
+#include <uvm/uvm_signature_cache.h>
+#include <algorithm>
+#include <thread>
+
+namespace uvm
+{
+    namespace lua
+    {
+        namespace lib
+        {
+
+			// batches with fewer uncached signatures are recovered in the calling thread
+			static const size_t parallel_recover_min_count = 8;
+
+			SignatureRecoverCache::SignatureRecoverCache(size_t capacity)
+				: _capacity(capacity), _hits(0), _misses(0)
+			{
+			}
+
+			SignatureRecoverCache& SignatureRecoverCache::instance()
+			{
+				static SignatureRecoverCache cache;
+				return cache;
+			}
+
+			std::string SignatureRecoverCache::cache_key(const fc::ecc::compact_signature& sig, const fc::sha256& digest)
+			{
+				std::string key((const char*)sig.data, sig.size());
+				key.append(digest.data(), digest.data_size());
+				return key;
+			}
+
+			SignatureRecoverCache::entry SignatureRecoverCache::to_entry(const fc::ecc::public_key& key)
+			{
+				entry e;
+				e.valid = key.valid();
+				if (e.valid)
+					e.key = key.serialize();
+				return e;
+			}
+
+			fc::ecc::public_key SignatureRecoverCache::from_entry(const entry& e)
+			{
+				return e.valid ? fc::ecc::public_key(e.key) : fc::ecc::public_key();
+			}
+
+			bool SignatureRecoverCache::find(const std::string& key, entry& e)
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				auto found = _index.find(key);
+				if (found == _index.end()) {
+					++_misses;
+					return false;
+				}
+				++_hits;
+				_items.splice(_items.begin(), _items, found->second);
+				e = found->second->second;
+				return true;
+			}
+
+			void SignatureRecoverCache::put(const std::string& key, const entry& e)
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				if (_capacity == 0)
+					return;
+				auto found = _index.find(key);
+				if (found != _index.end()) {
+					found->second->second = e;
+					_items.splice(_items.begin(), _items, found->second);
+					return;
+				}
+				_items.push_front(std::make_pair(key, e));
+				_index[key] = _items.begin();
+				while (_items.size() > _capacity) {
+					_index.erase(_items.back().first);
+					_items.pop_back();
+				}
+			}
+
+			fc::ecc::public_key SignatureRecoverCache::recover(const fc::ecc::compact_signature& sig, const fc::sha256& digest)
+			{
+				const auto& key = cache_key(sig, digest);
+				entry e;
+				if (find(key, e))
+					return from_entry(e);
+				fc::ecc::public_key result(sig, digest, false);
+				put(key, to_entry(result));
+				return result;
+			}
+
+			// joins the started threads on every exit, a joinable std::thread terminates the process when destroyed
+			struct recover_threads_joiner
+			{
+				std::vector<std::thread> threads;
+
+				void join_all()
+				{
+					for (auto& t : threads) {
+						if (t.joinable())
+							t.join();
+					}
+				}
+				~recover_threads_joiner() { join_all(); }
+			};
+
+			std::vector<fc::ecc::public_key> SignatureRecoverCache::recover_batch(const std::vector<signature_item>& items, size_t max_threads)
+			{
+				std::vector<fc::ecc::public_key> results(items.size());
+				std::vector<std::string> keys(items.size());
+				std::vector<size_t> uncached;
+				for (size_t i = 0; i < items.size(); ++i) {
+					keys[i] = cache_key(items[i].first, items[i].second);
+					entry e;
+					if (find(keys[i], e))
+						results[i] = from_entry(e);
+					else
+						uncached.push_back(i);
+				}
+				auto recover_range = [&](size_t begin, size_t end) {
+					for (size_t j = begin; j < end; ++j) {
+						auto i = uncached[j];
+						try {
+							results[i] = fc::ecc::public_key(items[i].first, items[i].second, false);
+							put(keys[i], to_entry(results[i]));
+						}
+						catch (...) {
+							results[i] = fc::ecc::public_key();
+						}
+					}
+				};
+				auto threads_count = std::min(max_threads, uncached.size());
+				if (uncached.size() < parallel_recover_min_count || threads_count <= 1) {
+					recover_range(0, uncached.size());
+					return results;
+				}
+				auto per_thread = (uncached.size() + threads_count - 1) / threads_count;
+				recover_threads_joiner joiner;
+				size_t begin = per_thread;
+				try {
+					joiner.threads.reserve(threads_count - 1);
+					for (; begin < uncached.size(); begin += per_thread) {
+						joiner.threads.push_back(std::thread(recover_range, begin, std::min(begin + per_thread, uncached.size())));
+					}
+				}
+				catch (...) {
+					// no more threads can be started, the ranges left are recovered in this thread
+					recover_range(begin, uncached.size());
+				}
+				recover_range(0, std::min(per_thread, uncached.size()));
+				joiner.join_all();
+				return results;
+			}
+
+			size_t SignatureRecoverCache::size() const
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				return _items.size();
+			}
+
+			uint64_t SignatureRecoverCache::hits() const
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				return _hits;
+			}
+
+			uint64_t SignatureRecoverCache::misses() const
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				return _misses;
+			}
+
+			void SignatureRecoverCache::clear()
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_items.clear();
+				_index.clear();
+				_hits = 0;
+				_misses = 0;
+			}
+
+        }
+    }
+}
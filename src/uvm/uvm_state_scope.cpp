@@ -29,6 +29,7 @@
 #include <uvm/lauxlib.h>
 #include <uvm/lualib.h>
 #include <uvm/uvm_gas_manager.h>
+#include <uvm/uvm_profiler.h>
 
 using uvm::lua::api::global_uvm_chain_api;
 
@@ -77,6 +78,26 @@ namespace uvm
 				return ref;
 			}
 
+			GasLedger::GasLedger() : _total(0) {}
+
+			void GasLedger::add(const std::string& category, const std::string& subcategory, int64_t gas) {
+				_entries[category][subcategory] += gas;
+				_total += gas;
+			}
+
+			const GasLedger::entries_type& GasLedger::entries() const {
+				return _entries;
+			}
+
+			int64_t GasLedger::total() const {
+				return _total;
+			}
+
+			void GasLedger::clear() {
+				_entries.clear();
+				_total = 0;
+			}
+
             UvmStateScope::UvmStateScope(bool use_contract, bool allow_change_global)
                 :_use_contract(use_contract), _allow_change_global(allow_change_global){
                 this->_L = create_lua_state(use_contract, allow_change_global);
@@ -120,6 +141,22 @@ namespace uvm
                 exit_lua_sandbox(_L);
             }
 
+            void UvmStateScope::set_profiler(UvmProfiler *profiler) {
+                _L->profiler = profiler;
+            }
+
+            UvmProfiler *UvmStateScope::profiler() const {
+                return _L->profiler;
+            }
+
+            void UvmStateScope::set_gas_ledger(GasLedger *gas_ledger) {
+                _L->gas_ledger = gas_ledger;
+            }
+
+            GasLedger *UvmStateScope::gas_ledger() const {
+                return _L->gas_ledger;
+            }
+
             bool UvmStateScope::commit_storage_changes()
             {
                 return uvm::lua::lib::commit_storage_changes(_L);
@@ -155,6 +192,10 @@ namespace uvm
             {
                 return global_uvm_chain_api->check_contract_api_instructions_over_limit(_L);
             }
+            void UvmStateScope::set_contract_api_instructions_limit(int64_t limit)
+            {
+                set_lua_state_api_instructions_limit(_L, limit);
+            }
 
             void UvmStateScope::notify_stop()
             {
@@ -51,12 +51,9 @@ static struct UvmStorageValue get_last_storage_changed_value(lua_State *L, const
 			UvmStorageTableReadList *table_read_list = get_or_init_storage_table_read_list(L);
 			if (table_read_list)
 			{
-				for (auto it = table_read_list->begin(); it != table_read_list->end(); ++it)
+				if (table_read_list->find_last(contract_id_str, key, fast_map_key, is_fast_map))
 				{
-					if (it->contract_id == contract_id_str && it->key == key && it->fast_map_key==fast_map_key && it->is_fast_map == is_fast_map)
-					{
-						return;
-					}
+					return;
 				}
 				UvmStorageChangeItem change_item;
 				change_item.contract_id = contract_id_str;
@@ -94,11 +91,9 @@ static struct UvmStorageValue get_last_storage_changed_value(lua_State *L, const
 
 		return value;
 	}
-	for (auto it = list->rbegin(); it != list->rend(); ++it)
-	{
-		if (it->contract_id == contract_id_str && it->key == key && it->fast_map_key==fast_map_key && it->is_fast_map == is_fast_map)
-			return it->after;
-	}
+	const auto* last_change = list->find_last(contract_id_str, key, fast_map_key, is_fast_map);
+	if (last_change)
+		return last_change->after;
 	auto value = global_uvm_chain_api->get_storage_value_from_uvm_by_address(L, contract_id, key, fast_map_key, is_fast_map);
 	post_when_read_table(value);
 	return value;
@@ -930,7 +925,7 @@ namespace uvm {
 		int uvmlib_get_storage_impl(lua_State *L,
 			const char *contract_id, const char *name, const char* fast_map_key, bool is_fast_map)
 		{
-			uvm::lua::lib::increment_lvm_instructions_executed_count(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT - 1);
+			uvm::lua::lib::charge_lvm_api_gas(L, CHAIN_GLUA_API_EACH_INSTRUCTIONS_COUNT, "storage", "read ", name);
 
 			const auto &code_storage_contract_id = get_contract_id_string_in_storage_operation(L);
 			/*if (code_storage_contract_id != contract_id)
@@ -1024,15 +1019,7 @@ namespace uvm {
 				auto *table_read_list = get_or_init_storage_table_read_list(L);
 				if (table_read_list)
 				{
-					bool found = false;
-					for (auto it = table_read_list->begin(); it != table_read_list->end(); ++it)
-					{
-						if (it->contract_id == std::string(contract_id) && it->key == name && it->fast_map_key== fast_map_key_str && it->is_fast_map==is_fast_map)
-						{
-							found = true;
-							break;
-						}
-					}
+					bool found = nullptr != table_read_list->find_last(contract_id, name, fast_map_key_str, is_fast_map);
 					if (!found)
 					{
 						UvmStorageChangeItem change_item;
@@ -1190,9 +1177,10 @@ namespace uvm {
 				if ((!lua_storage_is_table(before.type) || before.value.table_value->size() < 1) && after.value.table_value->size() > 0)
 				{
 					// if before table is empty and after table not empty, search type before
-					for (auto it = list->begin(); it != list->end(); ++it)
+					const auto* storage_changes = list->find_all(contract_id, name, fast_map_key_str, is_fast_map);
+					if (storage_changes)
 					{
-						if (it->contract_id == std::string(contract_id) && it->key == std::string(name) && it->fast_map_key==fast_map_key_str && it->is_fast_map==is_fast_map)
+						for (const auto& it : *storage_changes)
 						{
 							if (lua_storage_is_table(it->after.type) && it->after.value.table_value->size() > 0)
 							{
@@ -1343,3 +1331,74 @@ std::string UvmStorageChangeItem::full_key() const {
 }
 
 // end UvmStorageChangeItem
+
+// start UvmStorageChangeLog
+
+std::string UvmStorageChangeLog::index_key(const std::string& contract_id, const std::string& key,
+	const std::string& fast_map_key, bool is_fast_map) {
+	std::string result;
+	result.reserve(contract_id.size() + key.size() + fast_map_key.size() + 4);
+	result.append(contract_id);
+	result.push_back('\0');
+	result.append(key);
+	result.push_back('\0');
+	result.push_back(is_fast_map ? '1' : '0');
+	result.append(fast_map_key);
+	return result;
+}
+
+void UvmStorageChangeLog::push_back(const UvmStorageChangeItem& item) {
+	_items.push_back(item);
+	auto it = _items.end();
+	--it;
+	_index[index_key(item.contract_id, item.key, item.fast_map_key, item.is_fast_map)].push_back(it);
+}
+
+void UvmStorageChangeLog::pop_back() {
+	const auto& item = _items.back();
+	auto found = _index.find(index_key(item.contract_id, item.key, item.fast_map_key, item.is_fast_map));
+	if (found != _index.end()) {
+		found->second.pop_back();
+		if (found->second.empty())
+			_index.erase(found);
+	}
+	_items.pop_back();
+}
+
+void UvmStorageChangeLog::pop_front() {
+	const auto& item = _items.front();
+	auto found = _index.find(index_key(item.contract_id, item.key, item.fast_map_key, item.is_fast_map));
+	if (found != _index.end()) {
+		found->second.erase(found->second.begin());
+		if (found->second.empty())
+			_index.erase(found);
+	}
+	_items.pop_front();
+}
+
+void UvmStorageChangeLog::clear() {
+	_index.clear();
+	_items.clear();
+}
+
+size_t UvmStorageChangeLog::size() const {
+	return _items.size();
+}
+
+const UvmStorageChangeItem* UvmStorageChangeLog::find_last(const std::string& contract_id, const std::string& key,
+	const std::string& fast_map_key, bool is_fast_map) const {
+	auto found = _index.find(index_key(contract_id, key, fast_map_key, is_fast_map));
+	if (found == _index.end())
+		return nullptr;
+	return &(*found->second.back());
+}
+
+const std::vector<UvmStorageChangeLog::iterator>* UvmStorageChangeLog::find_all(const std::string& contract_id, const std::string& key,
+	const std::string& fast_map_key, bool is_fast_map) const {
+	auto found = _index.find(index_key(contract_id, key, fast_map_key, is_fast_map));
+	if (found == _index.end())
+		return nullptr;
+	return &found->second;
+}
+
+// end UvmStorageChangeLog
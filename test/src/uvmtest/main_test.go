@@ -355,6 +355,47 @@ func TestInvalidUpvalue(t *testing.T) {
 	assert.True(t, strings.Contains(err, `upvalue error`))
 }
 
+func TestVerifiedBytecode(t *testing.T) {
+	fmt.Println("TestVerifiedBytecode")
+	_, compileErr := execCommand(uvmCompilerPath, "../../tests_lua/test_verified_bytecode.lua")
+	assert.Equal(t, compileErr, "")
+	out, err := execCommand(uvmSinglePath, "../../tests_lua/test_verified_bytecode.lua.out")
+	fmt.Println(out)
+	assert.Equal(t, err, "")
+	assert.True(t, strings.Contains(out, `a1=	16`))
+	assert.True(t, strings.Contains(out, `a2=	nil	nil	nil	3`))
+	assert.True(t, strings.Contains(out, `a3=	55`))
+	assert.True(t, strings.Contains(out, `a4=	a1b2`))
+	assert.True(t, strings.Contains(out, `test_verified_bytecode end`))
+	// every function of compiled code passes the verifier
+	out, _ = execCommand(uvmSinglePath, "-V", "../../tests_lua/test_verified_bytecode.lua.out")
+	verified, total := verifiedFunctionsInOutput(out)
+	assert.True(t, total > 1)
+	assert.Equal(t, total, verified)
+
+	// bytecode failing verification is still loaded and keeps the runtime checks
+	_, assErr := execCommand(uvmAssPath, "../../tests_lua/test_invalid_upvalue.uvms")
+	fmt.Println(assErr)
+	out, invalidErr := execCommand(uvmSinglePath, "-V", "../../tests_lua/test_invalid_upvalue.out")
+	verified, total = verifiedFunctionsInOutput(out)
+	assert.Equal(t, 3, total)
+	assert.True(t, verified < total)
+	assert.True(t, strings.Contains(invalidErr, `upvalue error`))
+}
+
+// verified and total functions printed by uvm_single -V, -1 if not found
+func verifiedFunctionsInOutput(out string) (int, int) {
+	var verified, total int
+	idx := strings.Index(out, "verified functions: ")
+	if idx < 0 {
+		return -1, -1
+	}
+	if _, err := fmt.Sscanf(out[idx:], "verified functions: %d of %d", &verified, &total); err != nil {
+		return -1, -1
+	}
+	return verified, total
+}
+
 func TestArrayOp(t *testing.T) {
 	// TODO
 }
@@ -534,6 +575,102 @@ func TestCryptoPrimitivesApis(t *testing.T) {
 	assert.True(t, strings.Contains(out, `a123=	a123`))
 }
 
+func TestHexCodec(t *testing.T) {
+	fmt.Println("TestHexCodec")
+	_, compilerErr := execCommand(uvmCompilerPath, "../../tests_lua/test_hex_codec.lua")
+	assert.Equal(t, compilerErr, "")
+	out, err := execCommand(uvmSinglePath, "../../tests_lua/test_hex_codec.lua.out")
+	fmt.Println(out)
+	assert.Equal(t, err, "")
+	assert.True(t, strings.Contains(out, "hex round trip ok: \ttrue"))
+	assert.True(t, strings.Contains(out, "mixed case ok: \ttrue"))
+	assert.True(t, strings.Contains(out, "encoded: \t7668656C6C6F20776F726C642031323334353637383930"))
+	assert.True(t, strings.Contains(out, "lower case decoded: \thello world 1234567890"))
+
+	_, compilerErr = execCommand(uvmCompilerPath, "../../tests_lua/test_hex_codec_invalid.lua")
+	assert.Equal(t, compilerErr, "")
+	out, err = execCommand(uvmSinglePath, "../../tests_lua/test_hex_codec_invalid.lua.out")
+	assert.True(t, strings.Contains(err, "invalid hex string"))
+	assert.False(t, strings.Contains(out, "decoded invalid hex"))
+}
+
+func TestTableSort(t *testing.T) {
+	fmt.Println("TestTableSort")
+	_, compilerErr := execCommand(uvmCompilerPath, "../../tests_lua/test_table_sort.lua")
+	assert.Equal(t, compilerErr, "")
+	out, err := execCommand(uvmSinglePath, "../../tests_lua/test_table_sort.lua.out")
+	fmt.Println(out)
+	assert.Equal(t, err, "")
+	assert.True(t, strings.Contains(out, "small int sort ok: \ttrue"))
+	assert.True(t, strings.Contains(out, "int sort ok: \ttrue"))
+	assert.True(t, strings.Contains(out, "adversarial sort ok: \ttrue"))
+	assert.True(t, strings.Contains(out, "string sort ok: \ttrue"))
+	assert.True(t, strings.Contains(out, "sorted names: \tapple,banana,fig,pear"))
+	assert.True(t, strings.Contains(out, "sorted mixed: \t-0.5,1.5,2,2.5,3,10"))
+	assert.True(t, strings.Contains(out, "sorted with metatable: \t1,2,3,4"))
+	assert.True(t, strings.Contains(out, "sorted descending: \t9,7,4,1"))
+	assert.True(t, strings.Contains(out, "test table sort end"))
+}
+
+func TestInlineCacheInvalidation(t *testing.T) {
+	fmt.Println("TestInlineCacheInvalidation")
+	_, compilerErr := execCommand(uvmCompilerPath, "../../tests_lua/test_inline_cache.lua")
+	assert.Equal(t, compilerErr, "")
+	out, err := execCommand(uvmSinglePath, "../../tests_lua/test_inline_cache.lua.out")
+	fmt.Println(out)
+	assert.Equal(t, err, "")
+	assert.True(t, strings.Contains(out, "key added ok: \ttrue"))
+	assert.True(t, strings.Contains(out, "key removed ok: \ttrue"))
+	assert.True(t, strings.Contains(out, "other tables ok: \ttrue"))
+	assert.True(t, strings.Contains(out, "metatable ok: \ttrue"))
+	assert.True(t, strings.Contains(out, "rehash ok: \ttrue"))
+	assert.True(t, strings.Contains(out, "globals ok: \ttrue"))
+	assert.True(t, strings.Contains(out, "test inline cache end"))
+}
+
+// gas used printed by uvm_single -g, -1 if not found
+func gasUsedInOutput(out string) int {
+	prefix := "gas used: "
+	idx := strings.LastIndex(out, prefix)
+	if idx < 0 {
+		return -1
+	}
+	line := out[idx+len(prefix):]
+	if end := strings.Index(line, "\n"); end >= 0 {
+		line = line[:end]
+	}
+	gas, err := strconv.Atoi(strings.TrimSpace(line))
+	if err != nil {
+		return -1
+	}
+	return gas
+}
+
+func TestGasBlocksMatchPerInstructionGas(t *testing.T) {
+	fmt.Println("TestGasBlocksMatchPerInstructionGas")
+	scripts := []string{"test_math.lua", "test_json.lua", "test_string_operators.lua", "test_for_loop_goto.lua",
+		"test_fastmap.lua", "test_types.lua", "test_time.lua", "test_cbor.lua", "test_crypto_primitives.lua",
+		"test_upval.lua", "test_error.lua", "test_gmatch.lua"}
+	for _, script := range scripts {
+		execCommand(uvmCompilerPath, "../../tests_lua/"+script)
+		bytecodePath := "../../tests_lua/" + script + ".out"
+		if _, err := os.Stat(bytecodePath); err != nil {
+			continue // not compilable, eg. test_upval.lua
+		}
+		blockOut, _ := execCommand(uvmSinglePath, "-g", bytecodePath)
+		instructionOut, _ := execCommand(uvmSinglePath, "-g", "-G", bytecodePath)
+		blockGas := gasUsedInOutput(blockOut)
+		fmt.Printf("%s gas used: %d\n", script, blockGas)
+		assert.True(t, blockGas > 0, script)
+		assert.Equal(t, gasUsedInOutput(instructionOut), blockGas, script)
+	}
+	blockOut, _ := execCommand(uvmSinglePath, "-g", "-k", "../../result.out", "sayHi", "China")
+	instructionOut, _ := execCommand(uvmSinglePath, "-g", "-G", "-k", "../../result.out", "sayHi", "China")
+	assert.True(t, strings.Contains(blockOut, "result: HelloChina"))
+	assert.True(t, gasUsedInOutput(blockOut) > 0)
+	assert.Equal(t, gasUsedInOutput(instructionOut), gasUsedInOutput(blockOut))
+}
+
 func kill(cmd *exec.Cmd) error {
 	return cmd.Process.Kill()
 	// kill := exec.Command("TASKKILL", "/T", "/F", "/PID", strconv.Itoa(cmd.Process.Pid)) // TODO: when in linux
@@ -1904,6 +2041,599 @@ func TestCallContractManyTimes(t *testing.T) {
 	println("TestCallContractManyTimes")
 }
 
+func TestProfileFusedLookups(t *testing.T) {
+	fmt.Println("TestProfileFusedLookups")
+	cmd := execCommandBackground(simpleChainPath)
+	assert.True(t, cmd != nil)
+	fmt.Printf("simplechain pid: %d\n", cmd.Process.Pid)
+	defer func() {
+		kill(cmd)
+	}()
+	time.Sleep(1 * time.Second)
+	var res *simplejson.Json
+	var err error
+	caller1 := "SPLtest1"
+
+	_, compileErr := execCommand(uvmCompilerPath, "-g", "../../test_contracts/test_fused_lookup.lua")
+	assert.Equal(t, compileErr, "")
+	res, err = simpleChainRPC("create_contract_from_file", caller1, testContractPath("test_fused_lookup.lua.gpc"), 50000, 10)
+	assert.True(t, err == nil)
+	contract1Addr := res.Get("contract_address").MustString()
+	simpleChainRPC("generate_block")
+
+	res, err = simpleChainRPC("profile_invoke_contract", caller1, contract1Addr, "lookup", []string{"abc"}, 0, 0)
+	assert.True(t, err == nil)
+	assert.Equal(t, "400", res.Get("api_result").MustString())
+	profile := res.Get("profile")
+	// fused GETTABUP/GETTABLE -> GETTABLE pairs must still be counted one by one
+	opcodes := profile.Get("opcodes").MustMap()
+	opcodesTotal := 0
+	for _, count := range opcodes {
+		n, _ := count.(json.Number).Int64()
+		opcodesTotal += int(n)
+	}
+	assert.Equal(t, profile.Get("instructions").MustInt(), opcodesTotal)
+	assert.True(t, profile.Get("opcodes").Get("GETTABLE").MustInt() >= 400)
+	assert.True(t, profile.Get("opcodes").Get("GETTABUP").MustInt() >= 100)
+}
+
+func TestTableArrayMigration(t *testing.T) {
+	fmt.Println("TestTableArrayMigration")
+	cmd := execCommandBackground(simpleChainPath)
+	assert.True(t, cmd != nil)
+	fmt.Printf("simplechain pid: %d\n", cmd.Process.Pid)
+	defer func() {
+		kill(cmd)
+	}()
+	time.Sleep(1 * time.Second)
+	var res *simplejson.Json
+	var err error
+	caller1 := "SPLtest1"
+
+	_, compileErr := execCommand(uvmCompilerPath, "-g", "../../test_contracts/test_table_array.lua")
+	assert.Equal(t, compileErr, "")
+	res, err = simpleChainRPC("create_contract_from_file", caller1, testContractPath("test_table_array.lua.gpc"), 50000, 10)
+	assert.True(t, err == nil)
+	contract1Addr := res.Get("contract_address").MustString()
+	simpleChainRPC("generate_block")
+
+	// after the TABLE_ARRAY_MIGRATION fork the moved keys come right after the array part
+	res, err = simpleChainRPC("invoke_contract_offline", caller1, contract1Addr, "fill", []string{" "}, 0, 0)
+	assert.True(t, err == nil)
+	assert.Equal(t, "5:1=a,2=b,3=c,4=d,5=e,x=x,;2:1=a,2=b,true=y,", res.Get("api_result").MustString())
+}
+
+func TestStackReuse(t *testing.T) {
+	fmt.Println("TestStackReuse")
+	cmd := execCommandBackground(simpleChainPath)
+	assert.True(t, cmd != nil)
+	fmt.Printf("simplechain pid: %d\n", cmd.Process.Pid)
+	defer func() {
+		kill(cmd)
+	}()
+	time.Sleep(1 * time.Second)
+	var res *simplejson.Json
+	var err error
+	caller1 := "SPLtest1"
+
+	_, compileErr := execCommand(uvmCompilerPath, "-g", "../../test_contracts/test_stack_reuse.lua")
+	assert.Equal(t, compileErr, "")
+	res, err = simpleChainRPC("create_contract_from_file", caller1, testContractPath("test_stack_reuse.lua.gpc"), 50000, 10)
+	assert.True(t, err == nil)
+	contract1Addr := res.Get("contract_address").MustString()
+	res, err = simpleChainRPC("create_contract_from_file", caller1, testContractPath("test_stack_reuse.lua.gpc"), 50000, 10)
+	assert.True(t, err == nil)
+	contract2Addr := res.Get("contract_address").MustString()
+	simpleChainRPC("generate_block")
+
+	// deep recursion, an error deep in a callee and a stack overflow, both caught by send_message,
+	// then deeper recursion on the stack and CallInfo list reused after them
+	res, err = simpleChainRPC("invoke_contract_offline", caller1, contract1Addr, "run", []string{contract2Addr}, 0, 0)
+	assert.True(t, err == nil)
+	assert.True(t, res.Get("exec_succeed").MustBool())
+	assert.Equal(t, "259018000,36000,1,1,0,2001000", res.Get("api_result").MustString())
+
+	// the other way round
+	res, err = simpleChainRPC("invoke_contract_offline", caller1, contract2Addr, "run", []string{contract1Addr}, 0, 0)
+	assert.True(t, err == nil)
+	assert.Equal(t, "259018000,36000,1,1,0,2001000", res.Get("api_result").MustString())
+}
+
+func TestStorageChangeLog(t *testing.T) {
+	fmt.Println("TestStorageChangeLog")
+	cmd := execCommandBackground(simpleChainPath)
+	assert.True(t, cmd != nil)
+	fmt.Printf("simplechain pid: %d\n", cmd.Process.Pid)
+	defer func() {
+		kill(cmd)
+	}()
+	time.Sleep(1 * time.Second)
+	var res *simplejson.Json
+	var err error
+	caller1 := "SPLtest1"
+
+	simpleChainRPC("mint", caller1, 0, 100000)
+	simpleChainRPC("generate_block")
+	_, compileErr := execCommand(uvmCompilerPath, "-g", "../../test_contracts/test_storage_log.lua")
+	assert.Equal(t, compileErr, "")
+	res, err = simpleChainRPC("create_contract_from_file", caller1, testContractPath("test_storage_log.lua.gpc"), 50000, 10)
+	assert.True(t, err == nil)
+	contract1Addr := res.Get("contract_address").MustString()
+	simpleChainRPC("generate_block")
+
+	// reads in the same call see the last of the repeated writes of each key
+	res, err = simpleChainRPC("invoke_contract", caller1, contract1Addr, "fill", []string{" "}, 0, 0, 50000, 10)
+	assert.True(t, err == nil)
+	assert.True(t, res.Get("exec_succeed").MustBool())
+	simpleChainRPC("generate_block")
+	res, err = simpleChainRPC("invoke_contract_offline", caller1, contract1Addr, "query", []string{"7"}, 0, 0)
+	assert.True(t, err == nil)
+	assert.Equal(t, "8775,157,97", res.Get("api_result").MustString())
+	res, err = simpleChainRPC("invoke_contract_offline", caller1, contract1Addr, "query", []string{"0"}, 0, 0)
+	assert.True(t, err == nil)
+	assert.Equal(t, "8775,200,100", res.Get("api_result").MustString())
+
+	// the committed values are read before the log has changes of the key
+	res, err = simpleChainRPC("invoke_contract", caller1, contract1Addr, "increase", []string{"7"}, 0, 0, 50000, 10)
+	assert.True(t, err == nil)
+	assert.True(t, res.Get("exec_succeed").MustBool())
+	simpleChainRPC("generate_block")
+	res, err = simpleChainRPC("invoke_contract_offline", caller1, contract1Addr, "query", []string{"7"}, 0, 0)
+	assert.True(t, err == nil)
+	assert.Equal(t, "8775,159,98", res.Get("api_result").MustString())
+	res, err = simpleChainRPC("invoke_contract_offline", caller1, contract1Addr, "query", []string{"8"}, 0, 0)
+	assert.True(t, err == nil)
+	assert.Equal(t, "8775,158,98", res.Get("api_result").MustString())
+}
+
+func TestGasLedgerTotal(t *testing.T) {
+	fmt.Println("TestGasLedgerTotal")
+	cmd := execCommandBackground(simpleChainPath)
+	assert.True(t, cmd != nil)
+	fmt.Printf("simplechain pid: %d\n", cmd.Process.Pid)
+	defer func() {
+		kill(cmd)
+	}()
+	time.Sleep(1 * time.Second)
+	var res *simplejson.Json
+	var err error
+	caller1 := "SPLtest1"
+
+	simpleChainRPC("mint", caller1, 0, 100000)
+	simpleChainRPC("generate_block")
+	_, compileErr := execCommand(uvmCompilerPath, "-g", "../../test_contracts/test_storage_log.lua")
+	assert.Equal(t, compileErr, "")
+	res, err = simpleChainRPC("create_contract_from_file", caller1, testContractPath("test_storage_log.lua.gpc"), 50000, 10)
+	assert.True(t, err == nil)
+	contract1Addr := res.Get("contract_address").MustString()
+	simpleChainRPC("generate_block")
+
+	res, err = simpleChainRPC("invoke_contract", caller1, contract1Addr, "increase", []string{"7"}, 0, 0, 50000, 10)
+	assert.True(t, err == nil)
+	assert.True(t, res.Get("exec_succeed").MustBool())
+	txid := res.Get("txid").MustString()
+	simpleChainRPC("generate_block")
+	receipt, err := simpleChainRPC("get_tx_receipt", txid)
+	assert.True(t, err == nil)
+
+	// each api call is recorded at its whole price and the entries add up to the gas used
+	ledger := receipt.Get("gas_ledger")
+	assert.Equal(t, 100, ledger.Get("storage").Get("fast_map_get").MustInt())
+	assert.Equal(t, 200, ledger.Get("storage").Get("fast_map_set").MustInt())
+	total := 0
+	for category := range ledger.MustMap() {
+		for subcategory := range ledger.Get(category).MustMap() {
+			total += ledger.Get(category).Get(subcategory).MustInt()
+		}
+	}
+	assert.Equal(t, receipt.Get("gas_used").MustInt(), total)
+}
+
+func TestTableSortGasFork(t *testing.T) {
+	fmt.Println("TestTableSortGasFork")
+	_, compileErr := execCommand(uvmCompilerPath, "-g", "../../test_contracts/test_table_sort.lua")
+	assert.Equal(t, compileErr, "")
+
+	// uvm_single runs at block 0, before the TABLE_SORT_GAS fork, so the comparisons are free
+	sortedOut, _ := execCommand(uvmSinglePath, "-g", "-k", "../../test_contracts/test_table_sort.lua.out", "sort", "1")
+	shuffledOut, _ := execCommand(uvmSinglePath, "-g", "-k", "../../test_contracts/test_table_sort.lua.out", "sort", "97")
+	assert.True(t, strings.Contains(sortedOut, "result: 1,200"))
+	assert.True(t, strings.Contains(shuffledOut, "result: 1,210"))
+	assert.True(t, gasUsedInOutput(sortedOut) > 0)
+	assert.Equal(t, gasUsedInOutput(sortedOut), gasUsedInOutput(shuffledOut))
+
+	cmd := execCommandBackground(simpleChainPath)
+	assert.True(t, cmd != nil)
+	fmt.Printf("simplechain pid: %d\n", cmd.Process.Pid)
+	defer func() {
+		kill(cmd)
+	}()
+	time.Sleep(1 * time.Second)
+	caller1 := "SPLtest1"
+
+	simpleChainRPC("mint", caller1, 0, 100000)
+	simpleChainRPC("generate_block")
+	res, err := simpleChainRPC("create_contract_from_file", caller1, testContractPath("test_table_sort.lua.gpc"), 50000, 10)
+	assert.True(t, err == nil)
+	contractAddr := res.Get("contract_address").MustString()
+	simpleChainRPC("generate_block")
+
+	// after the fork each 8 comparisons cost one instruction: 1029 comparisons for the sorted
+	// integers and 1825 for the shuffled ones
+	sorted, err := invokeContractOffline(caller1, contractAddr, "sort", "1")
+	assert.True(t, err == nil)
+	assert.Equal(t, "1,200", sorted.Get("api_result").MustString())
+	assert.Equal(t, 129, sorted.Get("gas_ledger").Get("table").Get("table.sort").MustInt())
+	shuffled, err := invokeContractOffline(caller1, contractAddr, "sort", "97")
+	assert.True(t, err == nil)
+	assert.Equal(t, "1,210", shuffled.Get("api_result").MustString())
+	assert.Equal(t, 229, shuffled.Get("gas_ledger").Get("table").Get("table.sort").MustInt())
+	assert.Equal(t, 228-128, shuffled.Get("gas_used").MustInt()-sorted.Get("gas_used").MustInt())
+}
+
+func TestDebuggerBreakpoints(t *testing.T) {
+	fmt.Println("TestDebuggerBreakpoints")
+	cmd := execCommandBackground(simpleChainPath)
+	assert.True(t, cmd != nil)
+	fmt.Printf("simplechain pid: %d\n", cmd.Process.Pid)
+	defer func() {
+		kill(cmd)
+	}()
+	time.Sleep(1 * time.Second)
+	var res *simplejson.Json
+	var err error
+	caller1 := "SPLtest1"
+
+	simpleChainRPC("mint", caller1, 0, 100000)
+	simpleChainRPC("generate_block")
+	_, compileErr := execCommand(uvmCompilerPath, "-g", "../../test_contracts/test_breakpoints.lua")
+	assert.Equal(t, compileErr, "")
+	res, err = simpleChainRPC("create_contract_from_file", caller1, testContractPath("test_breakpoints.lua.gpc"), 50000, 10)
+	assert.True(t, err == nil)
+	contract1Addr := res.Get("contract_address").MustString()
+	simpleChainRPC("generate_block")
+
+	// a breakpoint of another contract on a line of run doesn't stop it
+	simpleChainRPC("set_breakpoint", contract1Addr, 13)
+	simpleChainRPC("set_breakpoint", "SPLother_contract", 14)
+	res, err = simpleChainRPC("get_breakpoints_in_last_debugger_state")
+	assert.True(t, err == nil)
+	assert.Equal(t, 1, len(res.Get(contract1Addr).MustArray()))
+	assert.Equal(t, 13, res.Get(contract1Addr).GetIndex(0).MustInt())
+
+	simpleChainRPC("debugger_invoke_contract", caller1, contract1Addr, "run", []string{" "}, 0, 0, 50000, 10)
+	res, err = simpleChainRPC("view_debug_info")
+	assert.True(t, err == nil)
+	assert.Equal(t, 13, res.Get("line").MustInt())
+	assert.Equal(t, contract1Addr, res.Get("contractid").MustString())
+
+	// a breakpoint added while stopped is seen by the running proto
+	simpleChainRPC("set_breakpoint", contract1Addr, 15)
+	simpleChainRPC("debugger_go_resume")
+	res, err = simpleChainRPC("view_debug_info")
+	assert.True(t, err == nil)
+	assert.Equal(t, 15, res.Get("line").MustInt())
+
+	// without breakpoints the call runs to its end
+	simpleChainRPC("clear_breakpoints_in_last_debugger_state")
+	res, err = simpleChainRPC("get_breakpoints_in_last_debugger_state")
+	assert.True(t, err == nil)
+	assert.Equal(t, 0, len(res.MustMap()))
+	res, err = simpleChainRPC("debugger_invoke_contract", caller1, contract1Addr, "run", []string{" "}, 0, 0, 50000, 10)
+	assert.True(t, err == nil)
+	assert.True(t, res.Get("exec_succeed").MustBool())
+	assert.Equal(t, "6", res.Get("api_result").MustString())
+}
+
+func TestSimpleChainStateDbReopen(t *testing.T) {
+	fmt.Println("TestSimpleChainStateDbReopen")
+	dataDir, err := ioutil.TempDir("", "simplechain_data")
+	assert.True(t, err == nil)
+	defer os.RemoveAll(dataDir)
+	cmd := execCommandBackground(simpleChainPath, "--data-dir="+dataDir)
+	assert.True(t, cmd != nil)
+	fmt.Printf("simplechain pid: %d\n", cmd.Process.Pid)
+	time.Sleep(1 * time.Second)
+	var res *simplejson.Json
+	caller1 := "SPLtest1"
+
+	simpleChainRPC("mint", caller1, 0, 100000)
+	simpleChainRPC("generate_block")
+	_, compileErr := execCommand(uvmCompilerPath, "-g", "../../test_contracts/test_simple_storage_change.lua")
+	assert.Equal(t, compileErr, "")
+	res, err = simpleChainRPC("create_contract_from_file", caller1, testContractPath("test_simple_storage_change.lua.gpc"), 50000, 10)
+	assert.True(t, err == nil)
+	contract1Addr := res.Get("contract_address").MustString()
+	createTxid := res.Get("txid").MustString()
+	simpleChainRPC("generate_block")
+	simpleChainRPC("invoke_contract", caller1, contract1Addr, "update", []string{" "}, 0, 0, 50000, 10)
+	simpleChainRPC("generate_block")
+	block2Before, err := simpleChainRPC("get_block_by_height", 2)
+	assert.True(t, err == nil)
+	stateBefore, err := simpleChainRPC("get_chain_state")
+	assert.True(t, err == nil)
+	stateBeforeBytes, _ := stateBefore.MarshalJSON()
+	kill(cmd)
+	cmd.Wait()
+
+	// the restarted chain goes on from the state committed in the data dir
+	cmd = execCommandBackground(simpleChainPath, "--data-dir="+dataDir)
+	assert.True(t, cmd != nil)
+	defer func() {
+		kill(cmd)
+	}()
+	time.Sleep(1 * time.Second)
+	stateAfter, err := simpleChainRPC("get_chain_state")
+	assert.True(t, err == nil)
+	stateAfterBytes, _ := stateAfter.MarshalJSON()
+	assert.Equal(t, string(stateBeforeBytes), string(stateAfterBytes))
+	assert.Equal(t, 4, stateAfter.Get("head_block_num").MustInt())
+	res, err = simpleChainRPC("get_contract_info", contract1Addr)
+	assert.True(t, err == nil)
+	assert.Equal(t, contract1Addr, res.Get("contract_address").MustString())
+	res, err = simpleChainRPC("invoke_contract_offline", caller1, contract1Addr, "query", []string{" "}, 0, 0)
+	assert.True(t, err == nil)
+	assert.Equal(t, "1000", res.Get("api_result").MustString())
+	// blocks, txs and receipts before the head block are read back from the data dir
+	block2After, err := simpleChainRPC("get_block_by_height", 2)
+	assert.True(t, err == nil)
+	block2BeforeBytes, _ := block2Before.MarshalJSON()
+	block2AfterBytes, _ := block2After.MarshalJSON()
+	assert.Equal(t, string(block2BeforeBytes), string(block2AfterBytes))
+	assert.Equal(t, 1, len(block2After.Get("txs").MustArray()))
+	res, err = simpleChainRPC("get_tx", createTxid)
+	assert.True(t, err == nil)
+	assert.Equal(t, createTxid, res.Get("hash").MustString())
+	res, err = simpleChainRPC("get_tx_receipt", createTxid)
+	assert.True(t, err == nil)
+	assert.Equal(t, createTxid, res.Get("tx_id").MustString())
+	assert.True(t, res.Get("exec_succeed").MustBool())
+	simpleChainRPC("generate_block")
+	res, err = simpleChainRPC("get_chain_state")
+	assert.True(t, err == nil)
+	assert.Equal(t, 5, res.Get("head_block_num").MustInt())
+}
+
+func TestSimpleChainRecordReplay(t *testing.T) {
+	fmt.Println("TestSimpleChainRecordReplay")
+	dataDir, err := ioutil.TempDir("", "simplechain_data")
+	assert.True(t, err == nil)
+	defer os.RemoveAll(dataDir)
+	recordPath := filepath.Join(dataDir, "blocks.rec")
+	cmd := execCommandBackground(simpleChainPath, "--data-dir="+filepath.Join(dataDir, "chain"), "--record="+recordPath)
+	assert.True(t, cmd != nil)
+	fmt.Printf("simplechain pid: %d\n", cmd.Process.Pid)
+	time.Sleep(1 * time.Second)
+	var res *simplejson.Json
+	caller1 := "SPLtest1"
+
+	simpleChainRPC("mint", caller1, 0, 100000)
+	simpleChainRPC("generate_block")
+	_, compileErr := execCommand(uvmCompilerPath, "-g", "../../test_contracts/test_simple_storage_change.lua")
+	assert.Equal(t, compileErr, "")
+	res, err = simpleChainRPC("create_contract_from_file", caller1, testContractPath("test_simple_storage_change.lua.gpc"), 50000, 10)
+	assert.True(t, err == nil)
+	contract1Addr := res.Get("contract_address").MustString()
+	simpleChainRPC("generate_block")
+	simpleChainRPC("invoke_contract", caller1, contract1Addr, "update", []string{" "}, 0, 0, 50000, 10)
+	simpleChainRPC("transfer", caller1, "SPLtest2", 0, 100)
+	simpleChainRPC("generate_block")
+	kill(cmd)
+	cmd.Wait()
+
+	replayReport := func(out string) *simplejson.Json {
+		report, err := simplejson.NewJson([]byte(out[strings.Index(out, "{\n"):]))
+		assert.True(t, err == nil, out)
+		return report
+	}
+
+	// a fresh chain replays the same blocks and states
+	out, errOut := execCommand(simpleChainPath, "--replay="+recordPath)
+	assert.False(t, strings.Contains(errOut, "differs"), errOut)
+	report := replayReport(out)
+	assert.Equal(t, 3, report.Get("blocks_count").MustInt())
+	assert.Equal(t, "", report.Get("mismatch").MustString())
+	assert.Equal(t, 0, report.Get("failed_txs_count").MustInt())
+	stateHash := report.Get("state_hash").MustString()
+	assert.True(t, stateHash != "")
+	_, errOut = execCommand(simpleChainPath, "--replay="+recordPath, "--expect-state-hash="+stateHash)
+	assert.False(t, strings.Contains(errOut, "mismatch"), errOut)
+
+	// another expected state hash fails
+	_, errOut = execCommand(simpleChainPath, "--replay="+recordPath, "--expect-state-hash=00")
+	assert.True(t, strings.Contains(errOut, "state hash mismatch"), errOut)
+
+	// replaying on top of the recorded chain produces other blocks, the first one stops the replay
+	out, errOut = execCommand(simpleChainPath, "--data-dir="+filepath.Join(dataDir, "chain"), "--replay="+recordPath)
+	assert.True(t, strings.Contains(errOut, "replayed chain differs from the recorded one: block #1 recorded with hash"), errOut)
+	report = replayReport(out)
+	assert.Equal(t, 1, report.Get("blocks_count").MustInt())
+}
+
+func TestSimpleChainUndoBlock(t *testing.T) {
+	fmt.Println("TestSimpleChainUndoBlock")
+	cmd := execCommandBackground(simpleChainPath)
+	assert.True(t, cmd != nil)
+	fmt.Printf("simplechain pid: %d\n", cmd.Process.Pid)
+	defer func() {
+		kill(cmd)
+	}()
+	time.Sleep(1 * time.Second)
+	caller1 := "SPLtest1"
+
+	simpleChainRPC("mint", caller1, 0, 100000)
+	simpleChainRPC("generate_block")
+	balance, _ := getAccountBalanceOfAssetID(caller1, 0)
+	assert.Equal(t, 100000, balance)
+	_, err := simpleChainRPC("undo_block")
+	assert.True(t, err == nil)
+	balance, _ = getAccountBalanceOfAssetID(caller1, 0)
+	assert.Equal(t, 0, balance)
+	// the txs of the undone block are back in mempool
+	simpleChainRPC("generate_block")
+	balance, _ = getAccountBalanceOfAssetID(caller1, 0)
+	assert.Equal(t, 100000, balance)
+
+	// only the last 100 blocks keep their undo
+	for i := 0; i < 101; i++ {
+		simpleChainRPC("generate_block")
+	}
+	for i := 0; i < 100; i++ {
+		_, err = simpleChainRPC("undo_block")
+		assert.True(t, err == nil)
+	}
+	// the undo of block #2 was dropped, so the head stays there
+	simpleChainRPC("undo_block")
+	res, err := simpleChainRPC("get_chain_state")
+	assert.True(t, err == nil)
+	assert.Equal(t, 3, res.Get("head_block_num").MustInt())
+	balance, _ = getAccountBalanceOfAssetID(caller1, 0)
+	assert.Equal(t, 100000, balance)
+}
+
+func simpleChainRPCBatch(items []interface{}) ([]byte, error) {
+	reqBytes, err := json.Marshal(items)
+	if err != nil {
+		return nil, err
+	}
+	httpRes, err := http.Post("http://localhost:8080/api", "application/json", bytes.NewReader(reqBytes))
+	if err != nil {
+		return nil, err
+	}
+	defer httpRes.Body.Close()
+	return ioutil.ReadAll(httpRes.Body)
+}
+
+func TestSimpleChainRPCBatch(t *testing.T) {
+	fmt.Println("TestSimpleChainRPCBatch")
+	cmd := execCommandBackground(simpleChainPath)
+	assert.True(t, cmd != nil)
+	fmt.Printf("simplechain pid: %d\n", cmd.Process.Pid)
+	defer func() {
+		kill(cmd)
+	}()
+	time.Sleep(1 * time.Second)
+	caller1 := "SPLtest1"
+
+	// read-only batch: answers keep the order and ids of the items, notifications(no id) get no answer
+	resBytes, err := simpleChainRPCBatch([]interface{}{
+		map[string]interface{}{"id": 1, "method": "get_chain_state", "params": []interface{}{}},
+		map[string]interface{}{"id": "b", "method": "no_such_method", "params": []interface{}{}},
+		map[string]interface{}{"method": "get_chain_state", "params": []interface{}{}},
+		42,
+		map[string]interface{}{"id": 5, "method": "get_account_balances", "params": []interface{}{}},
+	})
+	assert.True(t, err == nil)
+	res, err := simplejson.NewJson(resBytes)
+	assert.True(t, err == nil)
+	items := res.MustArray()
+	assert.Equal(t, 4, len(items))
+	assert.Equal(t, 1, res.GetIndex(0).Get("id").MustInt())
+	assert.Equal(t, 0, res.GetIndex(0).Get("code").MustInt())
+	assert.Equal(t, 1, res.GetIndex(0).Get("result").Get("head_block_num").MustInt())
+	assert.Equal(t, "b", res.GetIndex(1).Get("id").MustString())
+	assert.Equal(t, 100, res.GetIndex(1).Get("code").MustInt())
+	// an invalid item is answered with a null id
+	_, hasID := res.GetIndex(2).CheckGet("id")
+	assert.True(t, hasID)
+	assert.True(t, res.GetIndex(2).Get("id").Interface() == nil)
+	assert.Equal(t, 100, res.GetIndex(2).Get("code").MustInt())
+	// errors of a method are answered per item
+	assert.Equal(t, 5, res.GetIndex(3).Get("id").MustInt())
+	assert.Equal(t, 100, res.GetIndex(3).Get("code").MustInt())
+
+	// batch with writes runs in order
+	resBytes, err = simpleChainRPCBatch([]interface{}{
+		map[string]interface{}{"id": 1, "method": "mint", "params": []interface{}{caller1, 0, 100000}},
+		map[string]interface{}{"id": 2, "method": "generate_block", "params": []interface{}{}},
+		map[string]interface{}{"id": 3, "method": "get_account_balances", "params": []interface{}{caller1}},
+	})
+	assert.True(t, err == nil)
+	res, err = simplejson.NewJson(resBytes)
+	assert.True(t, err == nil)
+	assert.Equal(t, 3, len(res.MustArray()))
+	assert.Equal(t, 3, res.GetIndex(2).Get("id").MustInt())
+	assert.Equal(t, 100000, res.GetIndex(2).Get("result").GetIndex(0).GetIndex(1).MustInt())
+
+	// a batch of only notifications gets an empty body
+	resBytes, err = simpleChainRPCBatch([]interface{}{
+		map[string]interface{}{"method": "get_chain_state", "params": []interface{}{}},
+	})
+	assert.True(t, err == nil)
+	assert.Equal(t, 0, len(resBytes))
+}
+
+func isChanClosed(ch chan bool) bool {
+	select {
+	case <-ch:
+		return true
+	default:
+		return false
+	}
+}
+
+func TestSimpleChainReadsDuringWrites(t *testing.T) {
+	fmt.Println("TestSimpleChainReadsDuringWrites")
+	cmd := execCommandBackground(simpleChainPath)
+	assert.True(t, cmd != nil)
+	fmt.Printf("simplechain pid: %d\n", cmd.Process.Pid)
+	defer func() {
+		kill(cmd)
+	}()
+	time.Sleep(1 * time.Second)
+	caller1 := "SPLtest1"
+
+	simpleChainRPC("mint", caller1, 0, 100000)
+	simpleChainRPC("generate_block")
+	_, compileErr := execCommand(uvmCompilerPath, "-g", "../../test_contracts/test_long_loop.lua")
+	assert.Equal(t, compileErr, "")
+	res, err := simpleChainRPC("create_contract_from_file", caller1, testContractPath("test_long_loop.lua.gpc"), 50000, 10)
+	assert.True(t, err == nil)
+	contract1Addr := res.Get("contract_address").MustString()
+	simpleChainRPC("generate_block")
+
+	// invoke_contract runs the loop of some seconds when it is received, reads are answered meanwhile
+	writeDone := make(chan bool)
+	go func() {
+		simpleChainRPC("invoke_contract", caller1, contract1Addr, "spin", []string{"20000003"}, 0, 0, 1000000000, 1)
+		close(writeDone)
+	}()
+	time.Sleep(300 * time.Millisecond)
+	assert.False(t, isChanClosed(writeDone))
+	res, err = simpleChainRPC("get_chain_state")
+	assert.True(t, err == nil)
+	assert.Equal(t, 3, res.Get("head_block_num").MustInt())
+	res, err = simpleChainRPC("invoke_contract_offline", caller1, contract1Addr, "query", []string{" "}, 0, 0)
+	assert.True(t, err == nil)
+	assert.Equal(t, "0", res.Get("api_result").MustString())
+	assert.False(t, isChanClosed(writeDone))
+	<-writeDone
+
+	// the block applies the tx again, reads see the state before it until it is generated
+	blockDone := make(chan bool)
+	go func() {
+		simpleChainRPC("generate_block")
+		close(blockDone)
+	}()
+	time.Sleep(300 * time.Millisecond)
+	assert.False(t, isChanClosed(blockDone))
+	res, err = simpleChainRPC("get_chain_state")
+	assert.True(t, err == nil)
+	assert.Equal(t, 3, res.Get("head_block_num").MustInt())
+	res, err = simpleChainRPC("get_block_by_height", 3)
+	assert.True(t, err == nil)
+	assert.True(t, res.Interface() == nil)
+	assert.False(t, isChanClosed(blockDone))
+	<-blockDone
+
+	res, err = simpleChainRPC("get_chain_state")
+	assert.True(t, err == nil)
+	assert.Equal(t, 4, res.Get("head_block_num").MustInt())
+	res, err = simpleChainRPC("invoke_contract_offline", caller1, contract1Addr, "query", []string{" "}, 0, 0)
+	assert.True(t, err == nil)
+	assert.Equal(t, "6", res.Get("api_result").MustString())
+}
+
 func TestNativeTokenContract(t *testing.T) {
 	fmt.Println("TestNativeTokenContract")
 	cmd := execCommandBackground(simpleChainPath)
@@ -1926,6 +2656,185 @@ func TestNativeTokenContract(t *testing.T) {
 	testTokenContractInSimplechain(t, contract1Addr)
 }
 
+func TestNativeContractApiDispatch(t *testing.T) {
+	fmt.Println("TestNativeContractApiDispatch")
+	cmd := execCommandBackground(simpleChainPath)
+	assert.True(t, cmd != nil)
+	fmt.Printf("simplechain pid: %d\n", cmd.Process.Pid)
+	defer func() {
+		kill(cmd)
+	}()
+	time.Sleep(1 * time.Second)
+	var res *simplejson.Json
+	var err error
+	caller1 := "SPLtest1"
+
+	res, err = simpleChainRPC("create_native_contract", caller1, "token", 50000, 10)
+	assert.True(t, err == nil)
+	contract1Addr := res.Get("contract_address").MustString()
+	simpleChainRPC("generate_block")
+
+	res, err = invokeContractOffline(caller1, contract1Addr, "state", " ")
+	assert.True(t, err == nil)
+	assert.Equal(t, "NOT_INITED", res.Get("api_result").MustString())
+	simpleChainRPC("invoke_contract", caller1, contract1Addr, "init_token", []string{"test,TEST,100000000,10"}, 0, 0, 50000, 10)
+	simpleChainRPC("generate_block")
+
+	// every api of the sorted api table, first and last ones included, is dispatched to its own method
+	expected := map[string]string{
+		"allApprovedFromUser": "{}",
+		"balanceOf":           "100000000",
+		"precision":           "10",
+		"state":               "COMMON",
+		"supply":              "100000000",
+		"tokenName":           "test",
+		"tokenSymbol":         "TEST",
+	}
+	for api, result := range expected {
+		arg := " "
+		if api == "balanceOf" || api == "allApprovedFromUser" {
+			arg = caller1
+		}
+		res, err = invokeContractOffline(caller1, contract1Addr, api, arg)
+		assert.True(t, err == nil)
+		assert.True(t, res.Get("exec_succeed").MustBool(), api)
+		assert.Equal(t, result, res.Get("api_result").MustString(), api)
+	}
+	// names before, between and after the table entries are not found
+	for _, api := range []string{"aaa", "balanceOg", "zzz", "tokenSymbolX"} {
+		res, err = invokeContractOffline(caller1, contract1Addr, api, " ")
+		assert.True(t, err == nil)
+		assert.False(t, res.Get("exec_succeed").MustBool(), api)
+	}
+}
+
+func TestNativeTokenTransferBatch(t *testing.T) {
+	fmt.Println("TestNativeTokenTransferBatch")
+	cmd := execCommandBackground(simpleChainPath)
+	assert.True(t, cmd != nil)
+	fmt.Printf("simplechain pid: %d\n", cmd.Process.Pid)
+	defer func() {
+		kill(cmd)
+	}()
+	time.Sleep(1 * time.Second)
+	var res *simplejson.Json
+	var err error
+	caller1 := "SPLtest1"
+
+	res, err = simpleChainRPC("create_native_contract", caller1, "token", 50000, 10)
+	assert.True(t, err == nil)
+	contract1Addr := res.Get("contract_address").MustString()
+	simpleChainRPC("generate_block")
+	simpleChainRPC("invoke_contract", caller1, contract1Addr, "init_token", []string{"test,TEST,100000000,10"}, 0, 0, 50000, 10)
+	simpleChainRPC("generate_block")
+
+	// gas follows the balances read and written, not the number of transfers
+	batchGas := func(arg string) int {
+		res, err := invokeContractOffline(caller1, contract1Addr, "transferBatch", arg)
+		assert.True(t, err == nil)
+		assert.True(t, res.Get("exec_succeed").MustBool(), arg)
+		return res.Get("gas_used").MustInt()
+	}
+	twoUsersGas := batchGas("SPLtest2,10,SPLtest3,20")
+	oneUserGas := batchGas("SPLtest2,10,SPLtest2,20")
+	manyTransfersGas := batchGas("SPLtest2,1,SPLtest2,2,SPLtest2,3,SPLtest2,4")
+	selfGas := batchGas(caller1 + ",10")
+	assert.Equal(t, 60, twoUsersGas-oneUserGas)
+	assert.Equal(t, oneUserGas, manyTransfersGas)
+	assert.Equal(t, 110, oneUserGas-selfGas)
+
+	res, err = invokeContractOffline(caller1, contract1Addr, "transferBatch", "SPLtest2,100000001")
+	assert.True(t, err == nil)
+	assert.False(t, res.Get("exec_succeed").MustBool())
+
+	res, err = simpleChainRPC("invoke_contract", caller1, contract1Addr, "transferBatch", []string{"SPLtest2,10,SPLtest3,20,SPLtest2,5"}, 0, 0, 50000, 10)
+	assert.True(t, err == nil)
+	txid := res.Get("txid").MustString()
+	simpleChainRPC("generate_block")
+
+	// one event for the whole batch
+	events, err := getTxReceiptEvents(txid)
+	assert.True(t, err == nil)
+	assert.Equal(t, 1, len(events))
+	assert.Equal(t, "TransferBatch", events[0].EventName)
+	eventArg, err := simplejson.NewJson([]byte(events[0].EventArg))
+	assert.True(t, err == nil)
+	assert.Equal(t, caller1, eventArg.Get("from").MustString())
+	transfers := eventArg.Get("transfers")
+	assert.Equal(t, 3, len(transfers.MustArray()))
+	assert.Equal(t, "SPLtest3", transfers.GetIndex(1).Get("to").MustString())
+	assert.Equal(t, 20, transfers.GetIndex(1).Get("amount").MustInt())
+
+	res, err = invokeContractOffline(caller1, contract1Addr, "balancesOf", caller1+",SPLtest2,SPLtest3")
+	assert.True(t, err == nil)
+	balances, err := simplejson.NewJson([]byte(res.Get("api_result").MustString()))
+	assert.True(t, err == nil)
+	assert.Equal(t, 99999965, balances.Get(caller1).MustInt())
+	assert.Equal(t, 15, balances.Get("SPLtest2").MustInt())
+	assert.Equal(t, 20, balances.Get("SPLtest3").MustInt())
+}
+
+func TestNativeContractTypedArgs(t *testing.T) {
+	fmt.Println("TestNativeContractTypedArgs")
+	cmd := execCommandBackground(simpleChainPath)
+	assert.True(t, cmd != nil)
+	fmt.Printf("simplechain pid: %d\n", cmd.Process.Pid)
+	defer func() {
+		kill(cmd)
+	}()
+	time.Sleep(1 * time.Second)
+	var res *simplejson.Json
+	var err error
+	caller1 := "SPLtest1"
+
+	res, err = simpleChainRPC("create_native_contract", caller1, "token", 50000, 10)
+	assert.True(t, err == nil)
+	contract1Addr := res.Get("contract_address").MustString()
+	simpleChainRPC("generate_block")
+	simpleChainRPC("invoke_contract", caller1, contract1Addr, "init_token", []string{"test,TEST,100000000,10"}, 0, 0, 50000, 10)
+	simpleChainRPC("generate_block")
+
+	// several args are decoded one by one, an integer arg is read as a number
+	res, err = simpleChainRPC("invoke_contract", caller1, contract1Addr, "transfer", []interface{}{"SPLtest2", 30}, 0, 0, 50000, 10)
+	assert.True(t, err == nil)
+	txid := res.Get("txid").MustString()
+	simpleChainRPC("generate_block")
+	events, err := getTxReceiptEvents(txid)
+	assert.True(t, err == nil)
+	assert.Equal(t, 1, len(events))
+	eventArg, err := simplejson.NewJson([]byte(events[0].EventArg))
+	assert.True(t, err == nil)
+	assert.Equal(t, "SPLtest2", eventArg.Get("to").MustString())
+	assert.Equal(t, 30, eventArg.Get("amount").MustInt())
+
+	// string args are not split at commas any more
+	res, err = simpleChainRPC("invoke_contract_offline", caller1, contract1Addr, "balancesOf", []interface{}{caller1, "SPLtest2"}, 0, 0)
+	assert.True(t, err == nil)
+	assert.True(t, res.Get("exec_succeed").MustBool())
+	balances, err := simplejson.NewJson([]byte(res.Get("api_result").MustString()))
+	assert.True(t, err == nil)
+	assert.Equal(t, 99999970, balances.Get(caller1).MustInt())
+	assert.Equal(t, 30, balances.Get("SPLtest2").MustInt())
+	res, err = simpleChainRPC("invoke_contract_offline", caller1, contract1Addr, "balancesOf", []interface{}{"SPLtest2,SPLtest3", caller1}, 0, 0)
+	assert.True(t, err == nil)
+	balances, err = simplejson.NewJson([]byte(res.Get("api_result").MustString()))
+	assert.True(t, err == nil)
+	_, found := balances.CheckGet("SPLtest2")
+	assert.False(t, found)
+	assert.Equal(t, 0, balances.Get("SPLtest2,SPLtest3").MustInt(-1))
+
+	// an amount that isn't an integer is rejected
+	for _, amount := range []interface{}{"3.5", 3.5, "abc"} {
+		res, err = simpleChainRPC("invoke_contract_offline", caller1, contract1Addr, "transfer", []interface{}{"SPLtest2", amount}, 0, 0)
+		assert.True(t, err == nil)
+		assert.False(t, res.Get("exec_succeed").MustBool(), amount)
+	}
+	// the old single string form still works
+	res, err = invokeContractOffline(caller1, contract1Addr, "transfer", "SPLtest2,5")
+	assert.True(t, err == nil)
+	assert.True(t, res.Get("exec_succeed").MustBool())
+}
+
 func makeOrder(t *testing.T, signer_prik string, purchaseAsset string, purchaseNum int, payAsset string, payNum int, ordertype string) map[string]string {
 	var res *simplejson.Json
 	var err error
@@ -2078,6 +2987,86 @@ func test0xExchangeContractInSimplechain(t *testing.T, contract1Addr string) {
 	simpleChainRPC("generate_block")
 }
 
+func TestSignatureCacheHitsAndMisses(t *testing.T) {
+	fmt.Println("TestSignatureCacheHitsAndMisses")
+	cmd := execCommandBackground(simpleChainPath)
+	assert.True(t, cmd != nil)
+	fmt.Printf("simplechain pid: %d\n", cmd.Process.Pid)
+	defer func() {
+		kill(cmd)
+	}()
+	time.Sleep(1 * time.Second)
+	var res *simplejson.Json
+	var err error
+	caller1 := "SPLtest1"
+
+	_, compileErr := execCommand(uvmCompilerPath, "-g", "../../test_contracts/test_signature_cache.lua")
+	assert.Equal(t, compileErr, "")
+	res, err = simpleChainRPC("create_contract_from_file", caller1, testContractPath("test_signature_cache.lua.gpc"), 50000, 10)
+	assert.True(t, err == nil)
+	contract1Addr := res.Get("contract_address").MustString()
+	simpleChainRPC("generate_block")
+
+	cacheStats := func() (int, int, int) {
+		stats, err := simpleChainRPC("get_signature_cache_stats")
+		assert.True(t, err == nil)
+		return stats.Get("size").MustInt(), stats.Get("hits").MustInt(), stats.Get("misses").MustInt()
+	}
+	recover := func(digest string) (string, int) {
+		res, err := invokeContractOffline(caller1, contract1Addr, "recover", digest)
+		assert.True(t, err == nil)
+		assert.True(t, res.Get("exec_succeed").MustBool(), digest)
+		return res.Get("api_result").MustString(), res.Get("gas_used").MustInt()
+	}
+	digest1 := "b94d27b9934d3e08a52e52d7da7dabfac484efe37a5380ee9088f7ace2efcde9"
+	digest2 := "bcc7b3934d14f9e30c4c0981d5fb31a0685043f6adba6875e5d4cd1c6831b89e"
+
+	// the first recover of a key misses and the second one hits
+	size0, hits0, misses0 := cacheStats()
+	pubkey1, gas1 := recover(digest1)
+	size1, hits1, misses1 := cacheStats()
+	assert.True(t, pubkey1 != "")
+	assert.Equal(t, size0+1, size1)
+	assert.Equal(t, hits0+1, hits1)
+	assert.Equal(t, misses0+1, misses1)
+
+	// a cached key only hits, with the same result and gas
+	pubkey1Again, gas1Again := recover(digest1)
+	size2, hits2, misses2 := cacheStats()
+	assert.Equal(t, pubkey1, pubkey1Again)
+	assert.Equal(t, gas1, gas1Again)
+	assert.Equal(t, size1, size2)
+	assert.Equal(t, hits1+2, hits2)
+	assert.Equal(t, misses1, misses2)
+
+	// another digest is another key
+	pubkey2, _ := recover(digest2)
+	size3, hits3, misses3 := cacheStats()
+	assert.True(t, pubkey2 != pubkey1)
+	assert.Equal(t, size2+1, size3)
+	assert.Equal(t, hits2+1, hits3)
+	assert.Equal(t, misses2+1, misses3)
+
+	// a batch goes through the same cache, an invalid signature gives an empty key,
+	// and every item is charged like a signature_recover whether it hits or not
+	recoverBatch := func(digest string) (string, int) {
+		res, err := invokeContractOffline(caller1, contract1Addr, "recover_batch", digest)
+		assert.True(t, err == nil)
+		assert.True(t, res.Get("exec_succeed").MustBool(), digest)
+		return res.Get("api_result").MustString(), res.Get("gas_ledger").Get("crypto").Get("signature_recover_batch").MustInt()
+	}
+	keys, batchGas := recoverBatch(digest1)
+	_, hits4, misses4 := cacheStats()
+	assert.Equal(t, pubkey1+","+pubkey1+",", keys)
+	assert.Equal(t, 3*500, batchGas)
+	assert.Equal(t, hits3+2, hits4)
+	assert.Equal(t, misses3+1, misses4)
+	digest3 := "3c3ce98a97977e4276548854074c4482507c640d3c3ce98a97977e4276548854"
+	keys, batchGasUncached := recoverBatch(digest3)
+	assert.Equal(t, batchGas, batchGasUncached)
+	assert.True(t, strings.HasSuffix(keys, ","))
+}
+
 func TestNativeExchangeContract(t *testing.T) {
 	fmt.Println("TestNativeExchangeContract")
 	cmd := execCommandBackground(simpleChainPath)
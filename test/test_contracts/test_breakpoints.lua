@@ -0,0 +1,19 @@
+type Storage = {
+    num: int
+}
+
+var M = Contract<Storage>()
+
+function M:init()
+    self.storage.num = 0
+end
+
+function M:run(arg: string)
+    var a = 1
+    a = a + 1
+    a = a * 3
+    self.storage.num = a
+    return tostring(a)
+end
+
+return M
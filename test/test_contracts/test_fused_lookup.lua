@@ -0,0 +1,22 @@
+type Storage = {
+    num: int
+}
+
+var M = Contract<Storage>()
+
+function M:init()
+    self.storage.num = 0
+end
+
+-- every iteration runs chained lookups the compiler fuses into one dispatch
+offline function M:lookup(arg: string)
+    let cfg = {a: {b: {c: 1}}}
+    var sum = 0
+    for i=1,100,1 do
+        sum = sum + cfg.a.b.c
+        sum = sum + string.len(arg)
+    end
+    return tostring(sum)
+end
+
+return M
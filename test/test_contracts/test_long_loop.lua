@@ -0,0 +1,25 @@
+type Storage = {
+    num: int
+}
+
+var M = Contract<Storage>()
+
+function M:init()
+    self.storage.num = 0
+end
+
+-- loops arg times, to keep the chain busy for a while
+function M:spin(arg: string)
+    let n = tointeger(arg)
+    var sum = 0
+    for i=1,n,1 do
+        sum = (sum + i) % 1000
+    end
+    self.storage.num = sum
+end
+
+offline function M:query(arg: string)
+    return tostring(self.storage.num)
+end
+
+return M
@@ -0,0 +1,30 @@
+type Storage = {
+    num: int
+}
+
+var M = Contract<Storage>()
+
+function M:init()
+    self.storage.num = 0
+end
+
+-- recovers the same signature twice, the second time from the signature cache
+offline function M:recover(digest: string)
+    let sig = "1bfc992468ae2d0fc3d567813c5eb9e7e874db4ed2b2d08a8327216a9934034de6d3081c5f7901f3e897a7b4c4e09dcb59d2e8b7455d4d6c6dfabed227ecefd666"
+    let first = signature_recover(sig, digest)
+    let second = signature_recover(sig, digest)
+    if first ~= second then
+        error("cached public key differs")
+    end
+    return first
+end
+
+-- recovers the signature twice and an invalid one in one batch
+offline function M:recover_batch(digest: string)
+    let sig = "1bfc992468ae2d0fc3d567813c5eb9e7e874db4ed2b2d08a8327216a9934034de6d3081c5f7901f3e897a7b4c4e09dcb59d2e8b7455d4d6c6dfabed227ecefd666"
+    let bad_sig = "1b00000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+    let keys = signature_recover_batch([sig, sig, bad_sig], [digest, digest, digest])
+    return tostring(keys[1]) .. ',' .. tostring(keys[2]) .. ',' .. tostring(keys[3])
+end
+
+return M
@@ -0,0 +1,66 @@
+type Storage = {
+    num: int
+}
+
+var M = Contract<Storage>()
+
+function M:init()
+    self.storage.num = 0
+end
+
+-- adds n, n-1, ..., 1 to acc.sum by n nested calls
+local function sum_to(n: int, acc: table)
+    if n <= 0 then
+        return
+    end
+    acc.sum = acc.sum + n
+    sum_to(n - 1, acc)
+    -- not a tail call, so every frame stays on the stack until the bottom is reached
+    acc.calls = acc.calls + 1
+end
+
+-- recurses n frames deep and fails at the bottom
+local function fail_at(n: int)
+    if n <= 0 then
+        error("failed at the bottom")
+    end
+    fail_at(n - 1)
+    return
+end
+
+-- recurses until the stack overflows
+local function overflow(depth: int)
+    overflow(depth + 1)
+    return
+end
+
+function M:recurse(arg: string)
+    let acc = {sum = 0, calls = 0}
+    sum_to(tointeger(arg), acc)
+    return tostring(acc.sum)
+end
+
+function M:fail_deep(arg: string)
+    fail_at(tointeger(arg))
+end
+
+function M:overflow(arg: string)
+    overflow(0)
+end
+
+-- arg: address of another instance of this contract. send_message catches the errors of its apis,
+-- so the stack of this call grows, fails deep inside the callee, shrinks and grows again
+function M:run(arg: string)
+    let acc = {sum = 0, calls = 0}
+    sum_to(3000, acc)
+    let failed = send_message(arg, "fail_deep", ["5000"])
+    sum_to(10000, acc)
+    let overflowed = send_message(arg, "overflow", [""])
+    sum_to(3000, acc)
+    let succeeded = send_message(arg, "recurse", ["2000"])
+    sum_to(20000, acc)
+    return tostring(acc.sum) .. ',' .. tostring(acc.calls) .. ',' .. tostring(failed[2]) .. ','
+        .. tostring(overflowed[2]) .. ',' .. tostring(succeeded[2]) .. ',' .. tostring(succeeded[1])
+end
+
+return M
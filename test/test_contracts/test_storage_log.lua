@@ -0,0 +1,41 @@
+type Storage = {
+    num: int,
+    items: Map<int>
+}
+
+var M = Contract<Storage>()
+
+function M:init()
+    self.storage.num = 0
+    self.storage.items = {}
+end
+
+-- every key is written several times in one call, the reads must see the last write
+function M:fill(arg: string)
+    for i=1,200,1 do
+        fast_map_set('balances', tostring(i % 50), i)
+    end
+    var sum = 0
+    for i=0,49,1 do
+        sum = sum + tointeger(fast_map_get('balances', tostring(i)) or 0)
+    end
+    for i=1,100,1 do
+        self.storage.items[tostring(i % 10)] = i
+    end
+    self.storage.num = sum
+    emit Filled(tostring(sum))
+end
+
+-- reads the committed value before changing it again
+function M:increase(key: string)
+    let balance = tointeger(fast_map_get('balances', key) or 0)
+    fast_map_set('balances', key, balance + 1)
+    fast_map_set('balances', key, tointeger(fast_map_get('balances', key)) + 1)
+    self.storage.items[key] = tointeger(self.storage.items[key] or 0) + 1
+end
+
+offline function M:query(key: string)
+    return tostring(self.storage.num) .. ',' .. tostring(fast_map_get('balances', key)) .. ',' .. tostring(self.storage.items[key])
+end
+
+return M
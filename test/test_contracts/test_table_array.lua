@@ -0,0 +1,35 @@
+type Storage = {
+    num: int
+}
+
+var M = Contract<Storage>()
+
+function M:init()
+    self.storage.num = 0
+end
+
+local function dump(t: table)
+    var out = ''
+    for k, v in pairs(t) do
+        out = out .. tostring(k) .. '=' .. tostring(v) .. ','
+    end
+    return out
+end
+
+-- integer keys filled out of order end up in the array part
+offline function M:fill(arg: string)
+    let t = {}
+    t[3] = 'c'
+    t[2] = 'b'
+    t[5] = 'e'
+    t[1] = 'a'
+    t[4] = 'd'
+    t.x = 'x'
+    let t2 = {}
+    t2[2] = 'b'
+    t2[true] = 'y'
+    t2[1] = 'a'
+    return tostring(#t) .. ':' .. dump(t) .. ';' .. tostring(#t2) .. ':' .. dump(t2)
+end
+
+return M
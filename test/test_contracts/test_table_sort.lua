@@ -0,0 +1,23 @@
+type Storage = {
+    num: int
+}
+
+var M = Contract<Storage>()
+
+function M:init()
+    self.storage.num = 0
+end
+
+-- sorts the same 200 integers in an order given by step, step 1 gives them already sorted.
+-- the instructions run do not depend on step, only the comparisons of the native sort do
+offline function M:sort(arg: string)
+    let step = tointeger(arg)
+    var a = {}
+    for i=1,200,1 do
+        a[i] = (i * step) % 211
+    end
+    table.sort(a)
+    return tostring(a[1]) .. "," .. tostring(a[200])
+end
+
+return M
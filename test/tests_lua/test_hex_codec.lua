@@ -0,0 +1,35 @@
+print("test hex codec begin")
+
+-- one char at a time, to compare with the codec working on 16 bytes at a time
+local function slow_hex(s: string)
+    var out = ''
+    for i=1,#s,1 do
+        out = out .. string.format('%02x', string.byte(s, i))
+    end
+    return out
+end
+
+-- sizes around the 16 bytes blocks, with every byte value including '\0'
+var round_trip_ok = true
+for _, n in ipairs([0, 1, 15, 16, 17, 31, 32, 33, 100, 256]) do
+    var data = ''
+    for i=1,n,1 do
+        data = data .. string.char((i * 37 + 11) % 256)
+    end
+    let hex = bin_to_hex(data)
+    if #hex ~= 2 * n or hex ~= slow_hex(data) or hex_to_bin(hex) ~= data or hex_to_bin(string.upper(hex)) ~= data then
+        print("hex round trip failed at size ", n)
+        round_trip_ok = false
+    end
+end
+print("hex round trip ok: ", round_trip_ok)
+
+let mixed = hex_to_bin('0aBcDeF0123456789AbCdEf0123456789fF0')
+print("mixed case ok: ", mixed == hex_to_bin('0abcdef0123456789abcdef0123456789ff0'))
+
+-- cbor hex is upper case and decoded in either case
+let encoded = cbor_encode("hello world 1234567890")
+print("encoded: ", encoded)
+print("lower case decoded: ", cbor_decode(string.lower(encoded)))
+
+print("test hex codec end")
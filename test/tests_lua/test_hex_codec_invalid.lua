@@ -0,0 +1,3 @@
+-- a non-hex char in the second 16 chars block
+let data = hex_to_bin('00112233445566778899aabbccddeeff0g')
+print("decoded invalid hex: ", bin_to_hex(data))
@@ -0,0 +1,88 @@
+print("test inline cache begin")
+
+-- each of these accesses has a constant key, so it goes through the inline cache of its instruction
+local function get_x(t)
+    return t.x
+end
+
+local function set_x(t, v)
+    t.x = v
+end
+
+local function call_m(t)
+    return t:m()
+end
+
+-- keys added or removed after the cache is warmed
+var t1 = {x = 1}
+var warm_ok = true
+for i=1,10,1 do
+    warm_ok = warm_ok and get_x(t1) == 1
+end
+t1.y = 2
+t1.z = 3
+var added_ok = warm_ok and get_x(t1) == 1 and t1.y == 2
+set_x(t1, 4)
+added_ok = added_ok and get_x(t1) == 4
+t1.x = nil
+var removed_ok = get_x(t1) == nil
+set_x(t1, 5)
+removed_ok = removed_ok and get_x(t1) == 5 and t1.y == 2
+print("key added ok: ", added_ok)
+print("key removed ok: ", removed_ok)
+
+-- the same instruction sees other tables, also ones allocated where a freed one was
+var t2 = {y = 1, x = 2}
+var other_tables_ok = get_x(t1) == 5 and get_x(t2) == 2 and get_x(t1) == 5
+for i=1,100,1 do
+    let t = {x = i}
+    other_tables_ok = other_tables_ok and get_x(t) == i
+end
+other_tables_ok = other_tables_ok and get_x({y = 1}) == nil
+print("other tables ok: ", other_tables_ok)
+
+-- a metatable set on a cached table
+var t3 = {x = 1}
+get_x(t3)
+set_x(t3, 2)
+t3.x = nil
+var newindex_value = nil
+setmetatable(t3, {__index = {x = 9}, __newindex = function(t, k, v) newindex_value = v end})
+var metatable_ok = get_x(t3) == 9
+set_x(t3, 10)
+metatable_ok = metatable_ok and newindex_value == 10 and get_x(t3) == 9
+var obj = {m = function(self) return 1 end}
+call_m(obj)
+obj.m = nil
+setmetatable(obj, {__index = {m = function(self) return 2 end}})
+metatable_ok = metatable_ok and call_m(obj) == 2
+print("metatable ok: ", metatable_ok)
+
+-- a table growing and rehashed between hits
+var t4 = {x = 1}
+get_x(t4)
+var rehash_ok = true
+for i=1,500,1 do
+    t4["k" .. tostring(i)] = i
+    t4[i] = i
+    if i % 50 == 0 then
+        set_x(t4, i)
+        rehash_ok = rehash_ok and get_x(t4) == i
+    end
+end
+rehash_ok = rehash_ok and t4.k250 == 250 and t4[250] == 250 and get_x(t4) == 500
+print("rehash ok: ", rehash_ok)
+
+-- globals through the cache of GETTABUP
+function cached_global()
+    return 1
+end
+local function call_global()
+    return cached_global()
+end
+var globals_ok = call_global() == 1 and call_global() == 1
+cached_global = function() return 2 end
+globals_ok = globals_ok and call_global() == 2
+print("globals ok: ", globals_ok)
+
+print("test inline cache end")
@@ -0,0 +1,106 @@
+print("test table sort begin")
+
+local function is_sorted(a, n)
+    for i=2,n,1 do
+        if a[i] < a[i-1] then
+            return false
+        end
+    end
+    return true
+end
+
+-- sorts a copy of a and checks it is ordered and keeps every element
+local function check_sort(a, n)
+    var b = {}
+    var counts = {}
+    for i=1,n,1 do
+        b[i] = a[i]
+        counts[a[i]] = (counts[a[i]] or 0) + 1
+    end
+    table.sort(b)
+    if not is_sorted(b, n) then
+        return false
+    end
+    for i=1,n,1 do
+        counts[b[i]] = counts[b[i]] - 1
+    end
+    for _, c in pairs(counts) do
+        if c ~= 0 then
+            return false
+        end
+    end
+    return true
+end
+
+-- small integer arrays, sorted by insertion only
+var small_ok = check_sort([3, 1, 2], 3) and check_sort([5, -1, 5, 0, 9, -7, 2, 2], 8)
+print("small int sort ok: ", small_ok)
+
+-- more than 16 elements, with duplicates and negative numbers
+var ints = {}
+var seed = 12345
+for i=1,500,1 do
+    seed = (seed * 1103515245 + 12345) % 2147483648
+    ints[i] = seed % 1000 - 500
+end
+print("int sort ok: ", check_sort(ints, 500))
+
+-- inputs known to be bad for a median of three quicksort
+let n = 1024
+let k = 512
+var sorted_ints = {}
+var reversed_ints = {}
+var equal_ints = {}
+var organ_pipe = {}
+var sawtooth = {}
+var killer = {}
+for i=1,n,1 do
+    sorted_ints[i] = i
+    reversed_ints[i] = n - i
+    equal_ints[i] = 7
+    organ_pipe[i] = (i <= k) and i or (n - i)
+    sawtooth[i] = i % 17
+end
+-- median of three killer sequence of Musser
+for i=1,k,1 do
+    if i % 2 == 1 then
+        killer[i] = i
+    else
+        killer[i] = k + i - 1
+    end
+    killer[k + i] = 2 * i
+end
+var adversarial_ok = check_sort(sorted_ints, n) and check_sort(reversed_ints, n) and check_sort(equal_ints, n)
+    and check_sort(organ_pipe, n) and check_sort(sawtooth, n) and check_sort(killer, n)
+print("adversarial sort ok: ", adversarial_ok)
+
+-- strings, compared as the generic sort does
+var strs = {}
+for i=1,100,1 do
+    strs[i] = tostring((i * 37) % 101)
+end
+strs[101] = ""
+strs[102] = "a"
+strs[103] = "ab"
+strs[104] = "a"
+print("string sort ok: ", check_sort(strs, 104))
+var names = ["pear", "apple", "fig", "banana"]
+table.sort(names)
+print("sorted names: ", table.concat(names, ","))
+
+-- integers mixed with floats use the generic sort
+var mixed = [3, 1.5, 2, -0.5, 10, 2.5]
+table.sort(mixed)
+print("sorted mixed: ", table.concat(mixed, ","))
+
+-- a table with a metatable uses the generic sort
+var with_meta = setmetatable([4, 2, 3, 1], {})
+table.sort(with_meta)
+print("sorted with metatable: ", table.concat(with_meta, ","))
+
+-- an order function uses the generic sort
+var desc = [4, 9, 1, 7]
+table.sort(desc, function(a, b) return a > b end)
+print("sorted descending: ", table.concat(desc, ","))
+
+print("test table sort end")
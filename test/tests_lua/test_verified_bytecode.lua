@@ -0,0 +1,37 @@
+print("test_verified_bytecode begin")
+
+local function make_counter(start)
+	var count = start
+	return function(step)
+		count = count + step
+		return count
+	end
+end
+
+let counter = make_counter(10)
+counter(1)
+print("a1=", counter(5))
+
+local function first_nils(...)
+	local x, y, z
+	let args = {...}
+	return x, y, z, #args
+end
+print("a2=", first_nils(1, 2, 3))
+
+var s = 0
+for i = 1, 10 do
+	let add = function(v)
+		return v + i
+	end
+	s = add(s)
+end
+print("a3=", s)
+
+var keys = ''
+for k, v in pairs({a=1, b=2}) do
+	keys = keys .. k .. tostring(v)
+end
+print("a4=", keys)
+
+print("test_verified_bytecode end")
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace uvm {
+	namespace bench {
+
+		// runs the measured operation `iterations` times
+		typedef std::function<void(uint64_t iterations)> benchmark_function;
+
+		struct benchmark {
+			std::string name;
+			std::string group; // micro or contract
+			benchmark_function function;
+		};
+
+		struct benchmark_result {
+			std::string name;
+			std::string group;
+			uint64_t iterations = 0;
+			double total_ns = 0;
+			double ns_per_op = 0;
+			bool succeed = true;
+			std::string error;
+		};
+
+		void register_benchmark(const std::string& group, const std::string& name, benchmark_function function);
+		const std::vector<benchmark>& registered_benchmarks();
+
+		void register_micro_benchmarks();
+		void register_contract_benchmarks(const std::string& contracts_dir);
+
+		// keeps the compiler from dropping a computed value
+		void do_not_optimize(const void* p);
+		template <typename T>
+		inline void do_not_optimize_value(const T& value) {
+			do_not_optimize(&value);
+		}
+
+	}
+}
@@ -0,0 +1,43 @@
+#include "bench_chain_api.h"
+#include <simplechain/storage.h>
+
+namespace uvm {
+	namespace bench {
+
+		UvmStorageValue bench_chain_api::get_storage_value_from_uvm(lua_State *L, const char *contract_name,
+			const std::string& name, const std::string& fast_map_key, bool is_fast_map) {
+			return get_storage_value_from_uvm_by_address(L, contract_name, name, fast_map_key, is_fast_map);
+		}
+
+		UvmStorageValue bench_chain_api::get_storage_value_from_uvm_by_address(lua_State *L, const char *contract_address,
+			const std::string& name, const std::string& fast_map_key, bool is_fast_map) {
+			auto key = std::string(contract_address) + "$" + name;
+			if (is_fast_map) {
+				key = key + "." + fast_map_key;
+			}
+			auto it = _storages.find(key);
+			if (it != _storages.end()) {
+				return simplechain::json_to_uvm_storage_value(L, it->value());
+			}
+			UvmStorageValue value;
+			value.type = uvm::blockchain::StorageValueTypes::storage_value_null;
+			value.value.int_value = 0;
+			return value;
+		}
+
+		bool bench_chain_api::commit_storage_changes_to_uvm(lua_State *L, AllContractsChangesMap &changes) {
+			for (const auto &change : changes) {
+				for (const auto &change_info : *(change.second)) {
+					auto key = change.first + "$" + change_info.first;
+					_storages[key] = simplechain::uvm_storage_value_to_json(change_info.second.after);
+				}
+			}
+			return true;
+		}
+
+		void bench_chain_api::clear_storages() {
+			_storages = fc::mutable_variant_object();
+		}
+
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "../uvm_single/uvm_api.demo.h"
+#include <fc/variant_object.hpp>
+
+namespace uvm {
+	namespace bench {
+
+		// demo chain api keeping contract storages in memory, so the contract benchmarks don't measure file writes
+		class bench_chain_api : public uvm::lua::api::DemoUvmChainApi {
+		public:
+			virtual UvmStorageValue get_storage_value_from_uvm(lua_State *L, const char *contract_name,
+				const std::string& name, const std::string& fast_map_key, bool is_fast_map);
+			virtual UvmStorageValue get_storage_value_from_uvm_by_address(lua_State *L, const char *contract_address,
+				const std::string& name, const std::string& fast_map_key, bool is_fast_map);
+			virtual bool commit_storage_changes_to_uvm(lua_State *L, AllContractsChangesMap &changes);
+
+			void clear_storages();
+
+		private:
+			fc::mutable_variant_object _storages;
+		};
+
+	}
+}
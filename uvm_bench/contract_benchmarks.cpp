@@ -0,0 +1,106 @@
+#include "bench.h"
+#include "bench_chain_api.h"
+#include <uvm/lprefix.h>
+#include <uvm/lua.h>
+#include <uvm/lauxlib.h>
+#include <uvm/uvm_lib.h>
+#include <uvm/exceptions.h>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace uvm {
+	namespace bench {
+		using uvm::lua::api::global_uvm_chain_api;
+
+		static const char* bench_caller_address = "SPLbenchcaller";
+
+		struct contract_call {
+			std::string api_name;
+			std::string api_arg; // may contain {i}, replaced by the iteration index mod 100
+		};
+
+		static std::string format_arg(const std::string& arg, uint64_t index) {
+			auto pos = arg.find("{i}");
+			if (pos == std::string::npos)
+				return arg;
+			return arg.substr(0, pos) + std::to_string(index % 100) + arg.substr(pos + 3);
+		}
+
+		// load the contract bytecode like the chain does for each call, then call the api
+		static void call_contract(lua_State* L, const std::string& contract_path, const std::string& contract_id, const contract_call& call, uint64_t index) {
+			auto top = lua_gettop(L);
+			if (luaL_loadfile(L, contract_path.c_str()) != LUA_OK || lua_pcall(L, 0, 1, 0) != LUA_OK) {
+				std::string error = lua_tostring(L, -1) ? lua_tostring(L, -1) : "unknown error";
+				lua_settop(L, top);
+				throw uvm::core::UvmException(std::string("load contract ") + contract_path + " error: " + error);
+			}
+			cbor::CborArrayValue args;
+			args.push_back(cbor::CborObject::from_string(format_arg(call.api_arg, index)));
+			std::string result;
+			bool ok = uvm::lua::lib::call_last_contract_api(L, contract_id, call.api_name, args, bench_caller_address, "", &result);
+			lua_settop(L, top);
+			if (!ok || global_uvm_chain_api->has_exception(L)) {
+				global_uvm_chain_api->clear_exceptions(L);
+				throw uvm::core::UvmException(std::string("call contract api ") + call.api_name + " failed");
+			}
+		}
+
+		// each run starts from empty storages, calls the setup apis once and the loop apis `iterations` times
+		static void register_contract_benchmark(const std::string& name, const std::string& contract_path,
+			const std::vector<contract_call>& setup_calls, const std::vector<contract_call>& loop_calls) {
+			FILE* f = fopen(contract_path.c_str(), "rb");
+			if (!f) {
+				fprintf(stderr, "contract %s not found, skip benchmark %s\n", contract_path.c_str(), name.c_str());
+				return;
+			}
+			fclose(f);
+			register_benchmark("contract", name, [name, contract_path, setup_calls, loop_calls](uint64_t iterations) {
+				static_cast<bench_chain_api*>(global_uvm_chain_api)->clear_storages();
+				uvm::lua::lib::UvmStateScope scope(true, false);
+				auto L = scope.L();
+				std::string contract_id = "bench_" + name;
+				for (const auto& call : setup_calls) {
+					call_contract(L, contract_path, contract_id, call, 0);
+				}
+				for (uint64_t i = 0; i < iterations; i++) {
+					call_contract(L, contract_path, contract_id, loop_calls[i % loop_calls.size()], i);
+				}
+			});
+		}
+
+		void register_contract_benchmarks(const std::string& contracts_dir) {
+			const std::vector<contract_call> token_setup = {
+				{ "init", "" },
+				{ "init_token", "test,TEST,100000000000,100" }
+			};
+			register_contract_benchmark("token_transfer", contracts_dir + "/token.gpc", token_setup, {
+				{ "transfer", "SPLbenchreceiver{i},10" }
+			});
+			register_contract_benchmark("token_transfer_and_balance", contracts_dir + "/token.gpc", token_setup, {
+				{ "transfer", "SPLbenchreceiver{i},10" },
+				{ "balanceOf", "SPLbenchreceiver{i}" }
+			});
+			register_contract_benchmark("newtoken_transfer", contracts_dir + "/newtoken.gpc", token_setup, {
+				{ "transfer", "SPLbenchreceiver{i},10" }
+			});
+			register_contract_benchmark("dex_exchange_deposit", contracts_dir + "/out_dex_exchange_target.lua.gpc", {
+				{ "init", "" },
+				{ "init_config", bench_caller_address }
+			}, {
+				{ "on_deposit_asset", "{\"num\":100,\"symbol\":\"HX\",\"param\":\"\"}" },
+				{ "balanceOf", bench_caller_address }
+			});
+			// plasma_root_chain.lua has no precompiled bytecode in the tree, compile it with the glua compiler
+			// to plasma_root_chain.lua.gpc to get it benchmarked
+			register_contract_benchmark("plasma_root_chain_state", contracts_dir + "/plasma_root_chain.lua.gpc", {
+				{ "init", "" }
+			}, {
+				{ "state", "" },
+				{ "get_config", "" }
+			});
+		}
+
+	}
+}
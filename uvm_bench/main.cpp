@@ -0,0 +1,166 @@
+/**
+ * uvm_bench: micro benchmarks of the vm internals and macro benchmarks of the test contracts
+ * usage: uvm_bench [--filter=<substring>] [--min-time=<seconds>] [--contracts-dir=<dir>]
+ * results are printed to stdout as json
+ */
+#include "bench.h"
+#include "bench_chain_api.h"
+#include <uvm/uvm_api.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <string>
+#include <vector>
+
+namespace uvm {
+	namespace bench {
+
+		static std::vector<benchmark>& benchmarks() {
+			static std::vector<benchmark> items;
+			return items;
+		}
+
+		void register_benchmark(const std::string& group, const std::string& name, benchmark_function function) {
+			benchmark item;
+			item.name = name;
+			item.group = group;
+			item.function = function;
+			benchmarks().push_back(item);
+		}
+
+		const std::vector<benchmark>& registered_benchmarks() {
+			return benchmarks();
+		}
+
+		static const void* volatile do_not_optimize_sink = nullptr;
+
+		void do_not_optimize(const void* p) {
+			do_not_optimize_sink = p;
+		}
+
+		// grow the iterations until one run takes at least min_time, the last run is reported
+		static benchmark_result run_benchmark(const benchmark& item, double min_time_seconds) {
+			benchmark_result result;
+			result.name = item.name;
+			result.group = item.group;
+			uint64_t iterations = 1;
+			const double min_time_ns = min_time_seconds * 1e9;
+			try {
+				// first run warms up caches and the lazily created states
+				item.function(1);
+				while (true) {
+					auto start = std::chrono::steady_clock::now();
+					item.function(iterations);
+					auto end = std::chrono::steady_clock::now();
+					double elapsed_ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+					result.iterations = iterations;
+					result.total_ns = elapsed_ns;
+					if (elapsed_ns >= min_time_ns || iterations >= (uint64_t(1) << 40))
+						break;
+					// aim a bit over min_time, at most 10x more iterations each round
+					double factor = elapsed_ns > 0 ? (min_time_ns * 1.2 / elapsed_ns) : 10;
+					if (factor > 10)
+						factor = 10;
+					if (factor < 2)
+						factor = 2;
+					iterations = uint64_t(double(iterations) * factor);
+				}
+				result.ns_per_op = result.total_ns / double(result.iterations);
+			}
+			catch (const std::exception& e) {
+				result.succeed = false;
+				result.error = e.what();
+			}
+			return result;
+		}
+
+		static std::string json_escape(const std::string& str) {
+			std::string result;
+			for (auto c : str) {
+				switch (c) {
+				case '"': result += "\\\""; break;
+				case '\\': result += "\\\\"; break;
+				case '\n': result += "\\n"; break;
+				case '\r': result += "\\r"; break;
+				case '\t': result += "\\t"; break;
+				default:
+					if ((unsigned char)c < 0x20) {
+						char buf[8];
+						snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)c);
+						result += buf;
+					}
+					else
+						result += c;
+				}
+			}
+			return result;
+		}
+
+		static void print_results(const std::vector<benchmark_result>& results, double min_time_seconds) {
+			printf("{\n  \"context\": {\"timestamp\": %lld, \"min_time\": %g},\n  \"benchmarks\": [", (long long)std::time(nullptr), min_time_seconds);
+			for (size_t i = 0; i < results.size(); i++) {
+				const auto& r = results[i];
+				printf("%s\n    {\"name\": \"%s\", \"group\": \"%s\", \"succeed\": %s, \"iterations\": %llu, \"total_ns\": %.0f, \"ns_per_op\": %.3f",
+					i > 0 ? "," : "", json_escape(r.name).c_str(), json_escape(r.group).c_str(), r.succeed ? "true" : "false",
+					(unsigned long long)r.iterations, r.total_ns, r.ns_per_op);
+				if (!r.succeed)
+					printf(", \"error\": \"%s\"", json_escape(r.error).c_str());
+				printf("}");
+			}
+			printf("\n  ]\n}\n");
+		}
+
+	}
+}
+
+static bool parse_option(const char* arg, const char* name, std::string& value) {
+	auto len = strlen(name);
+	if (strncmp(arg, name, len) != 0 || arg[len] != '=')
+		return false;
+	value = arg + len + 1;
+	return true;
+}
+
+int main(int argc, char** argv) {
+	using namespace uvm::bench;
+	std::string filter;
+	std::string contracts_dir = "test/test_contracts";
+	double min_time_seconds = 0.5;
+	for (int i = 1; i < argc; i++) {
+		std::string value;
+		if (parse_option(argv[i], "--filter", value))
+			filter = value;
+		else if (parse_option(argv[i], "--min-time", value))
+			min_time_seconds = atof(value.c_str());
+		else if (parse_option(argv[i], "--contracts-dir", value))
+			contracts_dir = value;
+		else {
+			fprintf(stderr, "usage: %s [--filter=<substring>] [--min-time=<seconds>] [--contracts-dir=<dir>]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	uvm::lua::api::global_uvm_chain_api = new bench_chain_api();
+
+	register_micro_benchmarks();
+	register_contract_benchmarks(contracts_dir);
+
+	std::vector<benchmark_result> results;
+	bool all_succeed = true;
+	for (const auto& item : registered_benchmarks()) {
+		auto full_name = item.group + "/" + item.name;
+		if (!filter.empty() && full_name.find(filter) == std::string::npos)
+			continue;
+		fprintf(stderr, "running %s\n", full_name.c_str());
+		auto result = run_benchmark(item, min_time_seconds);
+		if (!result.succeed) {
+			fprintf(stderr, "%s failed: %s\n", full_name.c_str(), result.error.c_str());
+			all_succeed = false;
+		}
+		results.push_back(result);
+	}
+	print_results(results, min_time_seconds);
+	return all_succeed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
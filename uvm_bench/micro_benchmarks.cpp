@@ -0,0 +1,228 @@
+#include "bench.h"
+#include <uvm/lprefix.h>
+#include <uvm/lua.h>
+#include <uvm/lauxlib.h>
+#include <uvm/lualib.h>
+#include <uvm/uvm_lib.h>
+#include <uvm/exceptions.h>
+#include <vmgc/vmgc.h>
+#include <cborcpp/cbor.h>
+#include <cbor_diff/cbor_diff.h>
+#include <safenumber/safenumber.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace uvm {
+	namespace bench {
+		using namespace cbor;
+
+		// lua state shared by the micro benchmarks, created on first use
+		static lua_State* bench_lua_state() {
+			static std::shared_ptr<uvm::lua::lib::UvmStateScope> scope;
+			if (!scope)
+				scope = std::make_shared<uvm::lua::lib::UvmStateScope>(false, true);
+			return scope->L();
+		}
+
+		// compile the script(a chunk receiving the iterations count as its first arg) once and run it
+		static void run_lua_script(const std::string& name, const char* script, uint64_t iterations) {
+			auto L = bench_lua_state();
+			lua_getfield(L, LUA_REGISTRYINDEX, name.c_str());
+			if (!lua_isfunction(L, -1)) {
+				lua_pop(L, 1);
+				if (luaL_loadbuffer(L, script, strlen(script), name.c_str()) != LUA_OK) {
+					std::string error = lua_tostring(L, -1);
+					lua_pop(L, 1);
+					throw uvm::core::UvmException(std::string("compile bench script error: ") + error);
+				}
+				lua_pushvalue(L, -1);
+				lua_setfield(L, LUA_REGISTRYINDEX, name.c_str());
+			}
+			lua_pushinteger(L, lua_Integer(iterations));
+			if (lua_pcall(L, 1, 1, 0) != LUA_OK) {
+				std::string error = lua_tostring(L, -1) ? lua_tostring(L, -1) : "unknown error";
+				lua_pop(L, 1);
+				throw uvm::core::UvmException(std::string("run bench script error: ") + error);
+			}
+			lua_pop(L, 1);
+		}
+
+		static void register_lua_script_benchmark(const std::string& name, const char* script) {
+			register_benchmark("micro", name, [name, script](uint64_t iterations) {
+				run_lua_script(name, script, iterations);
+			});
+		}
+
+		static CborObjectP make_cbor_sample(int64_t version) {
+			CborMapValue users;
+			for (int i = 0; i < 20; i++) {
+				users["user" + std::to_string(i)] = CborObject::from_int(i * 1000 + version);
+			}
+			CborMapValue root;
+			root["name"] = CborObject::from_string("token");
+			root["supply"] = CborObject::from_int(100000000);
+			root["state"] = CborObject::from_string(version % 2 == 0 ? "COMMON" : "PAUSED");
+			root["users"] = CborObject::create_map(users);
+			CborArrayValue history;
+			for (int i = 0; i < 10; i++) {
+				history.push_back(CborObject::from_int(version + i));
+			}
+			root["history"] = CborObject::create_array(history);
+			return CborObject::create_map(root);
+		}
+
+		void register_micro_benchmarks() {
+			// opcode dispatch: arithmetic, compare and jump in a tight loop
+			register_lua_script_benchmark("vm_dispatch_loop",
+				"local n = ...\n"
+				"local s = 0\n"
+				"for i = 1, n do\n"
+				"  if i % 3 == 0 then s = s + i * 2 else s = s - 1 end\n"
+				"end\n"
+				"return s\n");
+			// function call and return
+			register_lua_script_benchmark("vm_call",
+				"local n = ...\n"
+				"local function add(a, b) return a + b end\n"
+				"local s = 0\n"
+				"for i = 1, n do s = add(s, i) end\n"
+				"return s\n");
+			register_lua_script_benchmark("vm_string_concat",
+				"local n = ...\n"
+				"local s\n"
+				"for i = 1, n do s = 'key_' .. tostring(i) end\n"
+				"return s\n");
+			register_lua_script_benchmark("json_dumps",
+				"local n = ...\n"
+				"local t = {name = 'token', supply = 100000000, users = {a = 1, b = 2, c = 3}, list = {1, 2, 3, 4, 5}}\n"
+				"local s\n"
+				"for i = 1, n do s = json.dumps(t) end\n"
+				"return s\n");
+			register_lua_script_benchmark("json_loads",
+				"local n = ...\n"
+				"local s = '{\"name\":\"token\",\"supply\":100000000,\"users\":{\"a\":1,\"b\":2,\"c\":3},\"list\":[1,2,3,4,5]}'\n"
+				"local t\n"
+				"for i = 1, n do t = json.loads(s) end\n"
+				"return t\n");
+
+			// luaH_setint/luaH_getint on the array part
+			register_benchmark("micro", "table_int_set_get", [](uint64_t iterations) {
+				auto L = bench_lua_state();
+				lua_createtable(L, 0, 0);
+				lua_Integer sum = 0;
+				for (uint64_t i = 1; i <= iterations; i++) {
+					lua_pushinteger(L, lua_Integer(i));
+					lua_rawseti(L, -2, lua_Integer(i));
+					lua_rawgeti(L, -1, lua_Integer(i));
+					sum += lua_tointeger(L, -1);
+					lua_pop(L, 1);
+				}
+				lua_pop(L, 1);
+				do_not_optimize_value(sum);
+			});
+			// luaH_getstr/luaH_newkey with short string keys
+			register_benchmark("micro", "table_str_set_get", [](uint64_t iterations) {
+				auto L = bench_lua_state();
+				static const char* keys[] = { "name", "symbol", "supply", "precision", "state", "admin", "users", "allowed" };
+				lua_createtable(L, 0, 0);
+				lua_Integer sum = 0;
+				for (uint64_t i = 0; i < iterations; i++) {
+					auto key = keys[i % 8];
+					lua_pushinteger(L, lua_Integer(i));
+					lua_setfield(L, -2, key);
+					lua_getfield(L, -1, key);
+					sum += lua_tointeger(L, -1);
+					lua_pop(L, 1);
+				}
+				lua_pop(L, 1);
+				do_not_optimize_value(sum);
+			});
+			// luaH_next over a table with array and hash parts, iterations counts visited items
+			register_benchmark("micro", "table_next", [](uint64_t iterations) {
+				auto L = bench_lua_state();
+				lua_createtable(L, 0, 0);
+				for (int i = 1; i <= 500; i++) {
+					lua_pushinteger(L, i);
+					lua_rawseti(L, -2, i);
+					lua_pushinteger(L, i);
+					lua_setfield(L, -2, ("k" + std::to_string(i)).c_str());
+				}
+				uint64_t visited = 0;
+				while (visited < iterations) {
+					lua_pushnil(L);
+					while (visited < iterations && lua_next(L, -2) != 0) {
+						lua_pop(L, 1);
+						visited++;
+					}
+					if (visited < iterations)
+						continue;
+					lua_pop(L, 1); // key of the interrupted traversal
+				}
+				lua_pop(L, 1);
+				do_not_optimize_value(visited);
+			});
+
+			register_benchmark("micro", "gc_malloc_free", [](uint64_t iterations) {
+				static vmgc::GcState gc;
+				for (uint64_t i = 0; i < iterations; i++) {
+					auto p = gc.gc_malloc(16 + (i % 8) * 16);
+					do_not_optimize(p);
+					gc.gc_free(p);
+				}
+			});
+
+			register_benchmark("micro", "cbor_encode", [](uint64_t iterations) {
+				auto value = make_cbor_sample(1);
+				size_t total = 0;
+				for (uint64_t i = 0; i < iterations; i++) {
+					total += cbor_diff::cbor_encode(value).size();
+				}
+				do_not_optimize_value(total);
+			});
+			register_benchmark("micro", "cbor_decode", [](uint64_t iterations) {
+				const auto& encoded = cbor_diff::cbor_encode(make_cbor_sample(1));
+				for (uint64_t i = 0; i < iterations; i++) {
+					auto decoded = cbor_diff::cbor_decode(encoded);
+					do_not_optimize(decoded.get());
+				}
+			});
+			register_benchmark("micro", "cbor_diff", [](uint64_t iterations) {
+				auto before = make_cbor_sample(1);
+				auto after = make_cbor_sample(2);
+				cbor_diff::CborDiff differ;
+				for (uint64_t i = 0; i < iterations; i++) {
+					auto diff = differ.diff(before, after);
+					do_not_optimize(diff.get());
+				}
+			});
+
+			register_benchmark("micro", "safe_number_create", [](uint64_t iterations) {
+				for (uint64_t i = 0; i < iterations; i++) {
+					auto n = safe_number_create("12345.678901");
+					do_not_optimize_value(n);
+				}
+			});
+			register_benchmark("micro", "safe_number_arith", [](uint64_t iterations) {
+				auto a = safe_number_create("12345.678901");
+				auto b = safe_number_create("3.5");
+				auto acc = safe_number_zero();
+				for (uint64_t i = 0; i < iterations; i++) {
+					auto c = safe_number_multiply(a, b);
+					c = safe_number_div(c, b);
+					acc = safe_number_add(acc, safe_number_minus(c, a));
+				}
+				do_not_optimize_value(acc);
+			});
+			register_benchmark("micro", "safe_number_to_string", [](uint64_t iterations) {
+				auto a = safe_number_create("12345.678901");
+				size_t total = 0;
+				for (uint64_t i = 0; i < iterations; i++) {
+					total += safe_number_to_string(a).size();
+				}
+				do_not_optimize_value(total);
+			});
+		}
+
+	}
+}
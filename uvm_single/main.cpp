@@ -19,6 +19,7 @@
 #include <boost/filesystem/path.hpp>
 #include <boost/algorithm/hex.hpp>
 #include <fc/crypto/hex.hpp>
+#include <uvm/lobject.h>
 
 
 #if !defined(LUA_PROMPT)
@@ -46,6 +47,9 @@ static lua_State *globalL = NULL;
 
 static const char *progname = LUA_PROGNAME;
 
+static bool print_gas_used = false;
+static bool print_verified = false;
+
 
 /*
 ** Hook set by signal function to stop the interpreter.
@@ -89,6 +93,9 @@ static void print_usage(const char *badoption) {
 		"  -t       run contract testcases, load script_path + '.test' bytecode file(contains a function accept contract table) to run testcases\n"
 		"  -k       call contract api, -k script_path contract_api api_argument [caller_address caller_pubkey]\n"
 		"  -x       run with debugger\n"
+		"  -g       print the gas used after running\n"
+		"  -G       meter gas per instruction instead of per basic block\n"
+		"  -V       print how many loaded functions passed the bytecode verifier\n"
 		"  -c       compile source to bytecode\n"
 		"  -h       show help info\n"
 		"  --       stop handling options\n"
@@ -280,6 +287,15 @@ static int pushargs(lua_State *L) {
 
 //static bool use_type_check_compile = true;
 
+/* counts the function 'p' and its nested functions, and those of them that were verified at load */
+static void count_verified_protos(const uvm_types::GcProto *p, int *verified, int *total) {
+	(*total)++;
+	if (p->verified)
+		(*verified)++;
+	for (const auto *sub : p->ps)
+		count_verified_protos(sub, verified, total);
+}
+
 static int handle_script(lua_State *L, char **argv, bool is_contract = false) {
 	int status;
 	const char *fname = argv[0];
@@ -289,6 +305,12 @@ static int handle_script(lua_State *L, char **argv, bool is_contract = false) {
 	if (is_bytecode_file)
 	{
 		status = luaL_loadfile(L, fname);
+		if (status == LUA_OK && print_verified && lua_type(L, -1) == LUA_TFUNCTION && !lua_iscfunction(L, -1)) {
+			int verified = 0, total = 0;
+			auto cl = static_cast<const uvm_types::GcLClosure*>(lua_topointer(L, -1));
+			count_verified_protos(cl->p, &verified, &total);
+			printf("verified functions: %d of %d\n", verified, total);
+		}
 		if (status == LUA_OK) {
 			int n = pushargs(L);  /* push arguments to script */
 			status = docall(L, n, LUA_MULTRET);
@@ -315,6 +337,9 @@ static int handle_script(lua_State *L, char **argv, bool is_contract = false) {
 #define has_call    128 /* -k */
 #define has_debug   256 /* -x */
 #define has_help    512 /* -h */
+#define has_gas     1024 /* -g */
+#define has_gas_per_instruction 2048 /* -G */
+#define has_print_verified 4096 /* -V */
 
 /*
 ** Traverses all arguments from 'argv', returning a mask with those
@@ -372,6 +397,21 @@ static int collectargs(char **argv, int *first) {
 				return has_error;  /* invalid option */
 			args |= has_help;
 			break;
+		case 'g':
+			if (argv[i][2] != '\0')  /* extra characters after 1st? */
+				return has_error;  /* invalid option */
+			args |= has_gas;
+			break;
+		case 'G':
+			if (argv[i][2] != '\0')  /* extra characters after 1st? */
+				return has_error;  /* invalid option */
+			args |= has_gas_per_instruction;
+			break;
+		case 'V':
+			if (argv[i][2] != '\0')  /* extra characters after 1st? */
+				return has_error;  /* invalid option */
+			args |= has_print_verified;
+			break;
 		case 'e':
 			args |= has_e;  /* FALLTHROUGH */
 		case 'l':  /* both options need an argument */
@@ -428,6 +468,9 @@ static int pmain(lua_State *L) {
 		lua_pushboolean(L, 1);  /* signal for libraries to ignore env. vars. */
 		lua_setfield(L, LUA_REGISTRYINDEX, "LUA_NOENV");
 	}
+	print_gas_used = (args & has_gas) != 0;
+	print_verified = (args & has_print_verified) != 0;
+	uvm::lua::lib::set_lua_state_gas_per_instruction(L, (args & has_gas_per_instruction) != 0);
 	luaL_openlibs(L);  /* open standard libraries */
 	createargtable(L, argv, argc, script);  /* create table 'arg' */
 	if (!(args & has_E)) {  /* no option '-E'? */
@@ -538,6 +581,8 @@ int main(int argc, char **argv) {
 		status = lua_pcall(L, 2, 1, 0);  /* do the call */
 		result = lua_toboolean(L, -1);  /* get result */
 		report(L, status);
+		if (print_gas_used)
+			printf("gas used: %d\n", uvm::lua::lib::get_lua_state_instructions_executed_count(L));
 		return (result && status == LUA_OK) ? EXIT_SUCCESS : EXIT_FAILURE;
 	}
 	catch (fc::exception &e) {
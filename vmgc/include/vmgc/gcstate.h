@@ -66,6 +66,15 @@ namespace vmgc {
 
 	//typedef Buffer Block;
 
+	// item of the empty buffers lists, it is stale once _empty_buffers_by_pos no longer maps its pos to its id
+	struct EmptyBuffer {
+		Block block;
+		Buffer buffer;
+		uint64_t id;
+
+		EmptyBuffer(const Block& b, const Buffer& buf, uint64_t i) : block(b), buffer(buf), id(i) {}
+	};
+
 	struct GcBuffer {
 		intptr_t pos;
 		ptrdiff_t size;
@@ -96,13 +105,23 @@ namespace vmgc {
 		ptrdiff_t _max_gc_size;
 
 		std::shared_ptr<std::unordered_map<Block, std::vector<GcBuffer>, Hasher, Equal>> _malloced_blocks_buffers;
-		std::shared_ptr<std::vector<std::pair<Block, Buffer>>> _empty_small_buffers[DEFAULT_SMALL_BUFFER_VECTOR_SIZE]; //empty_size => [ [start_ptr, size], ... ]
-		std::shared_ptr<std::vector<std::pair<Block, Buffer>>> _empty_big_buffers;
+		std::map<intptr_t, Block> _blocks_by_pos; // blockpos => block, to find the block of an address
+		std::shared_ptr<std::vector<EmptyBuffer>> _empty_small_buffers[DEFAULT_SMALL_BUFFER_VECTOR_SIZE]; //empty_size => [ [start_ptr, size], ... ]
+		std::shared_ptr<std::vector<EmptyBuffer>> _empty_big_buffers;
+		// the empty buffers by start_ptr, an item taken through it is left stale in the lists above and skipped there
+		std::map<intptr_t, EmptyBuffer> _empty_buffers_by_pos;
+		uint64_t _next_empty_buffer_id;
 		std::shared_ptr<std::vector<std::pair<intptr_t, intptr_t> > > _malloced_str_blocks; // [ [start_ptr, size], ... ]
 		std::shared_ptr<std::unordered_map<unsigned int,std::pair<intptr_t, ptrdiff_t>>> _gc_strpool;
 		std::pair<intptr_t, ptrdiff_t>  _empty_str_buffer; // [start_ptr, size]
 		void insert_empty_buffer(const Buffer &buf, const Block &block);
+		bool is_live_empty_buffer(const EmptyBuffer &eb) const;
+		// the malloced block containing pos, nullptr if none
+		std::pair<const Block, std::vector<GcBuffer>>* find_block_buffers(intptr_t pos);
 		void insert_malloced_blocks_buffers(Block &block, GcBuffer& gcbuf, bool isNewBlock);
+		bool take_empty_buffer_at(const Block &block, intptr_t pos, Buffer* out);
+		// grow the buffer at p into the empty buffers right after it in its block, returns false when they are too small
+		bool try_extend_in_place(void* p, size_t newsize);
 
 	public:
 		// @throws vmgc::GcException
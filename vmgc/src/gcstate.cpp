@@ -13,11 +13,12 @@ namespace vmgc {
 		_total_malloced_blocks_size = 0;
 		_used_size = 0;
 		_max_gc_size = max_gc_size;
+		_next_empty_buffer_id = 0;
 
 		for (int i = 0; i < DEFAULT_SMALL_BUFFER_VECTOR_SIZE; i++) {
-			_empty_small_buffers[i] = std::make_shared<std::vector<std::pair<Block, Buffer>>>();
+			_empty_small_buffers[i] = std::make_shared<std::vector<EmptyBuffer>>();
 		}
-		this->_empty_big_buffers = std::make_shared<std::vector<std::pair<Block, Buffer>>>();
+		this->_empty_big_buffers = std::make_shared<std::vector<EmptyBuffer>>();
 
 		//////////////////
 		this->_malloced_str_blocks = std::make_shared<std::vector<std::pair<intptr_t, intptr_t>>>();
@@ -47,6 +48,7 @@ namespace vmgc {
 		}
 
 		_empty_big_buffers->clear();
+		_empty_buffers_by_pos.clear();
 
 		////////////////////////////////////
 		for (const auto& item : *_gc_strpool) {
@@ -71,6 +73,7 @@ namespace vmgc {
 			free((void*)(item.first.blockpos));
 		}
 		_malloced_blocks_buffers->clear();
+		_blocks_by_pos.clear();
 
 		for (const auto& item : (*_malloced_str_blocks)) {
 			free((void*)(item.first));
@@ -87,7 +90,7 @@ namespace vmgc {
 
 	void GcState::insert_empty_buffer(const Buffer &buf, const Block &block) {
 		auto size = buf.size;
-		std::pair<Block, Buffer>eb(block, buf);
+		EmptyBuffer eb(block, buf, _next_empty_buffer_id++);
 		if (size > 0) {
 			if ((size > DEFAULT_MAX_SMALL_BUFFER_SIZE) || (size % 8) != 0) {
 				_empty_big_buffers->push_back(eb);
@@ -95,15 +98,23 @@ namespace vmgc {
 			else {
 				_empty_small_buffers[(size / 8) - 1]->push_back(eb);
 			}
+			_empty_buffers_by_pos.erase(buf.pos);
+			_empty_buffers_by_pos.insert(std::make_pair(buf.pos, eb));
 		}
 	}
 
+	bool GcState::is_live_empty_buffer(const EmptyBuffer &eb) const {
+		auto found = _empty_buffers_by_pos.find(eb.buffer.pos);
+		return found != _empty_buffers_by_pos.end() && found->second.id == eb.id;
+	}
+
 	void GcState::insert_malloced_blocks_buffers(Block &block, GcBuffer& gcbuf,bool isNewBlock) {
 		if (isNewBlock) {
 			std::vector<GcBuffer> bufs;
 			bufs.push_back(gcbuf);
 
 			(*_malloced_blocks_buffers)[block] = bufs;
+			_blocks_by_pos[block.blockpos] = block;
 		}
 		else {
 			(*_malloced_blocks_buffers)[block].push_back(gcbuf);
@@ -127,35 +138,42 @@ namespace vmgc {
 		//find _empty_small_buffers 
 		if (size <= DEFAULT_MAX_SMALL_BUFFER_SIZE) {
 			auto pbuffers = _empty_small_buffers[size/8 - 1];
-			if (!pbuffers->empty()) {  //finded
-				auto& buf = pbuffers->back();
-				b.pos = buf.second.pos;
-				//(*_malloced_gcbuffers)[buf.first] = b;
-				insert_malloced_blocks_buffers(buf.first,b,false);
+			while (!pbuffers->empty()) {  //finded
+				auto buf = pbuffers->back();
 				pbuffers->pop_back();
+				if (!is_live_empty_buffer(buf))
+					continue;  // taken by try_extend_in_place
+				_empty_buffers_by_pos.erase(buf.buffer.pos);
+				b.pos = buf.buffer.pos;
+				//(*_malloced_gcbuffers)[buf.first] = b;
+				insert_malloced_blocks_buffers(buf.block,b,false);
 				return (void*)b.pos;
 			}
 		}
 
 		//find _empty_big_buffers 
-		for (auto it = _empty_big_buffers->begin(); it != _empty_big_buffers->end(); it++) {
-			auto bufsz = it->second.size;
+		for (auto it = _empty_big_buffers->begin(); it != _empty_big_buffers->end(); ) {
+			if (!is_live_empty_buffer(*it)) {
+				it = _empty_big_buffers->erase(it);  // taken by try_extend_in_place
+				continue;
+			}
+			auto bufsz = it->buffer.size;
 			if (ptrdiff_t(size) <= bufsz) {
-				auto bufpos = it->second.pos;
+				auto bufpos = it->buffer.pos;
 				b.pos = bufpos;
-				auto block = it->first;
+				auto block = it->block;
+				_empty_buffers_by_pos.erase(bufpos);
 				if (size < size_t(bufsz)) {
 					auto aferSize = bufsz - size;
 					auto afterPos = bufpos + size;
 					if ((aferSize <= DEFAULT_MAX_SMALL_BUFFER_SIZE) && (size % 8) == 0) {
-						Buffer buf(afterPos, aferSize);
-						std::pair<Block, Buffer>eb(block, buf);
-						_empty_small_buffers[(aferSize / 8) - 1]->push_back(eb);
 						_empty_big_buffers->erase(it);
+						insert_empty_buffer(Buffer(afterPos, aferSize), block);
 					}
 					else {
-						it->second.pos = afterPos;
-						it->second.size = aferSize;
+						it->buffer.pos = afterPos;
+						it->buffer.size = aferSize;
+						_empty_buffers_by_pos.insert(std::make_pair(afterPos, *it));
 					}
 				}
 				else {
@@ -165,7 +183,7 @@ namespace vmgc {
 				insert_malloced_blocks_buffers(block, b, false);
 				return (void*)bufpos;
 			}
-
+			++it;
 		}
 
 			
@@ -202,26 +220,36 @@ namespace vmgc {
 		return (void*)b.pos;
 	}
 
+	std::pair<const Block, std::vector<GcBuffer>>* GcState::find_block_buffers(intptr_t pos) {
+		auto block_it = _blocks_by_pos.upper_bound(pos);
+		if (block_it == _blocks_by_pos.begin())
+			return nullptr;
+		--block_it;
+		const auto& block = block_it->second;
+		if (pos >= block.blockpos + block.blocksize)
+			return nullptr;
+		auto it = _malloced_blocks_buffers->find(block);
+		return it == _malloced_blocks_buffers->end() ? nullptr : &(*it);
+	}
+
 	void GcState::gc_free(void* p) {
 		if (nullptr == p)
 			return;
 		
 		auto pos = (intptr_t)p;
-		for (auto it = _malloced_blocks_buffers->begin(); it != _malloced_blocks_buffers->end(); it++) {
-			auto block_pos = it->first.blockpos;
-			if ((pos >=block_pos) && (pos<(block_pos + it->first.blocksize))) {
-				auto &block_buffers = it->second;
-				for (auto bufit = block_buffers.begin(); bufit != block_buffers.end(); bufit++) {
-					if (pos == bufit->pos) {  //
-
-						Buffer eb(pos, bufit->size);
-						insert_empty_buffer(eb, it->first);
-
-						_used_size -= bufit->size;
-						block_buffers.erase(bufit);
-						return;
-					}
-				}
+		auto it = find_block_buffers(pos);
+		if (!it)
+			return;
+		auto &block_buffers = it->second;
+		for (auto bufit = block_buffers.begin(); bufit != block_buffers.end(); bufit++) {
+			if (pos == bufit->pos) {  //
+
+				Buffer eb(pos, bufit->size);
+				insert_empty_buffer(eb, it->first);
+
+				_used_size -= bufit->size;
+				block_buffers.erase(bufit);
+				return;
 			}
 		}
 	}
@@ -235,6 +263,57 @@ namespace vmgc {
 		}
 	}
 
+	// the item in the empty buffers lists goes stale and is dropped when gc_malloc reaches it
+	bool GcState::take_empty_buffer_at(const Block &block, intptr_t pos, Buffer* out) {
+		auto found = _empty_buffers_by_pos.find(pos);
+		if (found == _empty_buffers_by_pos.end() || found->second.block.blockpos != block.blockpos)
+			return false;
+		*out = found->second.buffer;
+		_empty_buffers_by_pos.erase(found);
+		return true;
+	}
+
+	bool GcState::try_extend_in_place(void* p, size_t newsz) {
+		newsz = align8(newsz);
+		auto pos = (intptr_t)p;
+		auto it = find_block_buffers(pos);
+		if (!it)
+			return false;
+		auto block_pos = it->first.blockpos;
+		auto &block_buffers = it->second;
+		for (auto bufit = block_buffers.begin(); bufit != block_buffers.end(); bufit++) {
+			if (pos != bufit->pos)
+				continue;
+			if (ptrdiff_t(newsz) <= bufit->size)
+				return true;
+			auto extra = ptrdiff_t(newsz) - bufit->size;
+			auto end = pos + bufit->size;
+			if (end + extra > block_pos + it->first.blocksize)
+				return false;
+			// empty buffers are not merged when freed, so collect the adjacent ones one by one
+			std::vector<Buffer> taken;
+			ptrdiff_t taken_size = 0;
+			Buffer eb(0, 0);
+			while (taken_size < extra && take_empty_buffer_at(it->first, end + taken_size, &eb)) {
+				taken.push_back(eb);
+				taken_size += eb.size;
+			}
+			if (taken_size < extra) {
+				for (const auto& b : taken) {
+					insert_empty_buffer(b, it->first);
+				}
+				return false;
+			}
+			if (taken_size > extra) {
+				insert_empty_buffer(Buffer(end + extra, taken_size - extra), it->first);
+			}
+			bufit->size += extra;
+			_used_size += extra;
+			return true;
+		}
+		return false;
+	}
+
 	void* GcState::gc_realloc(void *p, size_t oldsz, size_t newsz) {
 		if ((oldsz < 0) || (newsz < 0)) {
 			throw GcException(std::string("not enough memery in gc , used gc size: ") + std::to_string(_used_size));
@@ -261,6 +340,10 @@ namespace vmgc {
 				//no op
 				return p;
 			}
+			// small buffers are cheap to copy, not worth searching the empty buffers
+			if (newsz > DEFAULT_MAX_SMALL_BUFFER_SIZE && try_extend_in_place(p, newsz)) {
+				return p;
+			}
 			newp = gc_malloc(newsz);
 			if (newp == nullptr)return nullptr;
 			//copy data
@@ -293,6 +376,11 @@ namespace vmgc {
 			if (newsize < GC_MINSIZEARRAY)
 				newsize = GC_MINSIZEARRAY;  // minimum size 
 		}
+		if (p && (*size) > 0 && newsize * element_size > DEFAULT_MAX_SMALL_BUFFER_SIZE
+			&& try_extend_in_place(p, newsize * element_size)) {
+			*size = newsize;
+			return p;
+		}
 		auto new_p = gc_malloc_vector(newsize, element_size);
 		if (!new_p) {
 			return nullptr;
@@ -92,4 +92,77 @@ BOOST_AUTO_TEST_CASE(gc_grow_vector)
 	state.gc_free_array(p4, count4, sizeof(GcString));
 }
 
+BOOST_AUTO_TEST_CASE(gc_grow_in_place)
+{
+	GcState state;
+	size_t count = 32;
+	auto p1 = (int64_t*)state.gc_malloc_vector(count, sizeof(int64_t));
+	for (size_t i = 0; i < count; i++) {
+		p1[i] = i;
+	}
+	auto used = state.usedsize();
+	// the rest of the block is empty, so the vector grows into it
+	auto p2 = (int64_t*)state.gc_grow_vector(p1, count, &count, sizeof(int64_t), INT32_MAX);
+	BOOST_CHECK(p2 == p1);
+	BOOST_CHECK(count == 64);
+	BOOST_CHECK(state.usedsize() == used + 32 * ptrdiff_t(sizeof(int64_t)));
+	BOOST_CHECK(p2[31] == 31);
+	// and is freed as one buffer
+	state.gc_free(p2);
+	BOOST_CHECK(state.usedsize() == 0);
+
+	auto p3 = (char*)state.gc_realloc(nullptr, 0, 256);
+	memset(p3, 'x', 256);
+	auto p4 = (char*)state.gc_realloc(p3, 256, 1024);
+	BOOST_CHECK(p4 == p3);
+	BOOST_CHECK(p4[255] == 'x');
+	BOOST_CHECK(state.usedsize() == 1024);
+}
+
+BOOST_AUTO_TEST_CASE(gc_grow_copy_fallback)
+{
+	GcState state;
+	auto a = (char*)state.gc_malloc(256);
+	auto b = (char*)state.gc_malloc(256);
+	BOOST_CHECK(b == a + 256);
+	memset(a, 'x', 256);
+	// the buffer right after is in use, so the data is copied
+	auto a2 = (char*)state.gc_realloc(a, 256, 512);
+	BOOST_CHECK(a2 != a);
+	BOOST_CHECK(a2[0] == 'x' && a2[255] == 'x');
+	BOOST_CHECK(state.usedsize() == 512 + 256);
+
+	// an empty buffer taken by growing in place is not given out again
+	auto c = (char*)state.gc_malloc(256);
+	auto x = (char*)state.gc_malloc(64);
+	auto y = (char*)state.gc_malloc(256);
+	BOOST_CHECK(x == c + 256);
+	BOOST_CHECK(y == x + 64);
+	state.gc_free(x);
+	auto c2 = (char*)state.gc_realloc(c, 256, 320);
+	BOOST_CHECK(c2 == c);
+	auto z = (char*)state.gc_malloc(64);
+	BOOST_CHECK(z != x);
+	BOOST_CHECK(z >= y + 256);
+}
+
+BOOST_AUTO_TEST_CASE(gc_buffbox_reuse)
+{
+	GcState state;
+	// a finished luaL_Buffer box is freed through the allocator, the next box of its size reuses the storage
+	auto box = state.gc_realloc(nullptr, 0, 64);
+	state.gc_realloc(box, 64, 0);
+	auto box2 = state.gc_realloc(nullptr, 0, 64);
+	BOOST_CHECK(box2 == box);
+
+	// a box growing past its stack buffer keeps its storage, and is freed at its grown size
+	auto used = state.usedsize();
+	auto big = (char*)state.gc_realloc(nullptr, 0, 256);
+	auto big2 = (char*)state.gc_realloc(big, 256, 512);
+	BOOST_CHECK(big2 == big);
+	BOOST_CHECK(state.usedsize() == used + 512);
+	state.gc_realloc(big2, 512, 0);
+	BOOST_CHECK(state.usedsize() == used);
+}
+
 BOOST_AUTO_TEST_SUITE_END()